@@ -0,0 +1,141 @@
+#include <hashbrown.hpp>
+#include <thread_local_aggregator.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// Word counting, the group-by the aggregator is for: every thread counts its
+// share of a skewed stream of words, once into a single locked map and once
+// into a ThreadLocalAggregator, at every thread count up to the hardware's.
+// The aggregator's time includes its merge, which is also shown on its own.
+//
+//    bench_aggregate [words] [vocabulary]
+namespace
+{
+   // Keeps the counts observable so the optimiser cannot drop them.
+   std::uint64_t sink = 0;
+
+   // The splitmix64 finaliser: distinct indices give distinct random keys.
+   std::uint64_t mix(std::uint64_t x)
+   {
+      x ^= x >> 30;
+      x *= 0xBF58476D1CE4E5B9ull;
+      x ^= x >> 27;
+      x *= 0x94D049BB133111EBull;
+      x ^= x >> 31;
+      return x;
+   }
+
+   template <typename F>
+   double seconds(F&& f)
+   {
+      const auto start = std::chrono::steady_clock::now();
+      f();
+      const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+      return elapsed.count();
+   }
+
+   // Runs count(thread, first, last) over an equal share of words per thread.
+   template <typename Count>
+   void split(std::size_t threads, const std::vector<std::string_view>& words, const Count& count)
+   {
+      std::vector<std::jthread> workers;
+      for (std::size_t t = 0; t < threads; ++t)
+      {
+         workers.emplace_back([&, t] {
+            count(t, words.size() * t / threads, words.size() * (t + 1) / threads);
+         });
+      }
+   }
+
+   // A baseline of 0 leaves the speedup out.
+   void print(const char* counter, std::size_t threads, double time, double baseline)
+   {
+      std::cout << std::left << std::setw(14) << counter << std::setw(10) << threads << std::fixed << std::setprecision(3)
+                << std::setw(12) << time;
+      if (baseline > 0)
+      {
+         std::cout << std::setw(10) << baseline / time;
+      }
+      std::cout << '\n';
+   }
+}
+
+int main(int argc, char** argv)
+{
+   const std::size_t count = argc > 1 ? static_cast<std::size_t>(std::strtod(argv[1], nullptr)) : std::size_t{1} << 25;
+   const std::size_t vocabulary = argc > 2 ? static_cast<std::size_t>(std::strtod(argv[2], nullptr)) : std::size_t{1} << 20;
+
+   // Squaring a uniform draw skews it towards the first words, so a few are
+   // very common and most are rare, as in text.
+   std::vector<std::string> dictionary(vocabulary);
+   for (std::size_t i = 0; i < vocabulary; ++i)
+   {
+      dictionary[i] = "w" + std::to_string(mix(i) % 1000000007);
+   }
+   std::vector<std::string_view> words(count);
+   for (std::size_t i = 0; i < count; ++i)
+   {
+      const auto draw = static_cast<double>(mix(i + vocabulary) >> 11) / static_cast<double>(std::uint64_t{1} << 53);
+      words[i] = dictionary[static_cast<std::size_t>(draw * draw * static_cast<double>(vocabulary))];
+   }
+
+   std::cout << std::left << std::setw(14) << "counter" << std::setw(10) << "threads" << std::setw(12) << "seconds"
+             << std::setw(10) << "speedup" << '\n';
+
+   double baseline = 0;
+   const auto hardware = std::max(1u, std::thread::hardware_concurrency());
+   for (std::size_t threads = 1; threads <= hardware; threads *= 2)
+   {
+      const auto locked = seconds([&] {
+         std::mutex mutex;
+         HashBrown<std::string, std::uint64_t> counts;
+         split(threads, words, [&](std::size_t, std::size_t first, std::size_t last) {
+            for (auto i = first; i < last; ++i)
+            {
+               const std::lock_guard lock{mutex};
+               if (auto stored = const_cast<std::uint64_t*>(counts.get(words[i])))
+               {
+                  ++*stored;
+               }
+               else
+               {
+                  counts.insert(std::string(words[i]), 1);
+               }
+            }
+         });
+         sink += counts.size();
+      });
+      baseline = threads == 1 ? locked : baseline;
+      print("locked", threads, locked, baseline);
+
+      double merge = 0;
+      const auto local = seconds([&] {
+         ThreadLocalAggregator<std::string, std::uint64_t> counts(threads);
+         split(threads, words, [&](std::size_t thread, std::size_t first, std::size_t last) {
+            auto& mine = counts.local(thread);
+            for (auto i = first; i < last; ++i)
+            {
+               mine.add(words[i], 1);
+            }
+         });
+         merge = seconds([&] {
+            sink += counts.merge(hashbrown::Parallel{threads}).size();
+         });
+      });
+      print("thread-local", threads, local, baseline);
+      print("  merge", threads, merge, 0);
+   }
+
+   return sink == 0;
+}
@@ -0,0 +1,98 @@
+#include <hashbrown.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+namespace
+{
+   constexpr std::size_t rounds = 2000;
+
+   // Keeps the built maps observable so the optimiser cannot drop them.
+   std::size_t sink = 0;
+
+   template <typename Build>
+   double time_per_round(Build&& build)
+   {
+      const auto start = std::chrono::steady_clock::now();
+      for (std::size_t round = 0; round < rounds; ++round)
+      {
+         build(round);
+      }
+      const std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+      return elapsed.count() / static_cast<double>(rounds);
+   }
+
+   template <typename Map>
+   void fill(Map& map, std::size_t entries, std::size_t round)
+   {
+      for (std::size_t i = 0; i < entries; ++i)
+      {
+         map.insert(static_cast<std::uint64_t>(i * 2654435761u + round), i);
+      }
+      sink += map.size();
+   }
+
+   template <typename Map>
+   void fill_strings(Map& map, std::size_t entries, std::size_t round)
+   {
+      for (std::size_t i = 0; i < entries; ++i)
+      {
+         map.insert(typename Map::value_type::first_type("request-header-" + std::to_string(i + round), map.get_allocator()), i);
+      }
+      sink += map.size();
+   }
+}
+
+int main()
+{
+   // One arena buffer, reused across rounds: building a request-scoped map
+   // is then just pointer bumps and throwing it away is release().
+   std::vector<std::byte> buffer(8 << 20);
+
+   std::cout << std::left << std::setw(28) << "workload" << std::setw(16) << "heap us/build"
+             << std::setw(18) << "arena us/build" << '\n';
+
+   for (const std::size_t entries : {16, 256, 4096})
+   {
+      const auto heap = time_per_round([entries](std::size_t round) {
+         HashBrown<std::uint64_t, std::size_t> map;
+         fill(map, entries, round);
+      });
+
+      const auto arena = time_per_round([entries, &buffer](std::size_t round) {
+         std::pmr::monotonic_buffer_resource resource{buffer.data(), buffer.size()};
+         hashbrown::pmr::HashBrown<std::uint64_t, std::size_t> map{&resource};
+         fill(map, entries, round);
+      });
+
+      std::cout << std::left << std::setw(28) << ("u64 keys x " + std::to_string(entries))
+                << std::setw(16) << std::fixed << std::setprecision(2) << heap
+                << std::setw(18) << arena << '\n';
+   }
+
+   for (const std::size_t entries : {16, 256, 4096})
+   {
+      const auto heap = time_per_round([entries](std::size_t round) {
+         HashBrown<std::string, std::size_t> map;
+         fill_strings(map, entries, round);
+      });
+
+      const auto arena = time_per_round([entries, &buffer](std::size_t round) {
+         std::pmr::monotonic_buffer_resource resource{buffer.data(), buffer.size()};
+         hashbrown::pmr::HashBrown<std::pmr::string, std::size_t> map{&resource};
+         fill_strings(map, entries, round);
+      });
+
+      std::cout << std::left << std::setw(28) << ("string keys x " + std::to_string(entries))
+                << std::setw(16) << std::fixed << std::setprecision(2) << heap
+                << std::setw(18) << arena << '\n';
+   }
+
+   return sink == 0;
+}
@@ -0,0 +1,110 @@
+#include <hashbrown.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <span>
+#include <vector>
+
+namespace
+{
+   constexpr std::size_t block_size = 1024;
+   constexpr std::size_t probes = 1 << 22;
+
+   // Keeps the lookups observable so the optimiser cannot drop them. Only
+   // the pointers are summed: a branch on hit or miss would cost the
+   // batched loop mispredictions that the single lookups hide.
+   std::uint64_t sink = 0;
+
+   std::uint64_t next_random(std::uint64_t& state)
+   {
+      state ^= state << 13;
+      state ^= state >> 7;
+      state ^= state << 17;
+      return state;
+   }
+
+   // A multiplicative mix, so that random probes land on random groups
+   // instead of walking the table in key order.
+   struct MixHash
+   {
+      std::size_t operator()(std::uint64_t key) const
+      {
+         key ^= key >> 33;
+         key *= 0xFF51AFD7ED558CCDull;
+         key ^= key >> 33;
+         return static_cast<std::size_t>(key);
+      }
+   };
+
+   using Map = HashBrown<std::uint64_t, std::uint64_t, MixHash>;
+
+   // Best of a few runs, to filter out noise from other processes.
+   template <typename Probe>
+   double mlookups_per_second(const std::vector<std::uint64_t>& keys, Probe&& probe)
+   {
+      double best = 0.0;
+      for (int run = 0; run < 3; ++run)
+      {
+         const auto start = std::chrono::steady_clock::now();
+         for (std::size_t base = 0; base < keys.size(); base += block_size)
+         {
+            probe(&keys[base]);
+         }
+         const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+         best = std::max(best, static_cast<double>(keys.size()) / elapsed.count() / 1e6);
+      }
+      return best;
+   }
+}
+
+int main()
+{
+   std::cout << std::left << std::setw(12) << "entries" << std::setw(12) << "table MiB"
+             << std::setw(16) << "get() Ml/s" << std::setw(18) << "get_many() Ml/s" << '\n';
+
+   for (std::size_t entries = 1 << 14; entries <= (1 << 24); entries <<= 2)
+   {
+      Map map;
+      map.reserve(entries);
+      for (std::uint64_t key = 0; key < entries; ++key)
+      {
+         map.insert(key * 2, key);
+      }
+
+      // Half the probes hit, the other half miss on odd keys.
+      std::vector<std::uint64_t> keys(probes);
+      std::uint64_t state = 0x9E3779B97F4A7C15ull;
+      for (auto& key : keys)
+      {
+         key = next_random(state) % (2 * entries);
+      }
+
+      const auto single = mlookups_per_second(keys, [&map](const std::uint64_t* block) {
+         for (std::size_t i = 0; i < block_size; ++i)
+         {
+            sink += reinterpret_cast<std::uintptr_t>(map.get(block[i]));
+         }
+      });
+
+      std::vector<const std::uint64_t*> out(block_size);
+      const auto batched = mlookups_per_second(keys, [&map, &out](const std::uint64_t* block) {
+         map.get_many(std::span{block, block_size}, out);
+         for (const auto value : out)
+         {
+            sink += reinterpret_cast<std::uintptr_t>(value);
+         }
+      });
+
+      const auto bytes = map.capacity() * (sizeof(Map::value_type) + 1);
+      std::cout << std::left << std::setw(12) << entries
+                << std::setw(12) << std::fixed << std::setprecision(1) << static_cast<double>(bytes) / (1 << 20)
+                << std::setw(16) << std::setprecision(2) << single
+                << std::setw(18) << batched << '\n';
+   }
+
+   return sink == 0;
+}
@@ -0,0 +1,95 @@
+#include <hashbrown.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Bulk construction of a HashBrown from a vector of entries: the serial
+// range insert against the parallel one at every thread count up to the
+// hardware's.
+//
+//    bench_build [entries]
+namespace
+{
+   // Keeps the maps observable so the optimiser cannot drop them.
+   std::uint64_t sink = 0;
+
+   // The splitmix64 finaliser: distinct indices give distinct random keys.
+   std::uint64_t mix(std::uint64_t x)
+   {
+      x ^= x >> 30;
+      x *= 0xBF58476D1CE4E5B9ull;
+      x ^= x >> 27;
+      x *= 0x94D049BB133111EBull;
+      x ^= x >> 31;
+      return x;
+   }
+
+   template <typename F>
+   double seconds(F&& f)
+   {
+      const auto start = std::chrono::steady_clock::now();
+      f();
+      const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+      return elapsed.count();
+   }
+
+   template <typename Key>
+   void run(const char* name, const std::vector<std::pair<Key, std::uint64_t>>& entries)
+   {
+      using Map = HashBrown<Key, std::uint64_t>;
+
+      const auto serial = seconds([&] {
+         Map map;
+         map.insert(entries.begin(), entries.end());
+         sink += map.size();
+      });
+      std::cout << std::left << std::setw(8) << name << std::setw(10) << "serial" << std::fixed << std::setprecision(3)
+                << std::setw(12) << serial << std::setw(10) << 1.0 << '\n';
+
+      const auto hardware = std::max(1u, std::thread::hardware_concurrency());
+      for (std::size_t threads = 1; threads <= hardware; threads *= 2)
+      {
+         const auto parallel = seconds([&] {
+            Map map;
+            map.insert(hashbrown::Parallel{threads}, entries.begin(), entries.end());
+            sink += map.size();
+         });
+         std::cout << std::left << std::setw(8) << name << std::setw(10) << threads
+                   << std::setw(12) << parallel << std::setw(10) << serial / parallel << '\n';
+      }
+   }
+}
+
+int main(int argc, char** argv)
+{
+   const std::size_t entries = argc > 1 ? static_cast<std::size_t>(std::strtod(argv[1], nullptr)) : std::size_t{1} << 24;
+
+   std::cout << std::left << std::setw(8) << "key" << std::setw(10) << "threads" << std::setw(12) << "seconds"
+             << std::setw(10) << "speedup" << '\n';
+
+   std::vector<std::pair<std::uint64_t, std::uint64_t>> numbers(entries);
+   for (std::size_t i = 0; i < entries; ++i)
+   {
+      numbers[i] = {mix(i), i};
+   }
+   run("u64", numbers);
+   numbers = {};
+
+   std::vector<std::pair<std::string, std::uint64_t>> strings(entries / 4);
+   for (std::size_t i = 0; i < strings.size(); ++i)
+   {
+      strings[i] = {"key:" + std::to_string(mix(i)), i};
+   }
+   run("string", strings);
+
+   return sink == 0;
+}
@@ -0,0 +1,134 @@
+#include <concurrent_hashbrown.hpp>
+#include <hashbrown.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace
+{
+   constexpr std::uint64_t key_space = 1 << 20;
+   constexpr std::size_t ops_per_thread = 1'000'000;
+
+   // Keeps the lookups observable so the optimiser cannot drop them.
+   std::atomic<std::size_t> sink{0};
+
+   struct Mix
+   {
+      const char* name;
+      unsigned write_percent;
+   };
+
+   std::uint64_t next_random(std::uint64_t& state)
+   {
+      state ^= state << 13;
+      state ^= state >> 7;
+      state ^= state << 17;
+      return state;
+   }
+
+   // The baseline we are replacing: one HashBrown behind one mutex.
+   class GlobalLockMap
+   {
+      public:
+         void insert(std::uint64_t key, std::uint64_t value)
+         {
+            std::lock_guard lock{_mutex};
+            _map.insert(key, value);
+         }
+
+         bool contains(std::uint64_t key) const
+         {
+            std::lock_guard lock{_mutex};
+            return _map.contains(key);
+         }
+
+      private:
+         mutable std::mutex _mutex;
+         HashBrown<std::uint64_t, std::uint64_t> _map;
+   };
+
+   template <typename Map>
+   double run(Map& map, unsigned threads, const Mix& mix)
+   {
+      std::vector<std::thread> workers;
+      const auto start = std::chrono::steady_clock::now();
+
+      for (unsigned t = 0; t < threads; ++t)
+      {
+         workers.emplace_back([&map, &mix, t] {
+            std::uint64_t state = 0x9E3779B97F4A7C15ull * (t + 1);
+            std::size_t hits = 0;
+            for (std::size_t i = 0; i < ops_per_thread; ++i)
+            {
+               const auto r = next_random(state);
+               const auto key = r % key_space;
+               if ((r >> 40) % 100 < mix.write_percent)
+               {
+                  map.insert(key, r);
+               }
+               else
+               {
+                  hits += map.contains(key);
+               }
+            }
+            sink.fetch_add(hits, std::memory_order_relaxed);
+         });
+      }
+      for (auto& worker : workers)
+      {
+         worker.join();
+      }
+
+      const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+      return static_cast<double>(threads * ops_per_thread) / elapsed.count() / 1e6;
+   }
+
+   template <typename Map>
+   void prefill(Map& map)
+   {
+      for (std::uint64_t key = 0; key < key_space; key += 2)
+      {
+         map.insert(key, key);
+      }
+   }
+}
+
+int main(int argc, char** argv)
+{
+   const unsigned max_threads = argc > 1
+      ? static_cast<unsigned>(std::strtoul(argv[1], nullptr, 10))
+      : std::max(1u, std::thread::hardware_concurrency());
+
+   const Mix mixes[] = {
+      {"read-heavy (95/5)", 5},
+      {"write-heavy (50/50)", 50},
+   };
+
+   std::cout << std::left << std::setw(22) << "mix" << std::setw(9) << "threads"
+             << std::setw(16) << "global Mops/s" << std::setw(16) << "sharded Mops/s" << '\n';
+
+   for (const auto& mix : mixes)
+   {
+      for (unsigned threads = 1; threads <= max_threads; threads *= 2)
+      {
+         GlobalLockMap global;
+         ConcurrentHashBrown<std::uint64_t, std::uint64_t> sharded;
+         prefill(global);
+         prefill(sharded);
+
+         const auto global_rate = run(global, threads, mix);
+         const auto sharded_rate = run(sharded, threads, mix);
+
+         std::cout << std::left << std::setw(22) << mix.name << std::setw(9) << threads
+                   << std::setw(16) << std::fixed << std::setprecision(2) << global_rate
+                   << std::setw(16) << sharded_rate << '\n';
+      }
+   }
+}
@@ -0,0 +1,124 @@
+#include <frozen_hashbrown.hpp>
+#include <hashbrown.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace
+{
+   constexpr std::size_t probes = 1 << 22;
+
+   // Keeps the lookups observable so the optimiser cannot drop them.
+   std::uint64_t sink = 0;
+
+   struct Config
+   {
+      std::uint64_t limit;
+      std::uint64_t timeout_ms;
+      std::string owner;
+   };
+
+   using Map = HashBrown<std::string, Config>;
+   using Frozen = decltype(std::declval<Map>().freeze());
+
+   std::uint64_t next_random(std::uint64_t& state)
+   {
+      state ^= state << 13;
+      state ^= state >> 7;
+      state ^= state << 17;
+      return state;
+   }
+
+   template <typename F>
+   double seconds(F&& f)
+   {
+      const auto start = std::chrono::steady_clock::now();
+      f();
+      const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+      return elapsed.count();
+   }
+
+   // Best of a few runs, to filter out noise from other processes.
+   template <typename Table>
+   double mlookups_per_second(const Table& table, const std::vector<std::string>& keys)
+   {
+      double best = 0.0;
+      for (int run = 0; run < 3; ++run)
+      {
+         const auto elapsed = seconds([&] {
+            for (const auto& key : keys)
+            {
+               sink += reinterpret_cast<std::uintptr_t>(table.get(key));
+            }
+         });
+         best = std::max(best, static_cast<double>(keys.size()) / elapsed / 1e6);
+      }
+      return best;
+   }
+}
+
+int main()
+{
+   std::cout << std::left << std::setw(10) << "entries" << std::setw(14) << "insert ms"
+             << std::setw(14) << "freeze ms" << std::setw(14) << "map Ml/s"
+             << std::setw(14) << "frozen Ml/s" << std::setw(16) << "map index b/key"
+             << std::setw(18) << "frozen index b/key" << '\n';
+
+   for (std::size_t entries = 1 << 12; entries <= (1 << 22); entries <<= 2)
+   {
+      std::vector<std::string> names(entries);
+      for (std::size_t i = 0; i < entries; ++i)
+      {
+         names[i] = "service/" + std::to_string(i * 7919) + "/settings";
+      }
+
+      // Every probe hits, the way a request path reads its configuration.
+      std::vector<std::string> keys(probes);
+      std::uint64_t state = 0x9E3779B97F4A7C15ull;
+      for (auto& key : keys)
+      {
+         key = names[next_random(state) % entries];
+      }
+
+      Map map;
+      const auto insert_seconds = seconds([&] {
+         for (std::size_t i = 0; i < entries; ++i)
+         {
+            map.insert(names[i], Config{i, 100, "team"});
+         }
+      });
+      const auto mutable_speed = mlookups_per_second(map, keys);
+
+      // Everything but the entries themselves: a control byte and a stored
+      // hash per slot, and the slots left empty.
+      const auto slot_bits = 8 + (Map::stored_hash ? 64 : 0) + 8 * sizeof(Map::value_type);
+      const auto map_bits = static_cast<double>(map.capacity() * slot_bits) / static_cast<double>(entries)
+                          - 8.0 * sizeof(Map::value_type);
+
+      std::optional<Frozen> frozen;
+      const auto freeze_seconds = seconds([&] {
+         frozen.emplace(std::move(map).freeze());
+      });
+      const auto frozen_speed = mlookups_per_second(*frozen, keys);
+
+      const auto frozen_bits = static_cast<double>(hashbrown::detail::perfect_buckets(entries) * 16
+                                                   + hashbrown::detail::perfect_spill(entries) * 64)
+                             / static_cast<double>(entries);
+
+      std::cout << std::left << std::setw(10) << entries << std::fixed << std::setprecision(2)
+                << std::setw(14) << insert_seconds * 1e3
+                << std::setw(14) << freeze_seconds * 1e3
+                << std::setw(14) << mutable_speed << std::setw(14) << frozen_speed
+                << std::setw(16) << map_bits << std::setw(18) << frozen_bits << '\n';
+   }
+
+   return sink == 0;
+}
@@ -0,0 +1,146 @@
+#include <hashbrown.hpp>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace
+{
+   constexpr std::size_t key_count = 1 << 18;
+
+   // Keeps the hashes observable so the optimiser cannot drop them.
+   std::uint64_t sink = 0;
+
+   // What HashFunction used to be: std::hash, the identity for integers.
+   struct StdHash
+   {
+      template <typename T>
+      std::size_t operator()(const T& t) const
+      {
+         return std::hash<T>{}(t);
+      }
+   };
+
+   struct Quality
+   {
+      double mean_probe;
+      std::size_t max_probe;
+   };
+
+   // Replays the inserts of a Swiss table sized for the keys and counts the
+   // groups each one has to look at before finding a free slot.
+   template <typename Hash, typename Key>
+   Quality probe_lengths(const Hash& hash, const std::vector<Key>& keys)
+   {
+      const auto capacity = hashbrown::detail::capacity_for(keys.size(), hashbrown::detail::default_max_load_factor);
+      const auto groups = capacity / hashbrown::detail::Group::width;
+      std::vector<std::uint8_t> used(groups);
+
+      std::size_t total = 0;
+      std::size_t longest = 0;
+      for (const auto& key : keys)
+      {
+         hashbrown::detail::ProbeSeq seq{hash(key), groups - 1};
+         std::size_t probes = 1;
+         while (used[seq.offset() / hashbrown::detail::Group::width] == hashbrown::detail::Group::width)
+         {
+            seq.next();
+            ++probes;
+         }
+         ++used[seq.offset() / hashbrown::detail::Group::width];
+         total += probes;
+         longest = std::max(longest, probes);
+      }
+      return Quality{static_cast<double>(total) / static_cast<double>(keys.size()), longest};
+   }
+
+   template <typename Hash, typename Key>
+   double ns_per_hash(const Hash& hash, const std::vector<Key>& keys)
+   {
+      double best = 1e30;
+      for (int run = 0; run < 5; ++run)
+      {
+         const auto start = std::chrono::steady_clock::now();
+         for (const auto& key : keys)
+         {
+            sink += hash(key);
+         }
+         const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+         best = std::min(best, elapsed.count() / static_cast<double>(keys.size()));
+      }
+      return best;
+   }
+
+   template <typename Key>
+   void report(const char* name, const std::vector<Key>& keys)
+   {
+      const StdHash std_hash;
+      const HashFunction<Key> default_hash;
+      const HashFunction<Key> seeded_hash{hashbrown::random_seed()};
+
+      const std::pair<const char*, Quality> rows[] = {
+         {"std::hash", probe_lengths(std_hash, keys)},
+         {"HashFunction", probe_lengths(default_hash, keys)},
+         {"HashFunction seeded", probe_lengths(seeded_hash, keys)},
+      };
+      const double speeds[] = {
+         ns_per_hash(std_hash, keys),
+         ns_per_hash(default_hash, keys),
+         ns_per_hash(seeded_hash, keys),
+      };
+
+      for (std::size_t i = 0; i < std::size(rows); ++i)
+      {
+         std::cout << std::left << std::setw(20) << name << std::setw(22) << rows[i].first
+                   << std::setw(12) << std::fixed << std::setprecision(2) << speeds[i]
+                   << std::setw(12) << rows[i].second.mean_probe
+                   << std::setw(10) << rows[i].second.max_probe << '\n';
+      }
+   }
+}
+
+int main()
+{
+   std::cout << std::left << std::setw(20) << "keys" << std::setw(22) << "hash"
+             << std::setw(12) << "ns/hash" << std::setw(12) << "mean probe"
+             << std::setw(10) << "max probe" << '\n';
+
+   std::vector<std::uint64_t> sequential(key_count);
+   std::vector<std::uint64_t> strided(key_count);
+   for (std::size_t i = 0; i < key_count; ++i)
+   {
+      sequential[i] = i;
+      strided[i] = i * 1024;
+   }
+   report("sequential ints", sequential);
+   report("multiples of 1024", strided);
+
+   // Addresses of small heap objects share their low bits.
+   std::vector<std::unique_ptr<std::array<char, 48>>> objects;
+   std::vector<std::uintptr_t> pointers;
+   for (std::size_t i = 0; i < key_count; ++i)
+   {
+      objects.push_back(std::make_unique<std::array<char, 48>>());
+      pointers.push_back(reinterpret_cast<std::uintptr_t>(objects.back().get()));
+   }
+   report("heap pointers", pointers);
+
+   std::vector<std::string> ids;
+   std::vector<std::string> urls;
+   for (std::size_t i = 0; i < key_count; ++i)
+   {
+      ids.push_back("user:" + std::to_string(i));
+      urls.push_back("https://example.com/api/v2/accounts/" + std::to_string(i * 7919) + "/sessions?expand=profile");
+   }
+   report("short strings", ids);
+   report("urls", urls);
+
+   return sink == 0;
+}
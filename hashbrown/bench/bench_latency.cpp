@@ -0,0 +1,106 @@
+#include <cuckoo_hashbrown.hpp>
+#include <hashbrown.hpp>
+#include <robin_hood_hashbrown.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Lookup tail latency of each storage policy. Every lookup is timed on its
+// own, so the percentiles include the clock's cost; the timer row gives
+// that cost for an empty interval.
+namespace
+{
+   constexpr std::size_t probes = 1 << 20;
+
+   // Keeps the lookups observable so the optimiser cannot drop them.
+   std::uint64_t sink = 0;
+
+   // The splitmix64 finaliser: distinct indices give distinct random keys.
+   std::uint64_t mix(std::uint64_t x)
+   {
+      x ^= x >> 30;
+      x *= 0xBF58476D1CE4E5B9ull;
+      x ^= x >> 27;
+      x *= 0x94D049BB133111EBull;
+      x ^= x >> 31;
+      return x;
+   }
+
+   void print(std::string_view name, std::string_view kind, std::size_t entries, std::vector<double>& ns)
+   {
+      std::sort(ns.begin(), ns.end());
+      const auto at = [&](double fraction) {
+         return ns[static_cast<std::size_t>(fraction * static_cast<double>(ns.size() - 1))];
+      };
+
+      std::cout << std::left << std::setw(20) << name << std::setw(8) << kind << std::setw(10) << entries
+                << std::fixed << std::setprecision(0)
+                << std::setw(10) << at(0.5) << std::setw(10) << at(0.99)
+                << std::setw(10) << at(0.999) << std::setw(10) << at(0.9999) << ns.back() << '\n';
+   }
+
+   template <typename Map>
+   void measure(std::string_view name, std::size_t entries, const std::vector<std::uint64_t>& keys)
+   {
+      Map map;
+      for (std::size_t i = 0; i < entries; ++i)
+      {
+         map.insert(keys[i], i);
+      }
+
+      std::vector<double> ns(probes);
+      for (const auto hit : {true, false})
+      {
+         std::uint64_t state = 0x9E3779B97F4A7C15ull;
+         for (auto& sample : ns)
+         {
+            state = mix(state);
+            // Hits probe the inserted keys, misses the ones after them.
+            const auto key = keys[state % entries + (hit ? 0 : entries)];
+            const auto start = std::chrono::steady_clock::now();
+            sink += reinterpret_cast<std::uintptr_t>(map.get(key));
+            const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+            sample = elapsed.count();
+         }
+         print(name, hit ? "hit" : "miss", entries, ns);
+      }
+   }
+}
+
+int main()
+{
+   std::cout << std::left << std::setw(20) << "container" << std::setw(8) << "probe" << std::setw(10) << "entries"
+             << std::setw(10) << "p50 ns" << std::setw(10) << "p99" << std::setw(10) << "p99.9"
+             << std::setw(10) << "p99.99" << "max" << '\n';
+
+   std::vector<double> ns(probes);
+   for (auto& sample : ns)
+   {
+      const auto start = std::chrono::steady_clock::now();
+      const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+      sample = elapsed.count();
+   }
+   print("timer", "-", 0, ns);
+
+   for (std::size_t entries = 1 << 12; entries <= (1 << 22); entries <<= 2)
+   {
+      std::vector<std::uint64_t> keys(2 * entries);
+      for (std::size_t i = 0; i < keys.size(); ++i)
+      {
+         keys[i] = mix(i);
+      }
+
+      measure<HashBrown<std::uint64_t, std::uint64_t>>("HashBrown", entries, keys);
+      measure<RobinHoodHashBrown<std::uint64_t, std::uint64_t>>("RobinHoodHashBrown", entries, keys);
+      measure<CuckooHashBrown<std::uint64_t, std::uint64_t>>("CuckooHashBrown", entries, keys);
+   }
+
+   return sink == 0;
+}
@@ -0,0 +1,94 @@
+#include <hashbrown.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+
+// A full scan of a large HashBrown, as an exporter walking every counter
+// does: the begin()/end() loop against the parallel for_each and
+// transform_reduce at every thread count up to the hardware's.
+//
+//    bench_scan [entries]
+namespace
+{
+   // Keeps the scans observable so the optimiser cannot drop them.
+   std::uint64_t sink = 0;
+
+   // The splitmix64 finaliser: distinct indices give distinct random keys.
+   std::uint64_t mix(std::uint64_t x)
+   {
+      x ^= x >> 30;
+      x *= 0xBF58476D1CE4E5B9ull;
+      x ^= x >> 27;
+      x *= 0x94D049BB133111EBull;
+      x ^= x >> 31;
+      return x;
+   }
+
+   template <typename F>
+   double seconds(F&& f)
+   {
+      const auto start = std::chrono::steady_clock::now();
+      f();
+      const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+      return elapsed.count();
+   }
+
+   void print(const char* scan, const char* threads, double time, double serial)
+   {
+      std::cout << std::left << std::setw(18) << scan << std::setw(10) << threads << std::fixed << std::setprecision(3)
+                << std::setw(12) << time << std::setw(10) << serial / time << '\n';
+   }
+}
+
+int main(int argc, char** argv)
+{
+   const std::size_t entries = argc > 1 ? static_cast<std::size_t>(std::strtod(argv[1], nullptr)) : std::size_t{1} << 25;
+
+   HashBrown<std::uint64_t, std::uint64_t> map;
+   map.reserve(entries);
+   for (std::size_t i = 0; i < entries; ++i)
+   {
+      map.insert(mix(i), i);
+   }
+
+   std::cout << std::left << std::setw(18) << "scan" << std::setw(10) << "threads" << std::setw(12) << "seconds"
+             << std::setw(10) << "speedup" << '\n';
+
+   const auto serial = seconds([&] {
+      std::uint64_t sum = 0;
+      for (const auto& [key, value] : map)
+      {
+         sum += value;
+      }
+      sink += sum;
+   });
+   print("iterator", "-", serial, serial);
+
+   const auto hardware = std::max(1u, std::thread::hardware_concurrency());
+   for (std::size_t threads = 1; threads <= hardware; threads *= 2)
+   {
+      const auto label = std::to_string(threads);
+
+      const auto each = seconds([&] {
+         map.for_each(hashbrown::Parallel{threads}, [](auto& entry) { ++entry.second; });
+         sink += map.begin()->second;
+      });
+      print("for_each", label.c_str(), each, serial);
+
+      const auto reduce = seconds([&] {
+         sink += map.transform_reduce(hashbrown::Parallel{threads}, std::uint64_t{0}, std::plus<>(),
+                                      [](const auto& entry) { return entry.second; });
+      });
+      print("transform_reduce", label.c_str(), reduce, serial);
+   }
+
+   return sink == 0;
+}
@@ -0,0 +1,360 @@
+#include <dense_hashbrown.hpp>
+#include <hashbrown.hpp>
+#include <robin_hood_hashbrown.hpp>
+
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Standard workloads over HashBrown, DenseHashBrown, RobinHoodHashBrown and
+// std::unordered_map, so releases can be compared before they are deployed.
+//
+//    bench [--min-size N] [--max-size N] [--json PATH]
+//
+// Sizes run in powers of ten from 1e2 to 1e8 by default. Every workload
+// reports ns/op; every build also reports the bytes per entry the container
+// holds from its allocator and how many allocations it made.
+namespace
+{
+   // Small workloads are repeated until they add up to this many operations.
+   constexpr std::size_t min_ops = 1 << 20;
+
+   // Keeps the results observable so the optimiser cannot drop them.
+   std::uint64_t sink = 0;
+
+   struct AllocationStats
+   {
+      std::size_t allocations = 0;
+      std::size_t live_bytes = 0;
+   };
+
+   AllocationStats allocation_stats;
+
+   // Tallies what a container takes from its allocator. Key strings keep
+   // the default allocator, so only the containers' own memory counts.
+   template <typename T>
+   struct CountingAllocator
+   {
+      using value_type = T;
+
+      CountingAllocator() = default;
+
+      template <typename U>
+      CountingAllocator(const CountingAllocator<U>&) noexcept
+      {
+      }
+
+      T* allocate(std::size_t n)
+      {
+         ++allocation_stats.allocations;
+         allocation_stats.live_bytes += n * sizeof(T);
+         return std::allocator<T>().allocate(n);
+      }
+
+      void deallocate(T* p, std::size_t n) noexcept
+      {
+         allocation_stats.live_bytes -= n * sizeof(T);
+         std::allocator<T>().deallocate(p, n);
+      }
+
+      friend bool operator==(const CountingAllocator&, const CountingAllocator&)
+      {
+         return true;
+      }
+   };
+
+   // The splitmix64 finaliser: a bijection, so distinct indices give
+   // distinct, randomly spread keys.
+   std::uint64_t mix(std::uint64_t x)
+   {
+      x ^= x >> 30;
+      x *= 0xBF58476D1CE4E5B9ull;
+      x ^= x >> 27;
+      x *= 0x94D049BB133111EBull;
+      x ^= x >> 31;
+      return x;
+   }
+
+   template <typename Key>
+   Key sequential_key(std::uint64_t i)
+   {
+      if constexpr (std::is_same_v<Key, std::string>)
+      {
+         return "key:" + std::to_string(i);
+      }
+      else
+      {
+         return i;
+      }
+   }
+
+   template <typename Key>
+   Key random_key(std::uint64_t i)
+   {
+      if constexpr (std::is_same_v<Key, std::string>)
+      {
+         return "key:" + std::to_string(mix(i));
+      }
+      else
+      {
+         return mix(i);
+      }
+   }
+
+   template <typename Key>
+   std::vector<Key> make_keys(std::size_t first, std::size_t count, Key (*make)(std::uint64_t))
+   {
+      std::vector<Key> keys;
+      keys.reserve(count);
+      for (std::size_t i = first; i < first + count; ++i)
+      {
+         keys.push_back(make(i));
+      }
+      return keys;
+   }
+
+   // The containers do not share an interface, so the workloads go
+   // through these.
+   template <typename Map, typename Key>
+   void put(Map& map, const Key& key, std::uint64_t value)
+   {
+      if constexpr (requires { map.get(key); })
+      {
+         map.insert(key, value);
+      }
+      else
+      {
+         map.insert_or_assign(key, value);
+      }
+   }
+
+   template <typename Map, typename Key>
+   const std::uint64_t* lookup(const Map& map, const Key& key)
+   {
+      if constexpr (requires { map.get(key); })
+      {
+         return map.get(key);
+      }
+      else
+      {
+         const auto it = map.find(key);
+         return it == map.end() ? nullptr : &it->second;
+      }
+   }
+
+   double elapsed_ns(std::chrono::steady_clock::time_point start)
+   {
+      const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+      return elapsed.count();
+   }
+
+   template <typename Map, typename Key>
+   double insert_ns(const std::vector<Key>& keys)
+   {
+      const auto rounds = std::max<std::size_t>(1, min_ops / keys.size());
+      double total = 0.0;
+      for (std::size_t round = 0; round < rounds; ++round)
+      {
+         Map map;
+         const auto start = std::chrono::steady_clock::now();
+         for (std::size_t i = 0; i < keys.size(); ++i)
+         {
+            put(map, keys[i], i);
+         }
+         total += elapsed_ns(start);
+         sink += map.size();
+      }
+      return total / static_cast<double>(rounds * keys.size());
+   }
+
+   template <typename Map, typename Key>
+   double lookup_ns(const Map& map, const std::vector<Key>& probes)
+   {
+      const auto rounds = std::max<std::size_t>(1, min_ops / probes.size());
+      const auto start = std::chrono::steady_clock::now();
+      for (std::size_t round = 0; round < rounds; ++round)
+      {
+         for (const auto& key : probes)
+         {
+            sink += reinterpret_cast<std::uintptr_t>(lookup(map, key));
+         }
+      }
+      return elapsed_ns(start) / static_cast<double>(rounds * probes.size());
+   }
+
+   // Steady state under churn: every op erases a present key and inserts a
+   // fresh one, so the size never changes.
+   template <typename Map, typename Key>
+   double churn_ns(Map map, const std::vector<Key>& present, const std::vector<Key>& fresh)
+   {
+      const auto ops = std::max(present.size(), min_ops);
+      std::vector<const Key*> live(present.size());
+      for (std::size_t i = 0; i < present.size(); ++i)
+      {
+         live[i] = &present[i];
+      }
+
+      std::uint64_t state = 0x9E3779B97F4A7C15ull;
+      const auto start = std::chrono::steady_clock::now();
+      for (std::size_t op = 0; op < ops; ++op)
+      {
+         state = mix(state);
+         auto& victim = live[state % live.size()];
+         map.erase(*victim);
+         victim = &fresh[op % fresh.size()];
+         put(map, *victim, op);
+      }
+      const auto ns = elapsed_ns(start);
+      sink += map.size();
+      return ns / static_cast<double>(ops);
+   }
+
+   template <typename Map>
+   double iterate_ns(const Map& map)
+   {
+      const auto rounds = std::max<std::size_t>(1, min_ops / map.size());
+      const auto start = std::chrono::steady_clock::now();
+      for (std::size_t round = 0; round < rounds; ++round)
+      {
+         for (const auto& entry : map)
+         {
+            sink += entry.second;
+         }
+      }
+      return elapsed_ns(start) / static_cast<double>(rounds * map.size());
+   }
+
+   template <typename Map, typename Key>
+   nlohmann::json run(std::string_view container, std::string_view key_type, std::size_t size)
+   {
+      const auto sequential = make_keys<Key>(0, size, sequential_key<Key>);
+      const auto present = make_keys<Key>(0, size, random_key<Key>);
+      const auto absent = make_keys<Key>(size, size, random_key<Key>);
+
+      nlohmann::json result = {{"container", container}, {"key", key_type}, {"size", size}};
+      result["ns_per_op"]["insert_sequential"] = insert_ns<Map>(sequential);
+      result["ns_per_op"]["insert_random"] = insert_ns<Map>(present);
+
+      allocation_stats = {};
+      Map map;
+      for (std::size_t i = 0; i < size; ++i)
+      {
+         put(map, present[i], i);
+      }
+      result["bytes_per_entry"] = static_cast<double>(allocation_stats.live_bytes) / static_cast<double>(size);
+      result["allocations"] = allocation_stats.allocations;
+
+      // Probe in an order unrelated to the insertion order.
+      auto hits = present;
+      std::shuffle(hits.begin(), hits.end(), std::minstd_rand{42});
+      result["ns_per_op"]["lookup_hit"] = lookup_ns(map, hits);
+      result["ns_per_op"]["lookup_miss"] = lookup_ns(map, absent);
+      result["ns_per_op"]["iterate"] = iterate_ns(map);
+      result["ns_per_op"]["erase_churn"] = churn_ns(std::move(map), present, absent);
+      return result;
+   }
+
+   template <typename Key>
+   void run_all(std::string_view key_type, std::size_t size, nlohmann::json& results)
+   {
+      using Value = std::uint64_t;
+      using Alloc = CountingAllocator<std::pair<Key, Value>>;
+
+      results.push_back(run<HashBrown<Key, Value, HashFunction<Key>, std::equal_to<>, Alloc>, Key>("HashBrown", key_type, size));
+      results.push_back(run<DenseHashBrown<Key, Value, HashFunction<Key>, std::equal_to<>, Alloc>, Key>("DenseHashBrown", key_type, size));
+      results.push_back(run<RobinHoodHashBrown<Key, Value, HashFunction<Key>, std::equal_to<>, Alloc>, Key>("RobinHoodHashBrown", key_type, size));
+      results.push_back(run<std::unordered_map<Key, Value, std::hash<Key>, std::equal_to<Key>, CountingAllocator<std::pair<const Key, Value>>>, Key>(
+         "std::unordered_map", key_type, size));
+   }
+
+   void print(const nlohmann::json& result)
+   {
+      const auto& ns = result["ns_per_op"];
+      std::cout << std::left << std::setw(20) << result["container"].get<std::string>()
+                << std::setw(8) << result["key"].get<std::string>()
+                << std::setw(11) << result["size"].get<std::size_t>()
+                << std::fixed << std::setprecision(1);
+      for (const auto workload : {"insert_sequential", "insert_random", "lookup_hit", "lookup_miss", "erase_churn", "iterate"})
+      {
+         std::cout << std::setw(10) << ns[workload].get<double>();
+      }
+      std::cout << std::setw(10) << result["bytes_per_entry"].get<double>()
+                << result["allocations"].get<std::size_t>() << std::endl;
+   }
+}
+
+int main(int argc, char** argv)
+{
+   std::size_t min_size = 100;
+   std::size_t max_size = 100'000'000;
+   std::string json_path;
+   for (int i = 1; i + 1 < argc; i += 2)
+   {
+      const std::string_view option = argv[i];
+      if (option == "--min-size")
+      {
+         min_size = static_cast<std::size_t>(std::strtod(argv[i + 1], nullptr));
+      }
+      else if (option == "--max-size")
+      {
+         max_size = static_cast<std::size_t>(std::strtod(argv[i + 1], nullptr));
+      }
+      else if (option == "--json")
+      {
+         json_path = argv[i + 1];
+      }
+      else
+      {
+         std::cerr << "usage: " << argv[0] << " [--min-size N] [--max-size N] [--json PATH]\n";
+         return 2;
+      }
+   }
+
+   std::cout << std::left << std::setw(20) << "container" << std::setw(8) << "key" << std::setw(11) << "size"
+             << std::setw(10) << "ins seq" << std::setw(10) << "ins rnd" << std::setw(10) << "hit"
+             << std::setw(10) << "miss" << std::setw(10) << "churn" << std::setw(10) << "iterate"
+             << std::setw(10) << "B/entry" << "allocs" << '\n';
+
+   nlohmann::json results = nlohmann::json::array();
+   for (auto size = std::max<std::size_t>(min_size, 1); size <= max_size; size *= 10)
+   {
+      const auto first = results.size();
+      run_all<std::uint64_t>("u64", size, results);
+      run_all<std::string>("string", size, results);
+      for (auto i = first; i < results.size(); ++i)
+      {
+         print(results[i]);
+      }
+   }
+
+   if (!json_path.empty())
+   {
+      nlohmann::json report = {
+         {"context", {{"compiler", __VERSION__}, {"min_ops", min_ops}}},
+         {"benchmarks", std::move(results)},
+      };
+      std::ofstream out{json_path};
+      out << report.dump(2) << '\n';
+      if (!out)
+      {
+         std::cerr << "cannot write " << json_path << '\n';
+         return 1;
+      }
+   }
+
+   return sink == 0;
+}
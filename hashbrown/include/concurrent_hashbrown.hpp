@@ -0,0 +1,272 @@
+#pragma once
+
+#include <hashbrown.hpp>
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <thread>
+#include <utility>
+
+// A HashBrown split into independently locked shards. Readers take a shared
+// lock on one shard, writers an exclusive one, and every shard sits on its
+// own cache line so that neighbouring locks do not false-share.
+template <typename Key, typename Value, typename Hash = HashFunction<Key>, typename KeyEqual = std::equal_to<>>
+class ConcurrentHashBrown
+{
+   static constexpr bool transparent_lookup =
+      hashbrown::detail::transparent<Hash> && hashbrown::detail::transparent<KeyEqual>;
+
+   public:
+      using map_type = HashBrown<Key, Value, Hash, KeyEqual>;
+      using value_type = typename map_type::value_type;
+
+      ConcurrentHashBrown();
+      explicit ConcurrentHashBrown(std::size_t shards);
+
+      ConcurrentHashBrown(const ConcurrentHashBrown&) = delete;
+      ConcurrentHashBrown& operator=(const ConcurrentHashBrown&) = delete;
+
+      void insert(Key key, Value value);
+      bool erase(const Key& key);
+      template <typename K>
+      bool erase(const K& key) requires transparent_lookup;
+
+      std::optional<Value> get(const Key& key) const;
+      template <typename K>
+      std::optional<Value> get(const K& key) const requires transparent_lookup;
+      bool contains(const Key& key) const;
+      template <typename K>
+      bool contains(const K& key) const requires transparent_lookup;
+
+      // Runs fn on the stored value under the shard's exclusive lock and
+      // returns whether the key was present.
+      template <typename Fn>
+      bool visit(const Key& key, Fn&& fn);
+
+      // Visits every entry, one shard at a time under its shared lock.
+      template <typename Fn>
+      void for_each(Fn&& fn) const;
+
+      std::size_t size() const;
+      bool empty() const;
+      void clear();
+      void reserve(std::size_t count);
+      std::size_t shard_count() const;
+
+   private:
+      struct alignas(hashbrown::detail::cache_line_size) Shard
+      {
+         mutable std::shared_mutex mutex;
+         map_type map;
+      };
+
+      std::unique_ptr<Shard[]> _shards;
+      unsigned _shard_bits;
+      Hash _hasher;
+
+      template <typename K>
+      Shard& shard_for(const K& key) const;
+      template <typename K>
+      std::optional<Value> get_key(const K& key) const;
+      template <typename K>
+      bool contains_key(const K& key) const;
+      template <typename K>
+      bool erase_key(const K& key);
+
+      static std::size_t default_shards();
+};
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual>
+ConcurrentHashBrown<Key, Value, Hash, KeyEqual>::ConcurrentHashBrown()
+   : ConcurrentHashBrown(default_shards())
+{
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual>
+ConcurrentHashBrown<Key, Value, Hash, KeyEqual>::ConcurrentHashBrown(std::size_t shards)
+   : _shards()
+   , _shard_bits(static_cast<unsigned>(std::countr_zero(std::bit_ceil(std::max<std::size_t>(shards, 1)))))
+   , _hasher()
+{
+   _shards = std::make_unique<Shard[]>(shard_count());
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual>
+void ConcurrentHashBrown<Key, Value, Hash, KeyEqual>::insert(Key key, Value value)
+{
+   auto& shard = shard_for(key);
+   std::unique_lock lock{shard.mutex};
+   shard.map.insert(std::move(key), std::move(value));
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual>
+bool ConcurrentHashBrown<Key, Value, Hash, KeyEqual>::erase(const Key& key)
+{
+   return erase_key(key);
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual>
+template <typename K>
+bool ConcurrentHashBrown<Key, Value, Hash, KeyEqual>::erase(const K& key)
+   requires transparent_lookup
+{
+   return erase_key(key);
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual>
+std::optional<Value> ConcurrentHashBrown<Key, Value, Hash, KeyEqual>::get(const Key& key) const
+{
+   return get_key(key);
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual>
+template <typename K>
+std::optional<Value> ConcurrentHashBrown<Key, Value, Hash, KeyEqual>::get(const K& key) const
+   requires transparent_lookup
+{
+   return get_key(key);
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual>
+bool ConcurrentHashBrown<Key, Value, Hash, KeyEqual>::contains(const Key& key) const
+{
+   return contains_key(key);
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual>
+template <typename K>
+bool ConcurrentHashBrown<Key, Value, Hash, KeyEqual>::contains(const K& key) const
+   requires transparent_lookup
+{
+   return contains_key(key);
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual>
+template <typename Fn>
+bool ConcurrentHashBrown<Key, Value, Hash, KeyEqual>::visit(const Key& key, Fn&& fn)
+{
+   auto& shard = shard_for(key);
+   std::unique_lock lock{shard.mutex};
+   auto value = const_cast<Value*>(shard.map.get(key));
+   if (value == nullptr)
+   {
+      return false;
+   }
+
+   std::invoke(std::forward<Fn>(fn), *value);
+   return true;
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual>
+template <typename Fn>
+void ConcurrentHashBrown<Key, Value, Hash, KeyEqual>::for_each(Fn&& fn) const
+{
+   for (std::size_t i = 0; i < shard_count(); ++i)
+   {
+      std::shared_lock lock{_shards[i].mutex};
+      for (const auto& entry : _shards[i].map)
+      {
+         std::invoke(fn, entry);
+      }
+   }
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual>
+std::size_t ConcurrentHashBrown<Key, Value, Hash, KeyEqual>::size() const
+{
+   std::size_t total = 0;
+   for (std::size_t i = 0; i < shard_count(); ++i)
+   {
+      std::shared_lock lock{_shards[i].mutex};
+      total += _shards[i].map.size();
+   }
+   return total;
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual>
+bool ConcurrentHashBrown<Key, Value, Hash, KeyEqual>::empty() const
+{
+   return size() == 0;
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual>
+void ConcurrentHashBrown<Key, Value, Hash, KeyEqual>::clear()
+{
+   for (std::size_t i = 0; i < shard_count(); ++i)
+   {
+      std::unique_lock lock{_shards[i].mutex};
+      _shards[i].map.clear();
+   }
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual>
+void ConcurrentHashBrown<Key, Value, Hash, KeyEqual>::reserve(std::size_t count)
+{
+   // Keys spread evenly over the shards, so leave a little slack per shard.
+   const auto per_shard = count / shard_count() + count / (8 * shard_count()) + 1;
+   for (std::size_t i = 0; i < shard_count(); ++i)
+   {
+      std::unique_lock lock{_shards[i].mutex};
+      _shards[i].map.reserve(per_shard);
+   }
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual>
+std::size_t ConcurrentHashBrown<Key, Value, Hash, KeyEqual>::shard_count() const
+{
+   return std::size_t{1} << _shard_bits;
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual>
+template <typename K>
+typename ConcurrentHashBrown<Key, Value, Hash, KeyEqual>::Shard& ConcurrentHashBrown<Key, Value, Hash, KeyEqual>::shard_for(const K& key) const
+{
+   return _shards[hashbrown::detail::shard_of(_hasher(key), _shard_bits)];
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual>
+template <typename K>
+std::optional<Value> ConcurrentHashBrown<Key, Value, Hash, KeyEqual>::get_key(const K& key) const
+{
+   const auto& shard = shard_for(key);
+   std::shared_lock lock{shard.mutex};
+   if (const auto value = shard.map.get(key))
+   {
+      return *value;
+   }
+   return std::nullopt;
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual>
+template <typename K>
+bool ConcurrentHashBrown<Key, Value, Hash, KeyEqual>::contains_key(const K& key) const
+{
+   const auto& shard = shard_for(key);
+   std::shared_lock lock{shard.mutex};
+   return shard.map.contains(key);
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual>
+template <typename K>
+bool ConcurrentHashBrown<Key, Value, Hash, KeyEqual>::erase_key(const K& key)
+{
+   auto& shard = shard_for(key);
+   std::unique_lock lock{shard.mutex};
+   const auto before = shard.map.size();
+   shard.map.erase(key);
+   return shard.map.size() != before;
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual>
+std::size_t ConcurrentHashBrown<Key, Value, Hash, KeyEqual>::default_shards()
+{
+   // A few shards per hardware thread keeps the chance of two threads
+   // wanting the same lock low.
+   return 4 * std::max(1u, std::thread::hardware_concurrency());
+}
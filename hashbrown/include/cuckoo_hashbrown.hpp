@@ -0,0 +1,1003 @@
+#pragma once
+
+#include <hashbrown.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <memory_resource>
+#include <stdexcept>
+#include <utility>
+
+// A HashBrown laid out for bucketized cuckoo hashing, for lookups whose
+// worst case matters more than their average. Slots come in buckets of four
+// and every key may live in only two of them, so a lookup reads two buckets'
+// tag words and compares only the keys whose tag matches. Inserting into two
+// full buckets moves entries to their other bucket along the shortest path
+// to a free slot; the few keys that find none wait in a small stash that
+// every lookup also checks while it is in use.
+template <typename Key,
+          typename Value,
+          typename Hash = HashFunction<Key>,
+          typename KeyEqual = std::equal_to<>,
+          typename Allocator = std::allocator<std::pair<Key, Value>>>
+class CuckooHashBrown
+{
+   template <bool IsConst>
+   class Iterator;
+
+   static constexpr bool transparent_lookup =
+      hashbrown::detail::transparent<Hash> && hashbrown::detail::transparent<KeyEqual>;
+
+   static constexpr bool move_assign_noexcept =
+      std::allocator_traits<Allocator>::propagate_on_container_move_assignment::value
+      || std::allocator_traits<Allocator>::is_always_equal::value;
+
+   public:
+      static constexpr bool stored_hash = hashbrown::detail::stores_hash<Key, Hash>();
+
+      using value_type = std::pair<Key, Value>;
+      using reference = value_type&;
+      using pointer = value_type*;
+      using const_reference = const value_type&;
+      using iterator = Iterator<false>;
+      using const_iterator = Iterator<true>;
+      using allocator_type = Allocator;
+
+      constexpr CuckooHashBrown();
+      explicit CuckooHashBrown(const Allocator& alloc);
+      explicit CuckooHashBrown(const Hash& hash, const KeyEqual& equal = KeyEqual(), const Allocator& alloc = Allocator());
+      CuckooHashBrown(std::initializer_list<value_type> il, const Allocator& alloc = Allocator());
+      CuckooHashBrown(const CuckooHashBrown& other);
+      CuckooHashBrown(const CuckooHashBrown& other, const Allocator& alloc);
+      CuckooHashBrown(CuckooHashBrown&& other) noexcept;
+      CuckooHashBrown& operator=(const CuckooHashBrown& other);
+      CuckooHashBrown& operator=(CuckooHashBrown&& other) noexcept(move_assign_noexcept);
+      ~CuckooHashBrown();
+
+      iterator begin();
+      const_iterator begin() const;
+      const_iterator cbegin() const;
+
+      iterator end();
+      const_iterator end() const;
+      const_iterator cend() const;
+
+      // Returns an iterator to the entry after the erased one, so erasing
+      // while iterating visits every other entry exactly once.
+      iterator erase(const Key& key);
+      template <typename K>
+      iterator erase(const K& key) requires transparent_lookup;
+
+      void insert(std::initializer_list<value_type> il);
+      template <std::input_iterator InputIt>
+      void insert(InputIt first, InputIt last);
+      iterator insert(Key key, Value value);
+      iterator insert(const value_type& value);
+      iterator insert(value_type&& value);
+      template <typename... Args>
+      iterator emplace(Args&&... args);
+
+      const Value* get(const Key& key) const;
+      template <typename K>
+      const Value* get(const K& key) const requires transparent_lookup;
+      bool contains(const Key& key) const;
+      template <typename K>
+      bool contains(const K& key) const requires transparent_lookup;
+      bool empty() const;
+      std::size_t size() const;
+      std::size_t capacity() const;
+      void clear();
+      void swap(CuckooHashBrown& other) noexcept;
+      allocator_type get_allocator() const;
+      Hash hash_function() const;
+      KeyEqual key_eq() const;
+
+      float load_factor() const;
+      float max_load_factor() const;
+      void max_load_factor(float ml);
+      void rehash(std::size_t count);
+      void reserve(std::size_t count);
+
+      // How many entries sit in the stash rather than in one of their two
+      // buckets.
+      std::size_t stash_size() const;
+
+   private:
+      using tag_t = std::uint8_t;
+      using value_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<value_type>;
+      using value_traits = std::allocator_traits<value_allocator>;
+      using tag_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<tag_t>;
+      using hash_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<std::size_t>;
+
+      static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+      static constexpr std::size_t bucket_width = 4;
+      static constexpr std::size_t stash_slots = 8;
+      // Bounds the breadth-first search for a free slot, which keeps every
+      // displacement path at most four moves long.
+      static constexpr std::size_t max_search = 256;
+
+      struct Step
+      {
+         std::size_t bucket;
+         std::size_t parent;
+         // The slot in the parent's bucket whose entry moves to this bucket.
+         std::size_t slot;
+      };
+
+      // One tag per slot: the top byte of the hash, with 0 marking an empty
+      // slot. The stash follows the last bucket.
+      tag_t* _tags;
+      value_type* _slots;
+      // Parallel to slots; only allocated when stored_hash is set.
+      std::size_t* _hashes;
+      std::size_t _capacity;
+      std::size_t _size;
+      std::size_t _stashed;
+
+      Hash _hasher;
+      KeyEqual _equal;
+      float _max_load_factor;
+      [[no_unique_address]] value_allocator _alloc;
+
+      static tag_t tag_of(std::size_t hash);
+      std::size_t first_bucket(std::size_t hash) const;
+      std::size_t other_bucket(std::size_t bucket, tag_t tag) const;
+
+      template <typename K>
+      std::size_t find_slot(const K& key, std::size_t hash) const;
+      template <typename K>
+      iterator erase_key(const K& key);
+      std::size_t prepare_insert(std::size_t hash);
+      std::size_t free_slot(std::size_t bucket) const;
+      std::size_t make_room(std::size_t first, std::size_t second);
+      void finish_insert(std::size_t slot, std::size_t hash);
+      void move_slot(std::size_t to, std::size_t from);
+      std::size_t hash_at(std::size_t slot) const;
+      std::size_t slot_count() const;
+      std::size_t next_full(std::size_t slot) const;
+
+      void allocate(std::size_t capacity);
+      void deallocate();
+      void destroy();
+      void resize(std::size_t new_capacity);
+      void swap_contents(CuckooHashBrown& other) noexcept;
+
+      template <bool IsConst>
+      class Iterator {
+         public:
+            using difference_type = std::ptrdiff_t;
+            using value_type = CuckooHashBrown::value_type;
+            using reference = std::conditional_t<IsConst, const_reference, CuckooHashBrown::reference>;
+            using pointer = std::conditional_t<IsConst, const value_type*, CuckooHashBrown::pointer>;
+            using iterator_category = std::forward_iterator_tag;
+            using map_pointer = std::conditional_t<IsConst, const CuckooHashBrown*, CuckooHashBrown*>;
+
+            Iterator() = default;
+
+            Iterator(map_pointer hb, std::size_t slot)
+               : _hb(hb)
+               , _slot(slot)
+            {
+            }
+
+            operator Iterator<true>() const requires (!IsConst)
+            {
+               return Iterator<true>{_hb, _slot};
+            }
+
+            Iterator& operator++()
+            {
+               _slot = _hb->next_full(_slot + 1);
+               return *this;
+            }
+
+            Iterator operator++(int)
+            {
+               auto temp = *this;
+               ++*this;
+               return temp;
+            }
+
+            reference operator*() const
+            {
+               return _hb->_slots[_slot];
+            }
+
+            pointer operator->() const
+            {
+               return &this->operator*();
+            }
+
+            friend bool operator==(const Iterator& it_a, const Iterator& it_b)
+            {
+               return it_a._hb == it_b._hb
+                  && it_a._slot == it_b._slot;
+            }
+
+            friend bool operator!=(const Iterator& it_a, const Iterator& it_b)
+            {
+               return !(it_a == it_b);
+            }
+
+         private:
+            map_pointer _hb = nullptr;
+            std::size_t _slot = 0;
+      };
+};
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+constexpr CuckooHashBrown<Key, Value, Hash, KeyEqual, Allocator>::CuckooHashBrown()
+   : CuckooHashBrown(Allocator())
+{
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+CuckooHashBrown<Key, Value, Hash, KeyEqual, Allocator>::CuckooHashBrown(const Allocator& alloc)
+   : CuckooHashBrown(Hash(), KeyEqual(), alloc)
+{
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+CuckooHashBrown<Key, Value, Hash, KeyEqual, Allocator>::CuckooHashBrown(const Hash& hash, const KeyEqual& equal, const Allocator& alloc)
+   : _tags(nullptr)
+   , _slots(nullptr)
+   , _hashes(nullptr)
+   , _capacity(0)
+   , _size(0)
+   , _stashed(0)
+   , _hasher(hash)
+   , _equal(equal)
+   , _max_load_factor(hashbrown::detail::default_max_load_factor)
+   , _alloc(alloc)
+{
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+CuckooHashBrown<Key, Value, Hash, KeyEqual, Allocator>::CuckooHashBrown(std::initializer_list<value_type> il, const Allocator& alloc)
+   : CuckooHashBrown(alloc)
+{
+   insert(il);
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+CuckooHashBrown<Key, Value, Hash, KeyEqual, Allocator>::CuckooHashBrown(const CuckooHashBrown& other)
+   : CuckooHashBrown(other, value_traits::select_on_container_copy_construction(other._alloc))
+{
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+CuckooHashBrown<Key, Value, Hash, KeyEqual, Allocator>::CuckooHashBrown(const CuckooHashBrown& other, const Allocator& alloc)
+   : CuckooHashBrown(alloc)
+{
+   _hasher = other._hasher;
+   _equal = other._equal;
+   _max_load_factor = other._max_load_factor;
+
+   if (other._size == 0)
+   {
+      return;
+   }
+
+   // Same capacity and hasher, so every entry keeps its slot.
+   allocate(other._capacity);
+   for (auto slot = other.next_full(0); slot < other.slot_count(); slot = other.next_full(slot + 1))
+   {
+      value_traits::construct(_alloc, _slots + slot, other._slots[slot]);
+      if constexpr (stored_hash)
+      {
+         _hashes[slot] = other._hashes[slot];
+      }
+      _tags[slot] = other._tags[slot];
+      ++_size;
+   }
+   _stashed = other._stashed;
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+CuckooHashBrown<Key, Value, Hash, KeyEqual, Allocator>::CuckooHashBrown(CuckooHashBrown&& other) noexcept
+   : _tags(std::exchange(other._tags, nullptr))
+   , _slots(std::exchange(other._slots, nullptr))
+   , _hashes(std::exchange(other._hashes, nullptr))
+   , _capacity(std::exchange(other._capacity, 0))
+   , _size(std::exchange(other._size, 0))
+   , _stashed(std::exchange(other._stashed, 0))
+   , _hasher(std::move(other._hasher))
+   , _equal(std::move(other._equal))
+   , _max_load_factor(other._max_load_factor)
+   , _alloc(std::move(other._alloc))
+{
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+CuckooHashBrown<Key, Value, Hash, KeyEqual, Allocator>& CuckooHashBrown<Key, Value, Hash, KeyEqual, Allocator>::operator=(const CuckooHashBrown& other)
+{
+   if (this != &other)
+   {
+      if constexpr (value_traits::propagate_on_container_copy_assignment::value)
+      {
+         destroy();
+         _alloc = other._alloc;
+      }
+      CuckooHashBrown copy{other, _alloc};
+      swap_contents(copy);
+   }
+   return *this;
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+CuckooHashBrown<Key, Value, Hash, KeyEqual, Allocator>& CuckooHashBrown<Key, Value, Hash, KeyEqual, Allocator>::operator=(CuckooHashBrown&& other) noexcept(move_assign_noexcept)
+{
+   if (this == &other)
+   {
+      return *this;
+   }
+
+   if constexpr (value_traits::propagate_on_container_move_assignment::value)
+   {
+      destroy();
+      _alloc = std::move(other._alloc);
+      swap_contents(other);
+   }
+   else if (_alloc == other._alloc)
+   {
+      destroy();
+      swap_contents(other);
+   }
+   else
+   {
+      // Storage from another allocator cannot be adopted; move the entries.
+      clear();
+      reserve(other._size);
+      for (auto& entry : other)
+      {
+         insert(std::move(entry.first), std::move(entry.second));
+      }
+      other.clear();
+   }
+   return *this;
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+CuckooHashBrown<Key, Value, Hash, KeyEqual, Allocator>::~CuckooHashBrown()
+{
+   destroy();
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+typename CuckooHashBrown<Key, Value, Hash, KeyEqual, Allocator>::iterator CuckooHashBrown<Key, Value, Hash, KeyEqual, Allocator>::begin()
+{
+   return iterator(this, next_full(0));
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+typename CuckooHashBrown<Key, Value, Hash, KeyEqual, Allocator>::const_iterator CuckooHashBrown<Key, Value, Hash, KeyEqual, Allocator>::begin() const
+{
+   return const_iterator(this, next_full(0));
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+typename CuckooHashBrown<Key, Value, Hash, KeyEqual, Allocator>::const_iterator CuckooHashBrown<Key, Value, Hash, KeyEqual, Allocator>::cbegin() const
+{
+   return begin();
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+typename CuckooHashBrown<Key, Value, Hash, KeyEqual, Allocator>::iterator CuckooHashBrown<Key, Value, Hash, KeyEqual, Allocator>::end()
+{
+   return iterator(this, slot_count());
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+typename CuckooHashBrown<Key, Value, Hash, KeyEqual, Allocator>::const_iterator CuckooHashBrown<Key, Value, Hash, KeyEqual, Allocator>::end() const
+{
+   return const_iterator(this, slot_count());
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+typename CuckooHashBrown<Key, Value, Hash, KeyEqual, Allocator>::const_iterator CuckooHashBrown<Key, Value, Hash, KeyEqual, Allocator>::cend() const
+{
+   return end();
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+typename CuckooHashBrown<Key, Value, Hash, KeyEqual, Allocator>::iterator CuckooHashBrown<Key, Value, Hash, KeyEqual, Allocator>::erase(const Key& key)
+{
+   return erase_key(key);
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+template <typename K>
+typename CuckooHashBrown<Key, Value, Hash, KeyEqual, Allocator>::iterator CuckooHashBrown<Key, Value, Hash, KeyEqual, Allocator>::erase(const K& key)
+   requires transparent_lookup
+{
+   return erase_key(key);
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+void CuckooHashBrown<Key, Value, Hash, KeyEqual, Allocator>::insert(std::initializer_list<value_type> il)
+{
+   insert(il.begin(), il.end());
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+template <std::input_iterator InputIt>
+void CuckooHashBrown<Key, Value, Hash, KeyEqual, Allocator>::insert(InputIt first, InputIt last)
+{
+   if constexpr (std::forward_iterator<InputIt>)
+   {
+      reserve(_size + static_cast<std::size_t>(std::distance(first, last)));
+   }
+
+   for (; first != last; ++first)
+   {
+      insert(*first);
+   }
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+typename CuckooHashBrown<Key, Value, Hash, KeyEqual, Allocator>::iterator CuckooHashBrown<Key, Value, Hash, KeyEqual, Allocator>::insert(Key key, Value value)
+{
+   const auto hash = _hasher(key);
+   const auto found = find_slot(key, hash);
+
+   if (found != npos)
+   {
+      std::swap(_slots[found].second, value);
+      return iterator {this, found};
+   }
+
+   const auto slot = prepare_insert(hash);
+   value_traits::construct(_alloc, _slots + slot, std::move(key), std::move(value));
+   finish_insert(slot, hash);
+   return iterator {this, slot};
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+typename CuckooHashBrown<Key, Value, Hash, KeyEqual, Allocator>::iterator CuckooHashBrown<Key, Value, Hash, KeyEqual, Allocator>::insert(const value_type& value)
+{
+   return insert(value.first, value.second);
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+typename CuckooHashBrown<Key, Value, Hash, KeyEqual, Allocator>::iterator CuckooHashBrown<Key, Value, Hash, KeyEqual, Allocator>::insert(value_type&& value)
+{
+   return insert(std::move(value.first), std::move(value.second));
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+template <typename... Args>
+typename CuckooHashBrown<Key, Value, Hash, KeyEqual, Allocator>::iterator CuckooHashBrown<Key, Value, Hash, KeyEqual, Allocator>::emplace(Args&&... args)
+{
+   value_type pair(std::forward<Args>(args)...);
+   return insert(std::move(pair));
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+const Value* CuckooHashBrown<Key, Value, Hash, KeyEqual, Allocator>::get(const Key& key) const
+{
+   const auto slot = find_slot(key, _hasher(key));
+   return slot == npos ? nullptr : &_slots[slot].second;
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+template <typename K>
+const Value* CuckooHashBrown<Key, Value, Hash, KeyEqual, Allocator>::get(const K& key) const
+   requires transparent_lookup
+{
+   const auto slot = find_slot(key, _hasher(key));
+   return slot == npos ? nullptr : &_slots[slot].second;
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+bool CuckooHashBrown<Key, Value, Hash, KeyEqual, Allocator>::contains(const Key& key) const
+{
+   return find_slot(key, _hasher(key)) != npos;
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+template <typename K>
+bool CuckooHashBrown<Key, Value, Hash, KeyEqual, Allocator>::contains(const K& key) const
+   requires transparent_lookup
+{
+   return find_slot(key, _hasher(key)) != npos;
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+bool CuckooHashBrown<Key, Value, Hash, KeyEqual, Allocator>::empty() const
+{
+   return _size == 0;
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+std::size_t CuckooHashBrown<Key, Value, Hash, KeyEqual, Allocator>::size() const
+{
+   return _size;
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+std::size_t CuckooHashBrown<Key, Value, Hash, KeyEqual, Allocator>::capacity() const
+{
+   return _capacity;
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+void CuckooHashBrown<Key, Value, Hash, KeyEqual, Allocator>::clear()
+{
+   destroy();
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+void CuckooHashBrown<Key, Value, Hash, KeyEqual, Allocator>::swap(CuckooHashBrown& other) noexcept
+{
+   if constexpr (value_traits::propagate_on_container_swap::value)
+   {
+      using std::swap;
+      swap(_alloc, other._alloc);
+   }
+   swap_contents(other);
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+typename CuckooHashBrown<Key, Value, Hash, KeyEqual, Allocator>::allocator_type CuckooHashBrown<Key, Value, Hash, KeyEqual, Allocator>::get_allocator() const
+{
+   return allocator_type(_alloc);
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+Hash CuckooHashBrown<Key, Value, Hash, KeyEqual, Allocator>::hash_function() const
+{
+   return _hasher;
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+KeyEqual CuckooHashBrown<Key, Value, Hash, KeyEqual, Allocator>::key_eq() const
+{
+   return _equal;
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+float CuckooHashBrown<Key, Value, Hash, KeyEqual, Allocator>::load_factor() const
+{
+   if (_capacity == 0)
+   {
+      return 0.0f;
+   }
+   return static_cast<float>(_size) / static_cast<float>(_capacity);
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+float CuckooHashBrown<Key, Value, Hash, KeyEqual, Allocator>::max_load_factor() const
+{
+   return _max_load_factor;
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+void CuckooHashBrown<Key, Value, Hash, KeyEqual, Allocator>::max_load_factor(float ml)
+{
+   hashbrown::detail::check_max_load_factor(ml);
+
+   _max_load_factor = ml;
+   if (_capacity != 0)
+   {
+      resize(std::max(_capacity, hashbrown::detail::capacity_for(_size, _max_load_factor)));
+   }
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+void CuckooHashBrown<Key, Value, Hash, KeyEqual, Allocator>::rehash(std::size_t count)
+{
+   if (_size == 0 && count == 0)
+   {
+      destroy();
+      return;
+   }
+
+   auto target = hashbrown::detail::capacity_for(_size, _max_load_factor);
+   while (target < count)
+   {
+      target *= 2;
+   }
+
+   if (target != _capacity)
+   {
+      resize(target);
+   }
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+void CuckooHashBrown<Key, Value, Hash, KeyEqual, Allocator>::reserve(std::size_t count)
+{
+   if (_capacity == 0 || count > hashbrown::detail::max_items(_capacity, _max_load_factor))
+   {
+      rehash(hashbrown::detail::capacity_for(count, _max_load_factor));
+   }
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+std::size_t CuckooHashBrown<Key, Value, Hash, KeyEqual, Allocator>::stash_size() const
+{
+   return _stashed;
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+typename CuckooHashBrown<Key, Value, Hash, KeyEqual, Allocator>::tag_t CuckooHashBrown<Key, Value, Hash, KeyEqual, Allocator>::tag_of(std::size_t hash)
+{
+   const auto tag = static_cast<tag_t>(hash >> (std::numeric_limits<std::size_t>::digits - 8));
+   return tag == 0 ? 1 : tag;
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+std::size_t CuckooHashBrown<Key, Value, Hash, KeyEqual, Allocator>::first_bucket(std::size_t hash) const
+{
+   return hash & (_capacity / bucket_width - 1);
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+std::size_t CuckooHashBrown<Key, Value, Hash, KeyEqual, Allocator>::other_bucket(std::size_t bucket, tag_t tag) const
+{
+   // Derived from the tag alone, and its own inverse, so an entry can be
+   // moved to its other bucket without hashing its key again.
+   return (bucket ^ (tag * std::size_t{0x5BD1E995})) & (_capacity / bucket_width - 1);
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+template <typename K>
+std::size_t CuckooHashBrown<Key, Value, Hash, KeyEqual, Allocator>::find_slot(const K& key, std::size_t hash) const
+{
+   if (_capacity == 0)
+   {
+      return npos;
+   }
+
+   const auto tag = tag_of(hash);
+   const auto first = first_bucket(hash);
+   const auto match = [&](std::size_t slot) {
+      if (_tags[slot] != tag)
+      {
+         return false;
+      }
+      if constexpr (stored_hash)
+      {
+         if (_hashes[slot] != hash)
+         {
+            return false;
+         }
+      }
+      return _equal(_slots[slot].first, key);
+   };
+
+   for (const auto bucket : {first, other_bucket(first, tag)})
+   {
+      for (auto slot = bucket * bucket_width; slot < (bucket + 1) * bucket_width; ++slot)
+      {
+         if (match(slot))
+         {
+            return slot;
+         }
+      }
+   }
+
+   if (_stashed != 0)
+   {
+      for (auto slot = _capacity; slot < _capacity + stash_slots; ++slot)
+      {
+         if (match(slot))
+         {
+            return slot;
+         }
+      }
+   }
+   return npos;
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+template <typename K>
+typename CuckooHashBrown<Key, Value, Hash, KeyEqual, Allocator>::iterator CuckooHashBrown<Key, Value, Hash, KeyEqual, Allocator>::erase_key(const K& key)
+{
+   const auto slot = find_slot(key, _hasher(key));
+   if (slot == npos)
+   {
+      return end();
+   }
+
+   value_traits::destroy(_alloc, _slots + slot);
+   _tags[slot] = 0;
+   if (slot >= _capacity)
+   {
+      --_stashed;
+   }
+   --_size;
+   return iterator {this, next_full(slot)};
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+std::size_t CuckooHashBrown<Key, Value, Hash, KeyEqual, Allocator>::prepare_insert(std::size_t hash)
+{
+   while (true)
+   {
+      if (_capacity == 0 || _size >= hashbrown::detail::max_items(_capacity, _max_load_factor))
+      {
+         resize(std::max(2 * _capacity, hashbrown::detail::capacity_for(_size + 1, _max_load_factor)));
+         continue;
+      }
+
+      const auto first = first_bucket(hash);
+      const auto second = other_bucket(first, tag_of(hash));
+      for (const auto bucket : {first, second})
+      {
+         if (const auto slot = free_slot(bucket); slot != npos)
+         {
+            return slot;
+         }
+      }
+
+      if (const auto slot = make_room(first, second); slot != npos)
+      {
+         return slot;
+      }
+
+      if (_stashed < stash_slots)
+      {
+         auto slot = _capacity;
+         while (_tags[slot] != 0)
+         {
+            ++slot;
+         }
+         return slot;
+      }
+
+      // Both buckets and the stash full in a table under half full means
+      // the keys share hashes, and no amount of growing will spread them out.
+      if (_size < hashbrown::detail::max_items(_capacity, _max_load_factor) / 2)
+      {
+         throw std::overflow_error("CuckooHashBrown: no free slot, the hash function is too weak");
+      }
+      resize(2 * _capacity);
+   }
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+std::size_t CuckooHashBrown<Key, Value, Hash, KeyEqual, Allocator>::free_slot(std::size_t bucket) const
+{
+   for (auto slot = bucket * bucket_width; slot < (bucket + 1) * bucket_width; ++slot)
+   {
+      if (_tags[slot] == 0)
+      {
+         return slot;
+      }
+   }
+   return npos;
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+std::size_t CuckooHashBrown<Key, Value, Hash, KeyEqual, Allocator>::make_room(std::size_t first, std::size_t second)
+{
+   // Breadth-first over the buckets the entries of full buckets could move
+   // to. The first free slot found ends the shortest path, so no bucket
+   // appears on it twice; entries then move along it from the far end,
+   // each into the slot the previous move emptied.
+   std::array<Step, max_search> steps;
+   std::size_t count = 0;
+   steps[count++] = {first, npos, npos};
+   if (second != first)
+   {
+      steps[count++] = {second, npos, npos};
+   }
+
+   for (std::size_t step = 0; step < count; ++step)
+   {
+      const auto bucket = steps[step].bucket;
+      for (auto slot = bucket * bucket_width; slot < (bucket + 1) * bucket_width; ++slot)
+      {
+         const auto next = other_bucket(bucket, _tags[slot]);
+         const auto free = free_slot(next);
+         if (free == npos)
+         {
+            if (count < max_search)
+            {
+               steps[count++] = {next, step, slot};
+            }
+            continue;
+         }
+
+         auto to = free;
+         auto from = slot;
+         auto at = step;
+         while (true)
+         {
+            move_slot(to, from);
+            _tags[to] = _tags[from];
+            if (steps[at].parent == npos)
+            {
+               break;
+            }
+            to = from;
+            from = steps[at].slot;
+            at = steps[at].parent;
+         }
+         _tags[from] = 0;
+         return from;
+      }
+   }
+   return npos;
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+void CuckooHashBrown<Key, Value, Hash, KeyEqual, Allocator>::finish_insert(std::size_t slot, std::size_t hash)
+{
+   if constexpr (stored_hash)
+   {
+      _hashes[slot] = hash;
+   }
+   _tags[slot] = tag_of(hash);
+   if (slot >= _capacity)
+   {
+      ++_stashed;
+   }
+   ++_size;
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+void CuckooHashBrown<Key, Value, Hash, KeyEqual, Allocator>::move_slot(std::size_t to, std::size_t from)
+{
+   value_traits::construct(_alloc, _slots + to, std::move(_slots[from]));
+   value_traits::destroy(_alloc, _slots + from);
+   if constexpr (stored_hash)
+   {
+      _hashes[to] = _hashes[from];
+   }
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+std::size_t CuckooHashBrown<Key, Value, Hash, KeyEqual, Allocator>::hash_at(std::size_t slot) const
+{
+   if constexpr (stored_hash)
+   {
+      return _hashes[slot];
+   }
+   else
+   {
+      return _hasher(_slots[slot].first);
+   }
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+std::size_t CuckooHashBrown<Key, Value, Hash, KeyEqual, Allocator>::slot_count() const
+{
+   return _capacity == 0 ? 0 : _capacity + stash_slots;
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+std::size_t CuckooHashBrown<Key, Value, Hash, KeyEqual, Allocator>::next_full(std::size_t slot) const
+{
+   const auto count = slot_count();
+   while (slot < count && _tags[slot] == 0)
+   {
+      ++slot;
+   }
+   return slot;
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+void CuckooHashBrown<Key, Value, Hash, KeyEqual, Allocator>::allocate(std::size_t capacity)
+{
+   tag_allocator tag_alloc{_alloc};
+   hash_allocator hash_alloc{_alloc};
+   const auto count = capacity + stash_slots;
+
+   _tags = std::allocator_traits<tag_allocator>::allocate(tag_alloc, count);
+   try
+   {
+      _slots = value_traits::allocate(_alloc, count);
+      if constexpr (stored_hash)
+      {
+         try
+         {
+            _hashes = std::allocator_traits<hash_allocator>::allocate(hash_alloc, count);
+         }
+         catch (...)
+         {
+            value_traits::deallocate(_alloc, _slots, count);
+            throw;
+         }
+      }
+   }
+   catch (...)
+   {
+      std::allocator_traits<tag_allocator>::deallocate(tag_alloc, _tags, count);
+      _tags = nullptr;
+      _slots = nullptr;
+      throw;
+   }
+
+   std::fill_n(_tags, count, tag_t{0});
+   _capacity = capacity;
+   _size = 0;
+   _stashed = 0;
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+void CuckooHashBrown<Key, Value, Hash, KeyEqual, Allocator>::deallocate()
+{
+   if (_capacity == 0)
+   {
+      return;
+   }
+
+   tag_allocator tag_alloc{_alloc};
+   hash_allocator hash_alloc{_alloc};
+   const auto count = slot_count();
+
+   if constexpr (stored_hash)
+   {
+      std::allocator_traits<hash_allocator>::deallocate(hash_alloc, _hashes, count);
+   }
+   value_traits::deallocate(_alloc, _slots, count);
+   std::allocator_traits<tag_allocator>::deallocate(tag_alloc, _tags, count);
+
+   _tags = nullptr;
+   _slots = nullptr;
+   _hashes = nullptr;
+   _capacity = 0;
+   _size = 0;
+   _stashed = 0;
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+void CuckooHashBrown<Key, Value, Hash, KeyEqual, Allocator>::destroy()
+{
+   for (auto slot = next_full(0); slot < slot_count(); slot = next_full(slot + 1))
+   {
+      value_traits::destroy(_alloc, _slots + slot);
+   }
+   deallocate();
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+void CuckooHashBrown<Key, Value, Hash, KeyEqual, Allocator>::resize(std::size_t new_capacity)
+{
+   CuckooHashBrown rebuilt{_alloc};
+   rebuilt._hasher = _hasher;
+   rebuilt._equal = _equal;
+   rebuilt._max_load_factor = _max_load_factor;
+   rebuilt.allocate(new_capacity);
+
+   for (auto slot = next_full(0); slot < slot_count(); slot = next_full(slot + 1))
+   {
+      const auto hash = hash_at(slot);
+      const auto to = rebuilt.prepare_insert(hash);
+      value_traits::construct(_alloc, rebuilt._slots + to, std::move(_slots[slot]));
+      rebuilt.finish_insert(to, hash);
+   }
+
+   swap_contents(rebuilt);
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+void CuckooHashBrown<Key, Value, Hash, KeyEqual, Allocator>::swap_contents(CuckooHashBrown& other) noexcept
+{
+   using std::swap;
+   swap(_tags, other._tags);
+   swap(_slots, other._slots);
+   swap(_hashes, other._hashes);
+   swap(_capacity, other._capacity);
+   swap(_size, other._size);
+   swap(_stashed, other._stashed);
+   swap(_hasher, other._hasher);
+   swap(_equal, other._equal);
+   swap(_max_load_factor, other._max_load_factor);
+}
+
+namespace hashbrown::pmr
+{
+   template <typename Key, typename Value, typename Hash = HashFunction<Key>, typename KeyEqual = std::equal_to<>>
+   using CuckooHashBrown = ::CuckooHashBrown<Key, Value, Hash, KeyEqual, std::pmr::polymorphic_allocator<std::pair<Key, Value>>>;
+}
@@ -0,0 +1,826 @@
+#pragma once
+
+#include <hashbrown.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+
+// A compact, insertion-ordered HashBrown in the style of CPython's dict.
+// Entries are appended to one contiguous array and the probed table only
+// holds 32-bit indices into it, so iteration is a linear sweep in insertion
+// order. Erasing leaves a hole that the next rebuild squeezes out.
+template <typename Key,
+          typename Value,
+          typename Hash = HashFunction<Key>,
+          typename KeyEqual = std::equal_to<>,
+          typename Allocator = std::allocator<std::pair<Key, Value>>>
+class DenseHashBrown
+{
+   template <bool IsConst>
+   class Iterator;
+
+   static constexpr bool transparent_lookup =
+      hashbrown::detail::transparent<Hash> && hashbrown::detail::transparent<KeyEqual>;
+
+   static constexpr bool move_assign_noexcept =
+      std::allocator_traits<Allocator>::propagate_on_container_move_assignment::value
+      || std::allocator_traits<Allocator>::is_always_equal::value;
+
+   public:
+      using value_type = std::pair<Key, Value>;
+      using reference = value_type&;
+      using pointer = value_type*;
+      using const_reference = const value_type&;
+      using iterator = Iterator<false>;
+      using const_iterator = Iterator<true>;
+      using allocator_type = Allocator;
+
+      constexpr DenseHashBrown();
+      explicit DenseHashBrown(const Allocator& alloc);
+      explicit DenseHashBrown(const Hash& hash, const KeyEqual& equal = KeyEqual(), const Allocator& alloc = Allocator());
+      DenseHashBrown(std::initializer_list<value_type> il, const Allocator& alloc = Allocator());
+      DenseHashBrown(const DenseHashBrown& other);
+      DenseHashBrown(const DenseHashBrown& other, const Allocator& alloc);
+      DenseHashBrown(DenseHashBrown&& other) noexcept;
+      DenseHashBrown& operator=(const DenseHashBrown& other);
+      DenseHashBrown& operator=(DenseHashBrown&& other) noexcept(move_assign_noexcept);
+      ~DenseHashBrown();
+
+      iterator begin();
+      const_iterator begin() const;
+      const_iterator cbegin() const;
+
+      iterator end();
+      const_iterator end() const;
+      const_iterator cend() const;
+
+      iterator erase(const Key& key);
+      template <typename K>
+      iterator erase(const K& key) requires transparent_lookup;
+
+      void insert(std::initializer_list<value_type> il);
+      template <std::input_iterator InputIt>
+      void insert(InputIt first, InputIt last);
+      iterator insert(Key key, Value value);
+      iterator insert(const value_type& value);
+      iterator insert(value_type&& value);
+      template <typename... Args>
+      iterator emplace(Args&&... args);
+
+      const Value* get(const Key& key) const;
+      template <typename K>
+      const Value* get(const K& key) const requires transparent_lookup;
+      bool contains(const Key& key) const;
+      template <typename K>
+      bool contains(const K& key) const requires transparent_lookup;
+      bool empty() const;
+      std::size_t size() const;
+      std::size_t capacity() const;
+      void clear();
+      void swap(DenseHashBrown& other) noexcept;
+      allocator_type get_allocator() const;
+      Hash hash_function() const;
+      KeyEqual key_eq() const;
+
+      float load_factor() const;
+      float max_load_factor() const;
+      void max_load_factor(float ml);
+      void rehash(std::size_t count);
+      void reserve(std::size_t count);
+
+   private:
+      using ctrl_t = hashbrown::detail::ctrl_t;
+      using Group = hashbrown::detail::Group;
+      using index_t = std::uint32_t;
+      using value_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<value_type>;
+      using value_traits = std::allocator_traits<value_allocator>;
+      using ctrl_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<ctrl_t>;
+      using index_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<index_t>;
+      using hash_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<std::size_t>;
+
+      static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+      // Erased entries keep their place in the array with this hash. Real
+      // hashes equal to it are folded onto its neighbour.
+      static constexpr std::size_t hole = std::numeric_limits<std::size_t>::max();
+
+      // The probed index table: one control byte and one entry index per slot.
+      ctrl_t* _ctrl;
+      index_t* _indices;
+      std::size_t _capacity;
+
+      // The entries in insertion order, each with its cached full hash.
+      value_type* _values;
+      std::size_t* _hashes;
+      std::size_t _used;
+      std::size_t _size;
+
+      Hash _hasher;
+      KeyEqual _equal;
+      float _max_load_factor;
+      [[no_unique_address]] value_allocator _alloc;
+
+      template <typename K>
+      std::size_t hash_of(const K& key) const;
+      template <typename K>
+      std::size_t find_slot(const K& key, std::size_t hash) const;
+      template <typename K>
+      iterator erase_key(const K& key);
+      std::size_t prepare_append(std::size_t hash);
+      std::size_t next_alive(std::size_t entry) const;
+      std::size_t entry_capacity() const;
+
+      void allocate(std::size_t capacity);
+      void deallocate();
+      void destroy();
+      void resize(std::size_t new_capacity, float ml);
+      void swap_contents(DenseHashBrown& other) noexcept;
+
+      template <bool IsConst>
+      class Iterator {
+         public:
+            using difference_type = std::ptrdiff_t;
+            using value_type = DenseHashBrown::value_type;
+            using reference = std::conditional_t<IsConst, const_reference, DenseHashBrown::reference>;
+            using pointer = std::conditional_t<IsConst, const value_type*, DenseHashBrown::pointer>;
+            using iterator_category = std::forward_iterator_tag;
+            using map_pointer = std::conditional_t<IsConst, const DenseHashBrown*, DenseHashBrown*>;
+
+            Iterator() = default;
+
+            Iterator(map_pointer hb, std::size_t entry)
+               : _hb(hb)
+               , _entry(entry)
+            {
+            }
+
+            operator Iterator<true>() const requires (!IsConst)
+            {
+               return Iterator<true>{_hb, _entry};
+            }
+
+            Iterator& operator++()
+            {
+               _entry = _hb->next_alive(_entry + 1);
+               return *this;
+            }
+
+            Iterator operator++(int)
+            {
+               auto temp = *this;
+               ++*this;
+               return temp;
+            }
+
+            reference operator*() const
+            {
+               return _hb->_values[_entry];
+            }
+
+            pointer operator->() const
+            {
+               return &this->operator*();
+            }
+
+            friend bool operator==(const Iterator& it_a, const Iterator& it_b)
+            {
+               return it_a._hb == it_b._hb
+                  && it_a._entry == it_b._entry;
+            }
+
+            friend bool operator!=(const Iterator& it_a, const Iterator& it_b)
+            {
+               return !(it_a == it_b);
+            }
+
+         private:
+            map_pointer _hb = nullptr;
+            std::size_t _entry = 0;
+      };
+};
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+constexpr DenseHashBrown<Key, Value, Hash, KeyEqual, Allocator>::DenseHashBrown()
+   : DenseHashBrown(Allocator())
+{
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+DenseHashBrown<Key, Value, Hash, KeyEqual, Allocator>::DenseHashBrown(const Allocator& alloc)
+   : DenseHashBrown(Hash(), KeyEqual(), alloc)
+{
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+DenseHashBrown<Key, Value, Hash, KeyEqual, Allocator>::DenseHashBrown(const Hash& hash, const KeyEqual& equal, const Allocator& alloc)
+   : _ctrl(nullptr)
+   , _indices(nullptr)
+   , _capacity(0)
+   , _values(nullptr)
+   , _hashes(nullptr)
+   , _used(0)
+   , _size(0)
+   , _hasher(hash)
+   , _equal(equal)
+   , _max_load_factor(hashbrown::detail::default_max_load_factor)
+   , _alloc(alloc)
+{
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+DenseHashBrown<Key, Value, Hash, KeyEqual, Allocator>::DenseHashBrown(std::initializer_list<value_type> il, const Allocator& alloc)
+   : DenseHashBrown(alloc)
+{
+   insert(il);
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+DenseHashBrown<Key, Value, Hash, KeyEqual, Allocator>::DenseHashBrown(const DenseHashBrown& other)
+   : DenseHashBrown(other, value_traits::select_on_container_copy_construction(other._alloc))
+{
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+DenseHashBrown<Key, Value, Hash, KeyEqual, Allocator>::DenseHashBrown(const DenseHashBrown& other, const Allocator& alloc)
+   : DenseHashBrown(alloc)
+{
+   _hasher = other._hasher;
+   _equal = other._equal;
+   _max_load_factor = other._max_load_factor;
+
+   reserve(other._size);
+   for (auto entry = other.next_alive(0); entry < other._used; entry = other.next_alive(entry + 1))
+   {
+      const auto index = prepare_append(other._hashes[entry]);
+      value_traits::construct(_alloc, _values + index, other._values[entry]);
+      _hashes[index] = other._hashes[entry];
+      ++_used;
+      ++_size;
+   }
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+DenseHashBrown<Key, Value, Hash, KeyEqual, Allocator>::DenseHashBrown(DenseHashBrown&& other) noexcept
+   : _ctrl(std::exchange(other._ctrl, nullptr))
+   , _indices(std::exchange(other._indices, nullptr))
+   , _capacity(std::exchange(other._capacity, 0))
+   , _values(std::exchange(other._values, nullptr))
+   , _hashes(std::exchange(other._hashes, nullptr))
+   , _used(std::exchange(other._used, 0))
+   , _size(std::exchange(other._size, 0))
+   , _hasher(std::move(other._hasher))
+   , _equal(std::move(other._equal))
+   , _max_load_factor(other._max_load_factor)
+   , _alloc(std::move(other._alloc))
+{
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+DenseHashBrown<Key, Value, Hash, KeyEqual, Allocator>& DenseHashBrown<Key, Value, Hash, KeyEqual, Allocator>::operator=(const DenseHashBrown& other)
+{
+   if (this != &other)
+   {
+      if constexpr (value_traits::propagate_on_container_copy_assignment::value)
+      {
+         destroy();
+         _alloc = other._alloc;
+      }
+      DenseHashBrown copy{other, _alloc};
+      swap_contents(copy);
+   }
+   return *this;
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+DenseHashBrown<Key, Value, Hash, KeyEqual, Allocator>& DenseHashBrown<Key, Value, Hash, KeyEqual, Allocator>::operator=(DenseHashBrown&& other) noexcept(move_assign_noexcept)
+{
+   if (this == &other)
+   {
+      return *this;
+   }
+
+   if constexpr (value_traits::propagate_on_container_move_assignment::value)
+   {
+      destroy();
+      _alloc = std::move(other._alloc);
+      swap_contents(other);
+   }
+   else if (_alloc == other._alloc)
+   {
+      destroy();
+      swap_contents(other);
+   }
+   else
+   {
+      // Storage from another allocator cannot be adopted; move the entries.
+      clear();
+      reserve(other._size);
+      for (auto& entry : other)
+      {
+         insert(std::move(entry.first), std::move(entry.second));
+      }
+      other.clear();
+   }
+   return *this;
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+DenseHashBrown<Key, Value, Hash, KeyEqual, Allocator>::~DenseHashBrown()
+{
+   destroy();
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+typename DenseHashBrown<Key, Value, Hash, KeyEqual, Allocator>::iterator DenseHashBrown<Key, Value, Hash, KeyEqual, Allocator>::begin()
+{
+   return iterator(this, next_alive(0));
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+typename DenseHashBrown<Key, Value, Hash, KeyEqual, Allocator>::const_iterator DenseHashBrown<Key, Value, Hash, KeyEqual, Allocator>::begin() const
+{
+   return const_iterator(this, next_alive(0));
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+typename DenseHashBrown<Key, Value, Hash, KeyEqual, Allocator>::const_iterator DenseHashBrown<Key, Value, Hash, KeyEqual, Allocator>::cbegin() const
+{
+   return begin();
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+typename DenseHashBrown<Key, Value, Hash, KeyEqual, Allocator>::iterator DenseHashBrown<Key, Value, Hash, KeyEqual, Allocator>::end()
+{
+   return iterator(this, _used);
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+typename DenseHashBrown<Key, Value, Hash, KeyEqual, Allocator>::const_iterator DenseHashBrown<Key, Value, Hash, KeyEqual, Allocator>::end() const
+{
+   return const_iterator(this, _used);
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+typename DenseHashBrown<Key, Value, Hash, KeyEqual, Allocator>::const_iterator DenseHashBrown<Key, Value, Hash, KeyEqual, Allocator>::cend() const
+{
+   return end();
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+typename DenseHashBrown<Key, Value, Hash, KeyEqual, Allocator>::iterator DenseHashBrown<Key, Value, Hash, KeyEqual, Allocator>::erase(const Key& key)
+{
+   return erase_key(key);
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+template <typename K>
+typename DenseHashBrown<Key, Value, Hash, KeyEqual, Allocator>::iterator DenseHashBrown<Key, Value, Hash, KeyEqual, Allocator>::erase(const K& key)
+   requires transparent_lookup
+{
+   return erase_key(key);
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+void DenseHashBrown<Key, Value, Hash, KeyEqual, Allocator>::insert(std::initializer_list<value_type> il)
+{
+   insert(il.begin(), il.end());
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+template <std::input_iterator InputIt>
+void DenseHashBrown<Key, Value, Hash, KeyEqual, Allocator>::insert(InputIt first, InputIt last)
+{
+   if constexpr (std::forward_iterator<InputIt>)
+   {
+      reserve(_size + static_cast<std::size_t>(std::distance(first, last)));
+   }
+
+   for (; first != last; ++first)
+   {
+      insert(*first);
+   }
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+typename DenseHashBrown<Key, Value, Hash, KeyEqual, Allocator>::iterator DenseHashBrown<Key, Value, Hash, KeyEqual, Allocator>::insert(Key key, Value value)
+{
+   const auto hash = hash_of(key);
+   const auto found = find_slot(key, hash);
+
+   if (found != npos)
+   {
+      const auto entry = _indices[found];
+      std::swap(_values[entry].second, value);
+      return iterator {this, entry};
+   }
+
+   const auto entry = prepare_append(hash);
+   value_traits::construct(_alloc, _values + entry, std::move(key), std::move(value));
+   _hashes[entry] = hash;
+   ++_used;
+   ++_size;
+   return iterator {this, entry};
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+typename DenseHashBrown<Key, Value, Hash, KeyEqual, Allocator>::iterator DenseHashBrown<Key, Value, Hash, KeyEqual, Allocator>::insert(const value_type& value)
+{
+   return insert(value.first, value.second);
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+typename DenseHashBrown<Key, Value, Hash, KeyEqual, Allocator>::iterator DenseHashBrown<Key, Value, Hash, KeyEqual, Allocator>::insert(value_type&& value)
+{
+   return insert(std::move(value.first), std::move(value.second));
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+template <typename... Args>
+typename DenseHashBrown<Key, Value, Hash, KeyEqual, Allocator>::iterator DenseHashBrown<Key, Value, Hash, KeyEqual, Allocator>::emplace(Args&&... args)
+{
+   value_type pair(std::forward<Args>(args)...);
+   return insert(std::move(pair));
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+const Value* DenseHashBrown<Key, Value, Hash, KeyEqual, Allocator>::get(const Key& key) const
+{
+   const auto slot = find_slot(key, hash_of(key));
+   return slot == npos ? nullptr : &_values[_indices[slot]].second;
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+template <typename K>
+const Value* DenseHashBrown<Key, Value, Hash, KeyEqual, Allocator>::get(const K& key) const
+   requires transparent_lookup
+{
+   const auto slot = find_slot(key, hash_of(key));
+   return slot == npos ? nullptr : &_values[_indices[slot]].second;
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+bool DenseHashBrown<Key, Value, Hash, KeyEqual, Allocator>::contains(const Key& key) const
+{
+   return find_slot(key, hash_of(key)) != npos;
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+template <typename K>
+bool DenseHashBrown<Key, Value, Hash, KeyEqual, Allocator>::contains(const K& key) const
+   requires transparent_lookup
+{
+   return find_slot(key, hash_of(key)) != npos;
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+bool DenseHashBrown<Key, Value, Hash, KeyEqual, Allocator>::empty() const
+{
+   return _size == 0;
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+std::size_t DenseHashBrown<Key, Value, Hash, KeyEqual, Allocator>::size() const
+{
+   return _size;
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+std::size_t DenseHashBrown<Key, Value, Hash, KeyEqual, Allocator>::capacity() const
+{
+   return _capacity;
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+void DenseHashBrown<Key, Value, Hash, KeyEqual, Allocator>::clear()
+{
+   destroy();
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+void DenseHashBrown<Key, Value, Hash, KeyEqual, Allocator>::swap(DenseHashBrown& other) noexcept
+{
+   if constexpr (value_traits::propagate_on_container_swap::value)
+   {
+      using std::swap;
+      swap(_alloc, other._alloc);
+   }
+   swap_contents(other);
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+typename DenseHashBrown<Key, Value, Hash, KeyEqual, Allocator>::allocator_type DenseHashBrown<Key, Value, Hash, KeyEqual, Allocator>::get_allocator() const
+{
+   return allocator_type(_alloc);
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+Hash DenseHashBrown<Key, Value, Hash, KeyEqual, Allocator>::hash_function() const
+{
+   return _hasher;
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+KeyEqual DenseHashBrown<Key, Value, Hash, KeyEqual, Allocator>::key_eq() const
+{
+   return _equal;
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+float DenseHashBrown<Key, Value, Hash, KeyEqual, Allocator>::load_factor() const
+{
+   if (_capacity == 0)
+   {
+      return 0.0f;
+   }
+   return static_cast<float>(_size) / static_cast<float>(_capacity);
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+float DenseHashBrown<Key, Value, Hash, KeyEqual, Allocator>::max_load_factor() const
+{
+   return _max_load_factor;
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+void DenseHashBrown<Key, Value, Hash, KeyEqual, Allocator>::max_load_factor(float ml)
+{
+   hashbrown::detail::check_max_load_factor(ml);
+
+   // The entry arrays were sized by the old factor, so they have to be freed
+   // under it: the rebuild takes the new factor and swaps it in.
+   if (_capacity != 0)
+   {
+      resize(std::max(_capacity, hashbrown::detail::capacity_for(_size, ml)), ml);
+   }
+   else
+   {
+      _max_load_factor = ml;
+   }
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+void DenseHashBrown<Key, Value, Hash, KeyEqual, Allocator>::rehash(std::size_t count)
+{
+   if (_size == 0 && count == 0)
+   {
+      destroy();
+      return;
+   }
+
+   auto target = hashbrown::detail::capacity_for(_size, _max_load_factor);
+   while (target < count)
+   {
+      target *= 2;
+   }
+
+   if (target != _capacity || _used != _size)
+   {
+      resize(target, _max_load_factor);
+   }
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+void DenseHashBrown<Key, Value, Hash, KeyEqual, Allocator>::reserve(std::size_t count)
+{
+   if (count > entry_capacity() - (_used - _size))
+   {
+      rehash(hashbrown::detail::capacity_for(count, _max_load_factor));
+   }
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+template <typename K>
+std::size_t DenseHashBrown<Key, Value, Hash, KeyEqual, Allocator>::hash_of(const K& key) const
+{
+   const std::size_t hash = _hasher(key);
+   return hash == hole ? hole - 1 : hash;
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+template <typename K>
+std::size_t DenseHashBrown<Key, Value, Hash, KeyEqual, Allocator>::find_slot(const K& key, std::size_t hash) const
+{
+   if (_capacity == 0)
+   {
+      return npos;
+   }
+
+   const auto h2 = hashbrown::detail::h2(hash);
+   hashbrown::detail::ProbeSeq seq{hash, _capacity / Group::width - 1};
+
+   while (true)
+   {
+      const Group group{_ctrl + seq.offset()};
+      for (const auto i : group.match(h2))
+      {
+         const auto slot = seq.offset() + i;
+         const auto entry = _indices[slot];
+         if (_hashes[entry] == hash && _equal(_values[entry].first, key))
+         {
+            return slot;
+         }
+      }
+
+      if (group.match_empty())
+      {
+         return npos;
+      }
+      seq.next();
+   }
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+template <typename K>
+typename DenseHashBrown<Key, Value, Hash, KeyEqual, Allocator>::iterator DenseHashBrown<Key, Value, Hash, KeyEqual, Allocator>::erase_key(const K& key)
+{
+   const auto slot = find_slot(key, hash_of(key));
+   if (slot == npos)
+   {
+      return end();
+   }
+
+   const auto entry = _indices[slot];
+   value_traits::destroy(_alloc, _values + entry);
+   _hashes[entry] = hole;
+   --_size;
+
+   const Group group{_ctrl + slot / Group::width * Group::width};
+   _ctrl[slot] = group.match_empty() ? hashbrown::detail::kEmpty : hashbrown::detail::kDeleted;
+   return iterator {this, next_alive(entry)};
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+std::size_t DenseHashBrown<Key, Value, Hash, KeyEqual, Allocator>::prepare_append(std::size_t hash)
+{
+   if (_used == entry_capacity())
+   {
+      // Out of room to append: grow if live entries are dense enough,
+      // otherwise a same-size rebuild squeezes out the holes.
+      const auto target = _size + 1 > entry_capacity() / 2
+         ? std::max(2 * _capacity, hashbrown::detail::capacity_for(_size + 1, _max_load_factor))
+         : _capacity;
+      resize(target, _max_load_factor);
+   }
+
+   const auto slot = hashbrown::detail::find_first_non_full(_ctrl, _capacity, hash);
+   _ctrl[slot] = hashbrown::detail::h2(hash);
+   _indices[slot] = static_cast<index_t>(_used);
+   return _used;
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+std::size_t DenseHashBrown<Key, Value, Hash, KeyEqual, Allocator>::next_alive(std::size_t entry) const
+{
+   while (entry < _used && _hashes[entry] == hole)
+   {
+      ++entry;
+   }
+   return entry;
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+std::size_t DenseHashBrown<Key, Value, Hash, KeyEqual, Allocator>::entry_capacity() const
+{
+   return _capacity == 0 ? 0 : hashbrown::detail::max_items(_capacity, _max_load_factor);
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+void DenseHashBrown<Key, Value, Hash, KeyEqual, Allocator>::allocate(std::size_t capacity)
+{
+   if (hashbrown::detail::max_items(capacity, _max_load_factor) > std::numeric_limits<index_t>::max())
+   {
+      throw std::length_error("DenseHashBrown: too many entries for 32-bit indices");
+   }
+
+   ctrl_allocator ctrl_alloc{_alloc};
+   index_allocator index_alloc{_alloc};
+   hash_allocator hash_alloc{_alloc};
+   const auto entries = hashbrown::detail::max_items(capacity, _max_load_factor);
+
+   _ctrl = std::allocator_traits<ctrl_allocator>::allocate(ctrl_alloc, capacity);
+   try
+   {
+      _indices = std::allocator_traits<index_allocator>::allocate(index_alloc, capacity);
+      try
+      {
+         _hashes = std::allocator_traits<hash_allocator>::allocate(hash_alloc, entries);
+         try
+         {
+            _values = value_traits::allocate(_alloc, entries);
+         }
+         catch (...)
+         {
+            std::allocator_traits<hash_allocator>::deallocate(hash_alloc, _hashes, entries);
+            throw;
+         }
+      }
+      catch (...)
+      {
+         std::allocator_traits<index_allocator>::deallocate(index_alloc, _indices, capacity);
+         throw;
+      }
+   }
+   catch (...)
+   {
+      std::allocator_traits<ctrl_allocator>::deallocate(ctrl_alloc, _ctrl, capacity);
+      _ctrl = nullptr;
+      _indices = nullptr;
+      _hashes = nullptr;
+      throw;
+   }
+
+   std::fill_n(_ctrl, capacity, hashbrown::detail::kEmpty);
+   _capacity = capacity;
+   _used = 0;
+   _size = 0;
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+void DenseHashBrown<Key, Value, Hash, KeyEqual, Allocator>::deallocate()
+{
+   if (_capacity == 0)
+   {
+      return;
+   }
+
+   ctrl_allocator ctrl_alloc{_alloc};
+   index_allocator index_alloc{_alloc};
+   hash_allocator hash_alloc{_alloc};
+   const auto entries = entry_capacity();
+
+   value_traits::deallocate(_alloc, _values, entries);
+   std::allocator_traits<hash_allocator>::deallocate(hash_alloc, _hashes, entries);
+   std::allocator_traits<index_allocator>::deallocate(index_alloc, _indices, _capacity);
+   std::allocator_traits<ctrl_allocator>::deallocate(ctrl_alloc, _ctrl, _capacity);
+
+   _ctrl = nullptr;
+   _indices = nullptr;
+   _values = nullptr;
+   _hashes = nullptr;
+   _capacity = 0;
+   _used = 0;
+   _size = 0;
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+void DenseHashBrown<Key, Value, Hash, KeyEqual, Allocator>::destroy()
+{
+   for (std::size_t entry = 0; entry < _used; ++entry)
+   {
+      if (_hashes[entry] != hole)
+      {
+         value_traits::destroy(_alloc, _values + entry);
+      }
+   }
+   deallocate();
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+void DenseHashBrown<Key, Value, Hash, KeyEqual, Allocator>::resize(std::size_t new_capacity, float ml)
+{
+   // Rebuilding walks the entries in order and re-appends the live ones, so
+   // holes disappear and order is kept. Stored hashes mean no key is hashed.
+   DenseHashBrown rebuilt{_alloc};
+   rebuilt._hasher = _hasher;
+   rebuilt._equal = _equal;
+   rebuilt._max_load_factor = ml;
+   rebuilt.allocate(new_capacity);
+
+   for (auto entry = next_alive(0); entry < _used; entry = next_alive(entry + 1))
+   {
+      const auto hash = _hashes[entry];
+      const auto slot = hashbrown::detail::find_first_non_full(rebuilt._ctrl, rebuilt._capacity, hash);
+      rebuilt._ctrl[slot] = hashbrown::detail::h2(hash);
+      rebuilt._indices[slot] = static_cast<index_t>(rebuilt._used);
+      value_traits::construct(_alloc, rebuilt._values + rebuilt._used, std::move(_values[entry]));
+      rebuilt._hashes[rebuilt._used] = hash;
+      ++rebuilt._used;
+      ++rebuilt._size;
+   }
+
+   swap_contents(rebuilt);
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+void DenseHashBrown<Key, Value, Hash, KeyEqual, Allocator>::swap_contents(DenseHashBrown& other) noexcept
+{
+   using std::swap;
+   swap(_ctrl, other._ctrl);
+   swap(_indices, other._indices);
+   swap(_capacity, other._capacity);
+   swap(_values, other._values);
+   swap(_hashes, other._hashes);
+   swap(_used, other._used);
+   swap(_size, other._size);
+   swap(_hasher, other._hasher);
+   swap(_equal, other._equal);
+   swap(_max_load_factor, other._max_load_factor);
+}
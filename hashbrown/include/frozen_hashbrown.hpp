@@ -0,0 +1,624 @@
+#pragma once
+
+#include <hashbrown.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace hashbrown::detail
+{
+   // Perfect hashing by hash-and-displace (CHD/PTHash style). Keys are split
+   // into small buckets by their hash; every bucket gets a pilot, chosen so
+   // that hashing each of its keys together with the pilot lands on a slot no
+   // other key uses. Pilots are searched over a few percent more slots than
+   // keys, which keeps the search short, and the keys that land past the end
+   // are remapped onto the holes left below it. A lookup then reads the key's
+   // bucket pilot and exactly one entry. Everything here is constexpr so
+   // frozen maps can also be built during constant evaluation.
+   using pilot_t = std::uint16_t;
+
+   inline constexpr std::size_t keys_per_bucket = 3;
+   inline constexpr std::size_t max_seed_attempts = 64;
+
+   // Maps a well-mixed 64-bit value onto [0, range) without a division.
+   constexpr std::size_t fastrange(std::uint64_t value, std::size_t range)
+   {
+      std::uint64_t high = range;
+      multiply(value, high);
+      return static_cast<std::size_t>(high);
+   }
+
+   constexpr std::size_t perfect_buckets(std::size_t keys)
+   {
+      return keys / keys_per_bucket + 2;
+   }
+
+   // How many slots past the last key may be hit and need remapping.
+   constexpr std::size_t perfect_spill(std::size_t keys)
+   {
+      return keys / 64;
+   }
+
+   // Skewed like PTHash: 60% of the keys share 30% of the buckets. The big
+   // buckets are placed first, while free slots are easy to find, and the
+   // many small ones left for the end are quicker to fit into the gaps.
+   constexpr std::size_t perfect_bucket(std::uint64_t hash, std::size_t buckets)
+   {
+      const auto dense = buckets * 3 / 10 + 1;
+      const auto mixed = hash * 0x9E3779B97F4A7C15ull;
+      return hash < 0x9999999999999999ull ? fastrange(mixed, dense) : dense + fastrange(mixed, buckets - dense);
+   }
+
+   constexpr std::size_t perfect_slot(std::uint64_t hash, pilot_t pilot, std::size_t slots)
+   {
+      return fastrange(hash_int(hash, pilot), slots);
+   }
+
+   // Where the key with this (seeded) hash lives among keys entries.
+   constexpr std::size_t perfect_position(std::uint64_t hash,
+                                          std::span<const pilot_t> pilots,
+                                          std::span<const std::size_t> remap,
+                                          std::size_t keys)
+   {
+      const auto pilot = pilots[perfect_bucket(hash, pilots.size())];
+      const auto slot = perfect_slot(hash, pilot, keys + remap.size());
+      return slot < keys ? slot : remap[slot - keys];
+   }
+
+   // Fills pilots, remap and, for every hash, the position it ends up in.
+   // Fails when two hashes are equal or some bucket has no free pilot; the
+   // caller then retries with differently seeded hashes. That only helps if
+   // the unseeded hashes were distinct: equal ones stay equal under every
+   // seed, so callers have to set such keys aside first.
+   constexpr bool find_pilots(std::span<const std::uint64_t> hashes,
+                              std::span<pilot_t> pilots,
+                              std::span<std::size_t> remap,
+                              std::span<std::size_t> position_of)
+   {
+      const auto keys = hashes.size();
+      const auto buckets = pilots.size();
+      const auto slots = keys + remap.size();
+
+      // Counting sort of the keys by bucket.
+      std::vector<std::size_t> start(buckets + 1, 0);
+      for (const auto hash : hashes)
+      {
+         ++start[perfect_bucket(hash, buckets) + 1];
+      }
+      for (std::size_t b = 0; b < buckets; ++b)
+      {
+         start[b + 1] += start[b];
+      }
+      // The hashes are copied next to each other as well, so trying a pilot
+      // reads one short run instead of gathering from all over the input.
+      std::vector<std::size_t> members(keys);
+      std::vector<std::uint64_t> member_hashes(keys);
+      {
+         auto fill = start;
+         for (std::size_t k = 0; k < keys; ++k)
+         {
+            const auto at = fill[perfect_bucket(hashes[k], buckets)]++;
+            members[at] = k;
+            member_hashes[at] = hashes[k];
+         }
+      }
+
+      // Big buckets are hardest to place, so they go first while the table
+      // is still empty.
+      std::vector<std::size_t> order(buckets);
+      for (std::size_t b = 0; b < buckets; ++b)
+      {
+         order[b] = b;
+      }
+      std::sort(order.begin(), order.end(), [&start](std::size_t a, std::size_t b) {
+         return start[a + 1] - start[a] > start[b + 1] - start[b];
+      });
+
+      std::fill(pilots.begin(), pilots.end(), pilot_t{0});
+      std::vector<unsigned char> taken(slots, 0);
+      std::vector<std::size_t> candidate;
+      for (const auto b : order)
+      {
+         const auto first = start[b];
+         const auto last = start[b + 1];
+         if (first == last)
+         {
+            break;
+         }
+
+         bool placed = false;
+         for (std::uint32_t pilot = 0; pilot <= std::numeric_limits<pilot_t>::max() && !placed; ++pilot)
+         {
+            candidate.clear();
+            placed = true;
+            for (auto m = first; m < last && placed; ++m)
+            {
+               const auto slot = perfect_slot(member_hashes[m], static_cast<pilot_t>(pilot), slots);
+               placed = taken[slot] == 0 && std::find(candidate.begin(), candidate.end(), slot) == candidate.end();
+               candidate.push_back(slot);
+            }
+
+            if (placed)
+            {
+               pilots[b] = static_cast<pilot_t>(pilot);
+               for (auto m = first; m < last; ++m)
+               {
+                  const auto slot = candidate[m - first];
+                  taken[slot] = 1;
+                  position_of[members[m]] = slot;
+               }
+            }
+         }
+
+         if (!placed)
+         {
+            return false;
+         }
+      }
+
+      // As many keys landed past the end as there are holes before it.
+      std::size_t hole = 0;
+      for (std::size_t spill = 0; spill < remap.size(); ++spill)
+      {
+         remap[spill] = 0;
+         if (taken[keys + spill] != 0)
+         {
+            while (taken[hole] != 0)
+            {
+               ++hole;
+            }
+            remap[spill] = hole++;
+         }
+      }
+      for (auto& position : position_of)
+      {
+         if (position >= keys)
+         {
+            position = remap[position - keys];
+         }
+      }
+      return true;
+   }
+}
+
+// An immutable map over a key set fixed at compile time. The layout is
+// found during constant evaluation, so a constexpr instance lives in
+// read-only data, needs no initialisation at start-up, and answers get()
+// with one bucket pilot and one slot.
+template <typename Key, typename Value, std::size_t N, typename Hash = HashFunction<Key>, typename KeyEqual = std::equal_to<>>
+class FrozenHashBrown
+{
+   static constexpr bool transparent_lookup =
+      hashbrown::detail::transparent<Hash> && hashbrown::detail::transparent<KeyEqual>;
+
+   public:
+      using value_type = std::pair<Key, Value>;
+      using const_iterator = const value_type*;
+
+      constexpr explicit FrozenHashBrown(const std::array<value_type, N>& entries);
+
+      constexpr const Value* get(const Key& key) const;
+      template <typename K>
+      constexpr const Value* get(const K& key) const requires transparent_lookup;
+      constexpr bool contains(const Key& key) const;
+      template <typename K>
+      constexpr bool contains(const K& key) const requires transparent_lookup;
+      constexpr bool empty() const;
+      constexpr std::size_t size() const;
+
+      constexpr const_iterator begin() const;
+      constexpr const_iterator end() const;
+
+   private:
+      static constexpr std::size_t buckets = hashbrown::detail::perfect_buckets(N);
+
+      std::array<value_type, N> _slots;
+      std::array<hashbrown::detail::pilot_t, buckets> _pilots;
+      std::array<std::size_t, hashbrown::detail::perfect_spill(N)> _remap;
+      std::uint64_t _seed;
+      Hash _hasher;
+      KeyEqual _equal;
+
+      template <typename K>
+      constexpr const Value* find(const K& key) const;
+};
+
+template <typename Key, typename Value, std::size_t N, typename Hash, typename KeyEqual>
+constexpr FrozenHashBrown<Key, Value, N, Hash, KeyEqual>::FrozenHashBrown(const std::array<value_type, N>& entries)
+   : _slots()
+   , _pilots()
+   , _remap()
+   , _seed(0)
+   , _hasher()
+   , _equal()
+{
+   for (std::size_t i = 0; i < N; ++i)
+   {
+      for (std::size_t j = 0; j < i; ++j)
+      {
+         if (_equal(entries[i].first, entries[j].first))
+         {
+            throw std::invalid_argument("FrozenHashBrown: duplicate key");
+         }
+      }
+   }
+
+   std::array<std::uint64_t, N> hashes{};
+   for (std::size_t i = 0; i < N; ++i)
+   {
+      hashes[i] = _hasher(entries[i].first);
+      for (std::size_t j = 0; j < i; ++j)
+      {
+         if (hashes[i] == hashes[j])
+         {
+            throw std::invalid_argument("FrozenHashBrown: two keys have the same hash, so no seed can separate them");
+         }
+      }
+   }
+
+   std::array<std::size_t, N> position_of{};
+   for (std::size_t attempt = 0; attempt < hashbrown::detail::max_seed_attempts; ++attempt)
+   {
+      _seed = hashbrown::detail::secret[attempt % 3] * (attempt + 1);
+      std::array<std::uint64_t, N> seeded{};
+      for (std::size_t i = 0; i < N; ++i)
+      {
+         seeded[i] = hashbrown::hash_int(hashes[i], _seed);
+      }
+
+      if (hashbrown::detail::find_pilots(seeded, _pilots, _remap, position_of))
+      {
+         for (std::size_t i = 0; i < N; ++i)
+         {
+            _slots[position_of[i]] = entries[i];
+         }
+         return;
+      }
+   }
+   throw std::invalid_argument("FrozenHashBrown: no perfect hash found for these keys");
+}
+
+template <typename Key, typename Value, std::size_t N, typename Hash, typename KeyEqual>
+constexpr const Value* FrozenHashBrown<Key, Value, N, Hash, KeyEqual>::get(const Key& key) const
+{
+   return find(key);
+}
+
+template <typename Key, typename Value, std::size_t N, typename Hash, typename KeyEqual>
+template <typename K>
+constexpr const Value* FrozenHashBrown<Key, Value, N, Hash, KeyEqual>::get(const K& key) const
+   requires transparent_lookup
+{
+   return find(key);
+}
+
+template <typename Key, typename Value, std::size_t N, typename Hash, typename KeyEqual>
+constexpr bool FrozenHashBrown<Key, Value, N, Hash, KeyEqual>::contains(const Key& key) const
+{
+   return find(key) != nullptr;
+}
+
+template <typename Key, typename Value, std::size_t N, typename Hash, typename KeyEqual>
+template <typename K>
+constexpr bool FrozenHashBrown<Key, Value, N, Hash, KeyEqual>::contains(const K& key) const
+   requires transparent_lookup
+{
+   return find(key) != nullptr;
+}
+
+template <typename Key, typename Value, std::size_t N, typename Hash, typename KeyEqual>
+constexpr bool FrozenHashBrown<Key, Value, N, Hash, KeyEqual>::empty() const
+{
+   return N == 0;
+}
+
+template <typename Key, typename Value, std::size_t N, typename Hash, typename KeyEqual>
+constexpr std::size_t FrozenHashBrown<Key, Value, N, Hash, KeyEqual>::size() const
+{
+   return N;
+}
+
+template <typename Key, typename Value, std::size_t N, typename Hash, typename KeyEqual>
+constexpr typename FrozenHashBrown<Key, Value, N, Hash, KeyEqual>::const_iterator FrozenHashBrown<Key, Value, N, Hash, KeyEqual>::begin() const
+{
+   return _slots.data();
+}
+
+template <typename Key, typename Value, std::size_t N, typename Hash, typename KeyEqual>
+constexpr typename FrozenHashBrown<Key, Value, N, Hash, KeyEqual>::const_iterator FrozenHashBrown<Key, Value, N, Hash, KeyEqual>::end() const
+{
+   return _slots.data() + N;
+}
+
+template <typename Key, typename Value, std::size_t N, typename Hash, typename KeyEqual>
+template <typename K>
+constexpr const Value* FrozenHashBrown<Key, Value, N, Hash, KeyEqual>::find(const K& key) const
+{
+   if constexpr (N == 0)
+   {
+      return nullptr;
+   }
+   else
+   {
+      const auto hash = hashbrown::hash_int(_hasher(key), _seed);
+      const auto& entry = _slots[hashbrown::detail::perfect_position(hash, _pilots, _remap, N)];
+      return _equal(entry.first, key) ? &entry.second : nullptr;
+   }
+}
+
+// Builds a FrozenHashBrown from a braced list, e.g.
+//    constexpr auto opcodes = make_frozen_hashbrown<std::string_view, int>({{"add", 1}, {"sub", 2}});
+template <typename Key, typename Value, typename Hash = HashFunction<Key>, typename KeyEqual = std::equal_to<>, std::size_t N>
+constexpr auto make_frozen_hashbrown(const std::pair<Key, Value> (&entries)[N])
+{
+   std::array<std::pair<Key, Value>, N> array{};
+   for (std::size_t i = 0; i < N; ++i)
+   {
+      array[i] = entries[i];
+   }
+   return FrozenHashBrown<Key, Value, N, Hash, KeyEqual>(array);
+}
+
+// The runtime counterpart of FrozenHashBrown, produced by HashBrown::freeze().
+// Entries sit in one array with no empty slots, a lookup reads one pilot and
+// one entry, and the index costs about six bits per key instead of a
+// control byte per slot.
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+class PerfectHashBrown
+{
+   static constexpr bool transparent_lookup =
+      hashbrown::detail::transparent<Hash> && hashbrown::detail::transparent<KeyEqual>;
+
+   using slot_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<std::pair<Key, Value>>;
+   using pilot_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<hashbrown::detail::pilot_t>;
+   using remap_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<std::size_t>;
+   using hash_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<std::uint64_t>;
+
+   public:
+      using value_type = std::pair<Key, Value>;
+      using const_iterator = const value_type*;
+      using allocator_type = Allocator;
+
+      const Value* get(const Key& key) const;
+      template <typename K>
+      const Value* get(const K& key) const requires transparent_lookup;
+      bool contains(const Key& key) const;
+      template <typename K>
+      bool contains(const K& key) const requires transparent_lookup;
+      bool empty() const;
+      std::size_t size() const;
+
+      const_iterator begin() const;
+      const_iterator end() const;
+
+      allocator_type get_allocator() const;
+      Hash hash_function() const;
+      KeyEqual key_eq() const;
+
+   private:
+      friend class HashBrown<Key, Value, Hash, KeyEqual, Allocator>;
+
+      // The keys placed by the perfect hash come first. Keys whose hash
+      // equals an earlier key's cannot be separated by any seed; they follow,
+      // ordered by the hashes in _overflow_hashes, and are binary searched.
+      std::vector<value_type, slot_allocator> _slots;
+      std::vector<hashbrown::detail::pilot_t, pilot_allocator> _pilots;
+      std::vector<std::size_t, remap_allocator> _remap;
+      std::vector<std::uint64_t, hash_allocator> _overflow_hashes;
+      std::uint64_t _seed;
+      Hash _hasher;
+      KeyEqual _equal;
+
+      // Moves the distinct entries pointed to into place; hashes holds what
+      // hash gives their keys. The entries are left untouched if no perfect
+      // hash is found.
+      PerfectHashBrown(std::span<value_type* const> entries,
+                       std::span<const std::uint64_t> hashes,
+                       const Hash& hash,
+                       const KeyEqual& equal,
+                       const slot_allocator& alloc);
+
+      template <typename K>
+      const Value* find(const K& key) const;
+};
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+PerfectHashBrown<Key, Value, Hash, KeyEqual, Allocator>::PerfectHashBrown(std::span<value_type* const> entries,
+                                                                          std::span<const std::uint64_t> hashes,
+                                                                          const Hash& hash,
+                                                                          const KeyEqual& equal,
+                                                                          const slot_allocator& alloc)
+   : _slots(alloc)
+   , _pilots(pilot_allocator(alloc))
+   , _remap(remap_allocator(alloc))
+   , _overflow_hashes(hash_allocator(alloc))
+   , _seed(0)
+   , _hasher(hash)
+   , _equal(equal)
+{
+   // Sorting by hash brings equal hashes together; the first key of each
+   // run gets the perfect hash and the rest overflow, still sorted.
+   std::vector<std::size_t> order(entries.size());
+   for (std::size_t i = 0; i < order.size(); ++i)
+   {
+      order[i] = i;
+   }
+   std::stable_sort(order.begin(), order.end(), [&hashes](std::size_t a, std::size_t b) {
+      return hashes[a] < hashes[b];
+   });
+   std::vector<std::size_t> perfect;
+   std::vector<std::size_t> overflow;
+   perfect.reserve(order.size());
+   for (std::size_t i = 0; i < order.size(); ++i)
+   {
+      auto& bin = i != 0 && hashes[order[i]] == hashes[order[i - 1]] ? overflow : perfect;
+      bin.push_back(order[i]);
+   }
+
+   const auto keys = perfect.size();
+   _pilots.resize(hashbrown::detail::perfect_buckets(keys));
+   _remap.resize(hashbrown::detail::perfect_spill(keys));
+   std::vector<std::uint64_t> seeded(keys);
+   std::vector<std::size_t> position_of(keys);
+
+   bool found = false;
+   for (std::size_t attempt = 0; attempt < hashbrown::detail::max_seed_attempts && !found; ++attempt)
+   {
+      _seed = hashbrown::detail::secret[attempt % 3] * (attempt + 1);
+      for (std::size_t i = 0; i < keys; ++i)
+      {
+         seeded[i] = hashbrown::hash_int(hashes[perfect[i]], _seed);
+      }
+      found = hashbrown::detail::find_pilots(seeded, _pilots, _remap, position_of);
+   }
+   if (!found)
+   {
+      throw std::invalid_argument("PerfectHashBrown: no perfect hash found for these keys");
+   }
+
+   // Filling the array front to back keeps the writes sequential.
+   std::vector<value_type*> source(keys);
+   for (std::size_t i = 0; i < keys; ++i)
+   {
+      source[position_of[i]] = entries[perfect[i]];
+   }
+   _slots.reserve(entries.size());
+   for (const auto entry : source)
+   {
+      _slots.push_back(std::move(*entry));
+   }
+   _overflow_hashes.reserve(overflow.size());
+   for (const auto i : overflow)
+   {
+      _slots.push_back(std::move(*entries[i]));
+      _overflow_hashes.push_back(hashes[i]);
+   }
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+const Value* PerfectHashBrown<Key, Value, Hash, KeyEqual, Allocator>::get(const Key& key) const
+{
+   return find(key);
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+template <typename K>
+const Value* PerfectHashBrown<Key, Value, Hash, KeyEqual, Allocator>::get(const K& key) const
+   requires transparent_lookup
+{
+   return find(key);
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+bool PerfectHashBrown<Key, Value, Hash, KeyEqual, Allocator>::contains(const Key& key) const
+{
+   return find(key) != nullptr;
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+template <typename K>
+bool PerfectHashBrown<Key, Value, Hash, KeyEqual, Allocator>::contains(const K& key) const
+   requires transparent_lookup
+{
+   return find(key) != nullptr;
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+bool PerfectHashBrown<Key, Value, Hash, KeyEqual, Allocator>::empty() const
+{
+   return _slots.empty();
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+std::size_t PerfectHashBrown<Key, Value, Hash, KeyEqual, Allocator>::size() const
+{
+   return _slots.size();
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+typename PerfectHashBrown<Key, Value, Hash, KeyEqual, Allocator>::const_iterator PerfectHashBrown<Key, Value, Hash, KeyEqual, Allocator>::begin() const
+{
+   return _slots.data();
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+typename PerfectHashBrown<Key, Value, Hash, KeyEqual, Allocator>::const_iterator PerfectHashBrown<Key, Value, Hash, KeyEqual, Allocator>::end() const
+{
+   return _slots.data() + _slots.size();
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+typename PerfectHashBrown<Key, Value, Hash, KeyEqual, Allocator>::allocator_type PerfectHashBrown<Key, Value, Hash, KeyEqual, Allocator>::get_allocator() const
+{
+   return allocator_type(_slots.get_allocator());
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+Hash PerfectHashBrown<Key, Value, Hash, KeyEqual, Allocator>::hash_function() const
+{
+   return _hasher;
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+KeyEqual PerfectHashBrown<Key, Value, Hash, KeyEqual, Allocator>::key_eq() const
+{
+   return _equal;
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+template <typename K>
+const Value* PerfectHashBrown<Key, Value, Hash, KeyEqual, Allocator>::find(const K& key) const
+{
+   if (_slots.empty())
+   {
+      return nullptr;
+   }
+
+   const std::uint64_t hash = _hasher(key);
+   const auto perfect = _slots.size() - _overflow_hashes.size();
+   const auto& entry = _slots[hashbrown::detail::perfect_position(hashbrown::hash_int(hash, _seed), _pilots, _remap, perfect)];
+   if (_equal(entry.first, key))
+   {
+      return &entry.second;
+   }
+
+   const auto [first, last] = std::equal_range(_overflow_hashes.begin(), _overflow_hashes.end(), hash);
+   for (auto it = first; it != last; ++it)
+   {
+      const auto& candidate = _slots[perfect + static_cast<std::size_t>(it - _overflow_hashes.begin())];
+      if (_equal(candidate.first, key))
+      {
+         return &candidate.second;
+      }
+   }
+   return nullptr;
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+PerfectHashBrown<Key, Value, Hash, KeyEqual, Allocator> HashBrown<Key, Value, Hash, KeyEqual, Allocator>::freeze() &&
+{
+   std::vector<value_type*> entries;
+   std::vector<std::uint64_t> hashes;
+   entries.reserve(size());
+   hashes.reserve(size());
+   for (auto index = next_full(0); index < _table.capacity + _old.capacity; index = next_full(index + 1))
+   {
+      auto& table = index < _table.capacity ? _table : _old;
+      const auto at = index < _table.capacity ? index : index - _table.capacity;
+      hashes.push_back(hash_at(table, at));
+      entries.push_back(table.slots + at);
+   }
+
+   PerfectHashBrown<Key, Value, Hash, KeyEqual, Allocator> frozen(entries, hashes, _hasher, _equal, _alloc);
+   clear();
+   return frozen;
+}
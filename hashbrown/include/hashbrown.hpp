@@ -1,351 +1,2913 @@
+#pragma once
+
 #include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <charconv>
+#include <chrono>
+#include <concepts>
 #include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <fstream>
 #include <functional>
 #include <initializer_list>
 #include <iterator>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <optional>
+#include <random>
 #include <ranges>
+#include <span>
 #include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <thread>
+#include <type_traits>
 #include <vector>
 #include <utility>
 
-template <typename T>
-struct HashFunction;
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+template <typename T>
+struct HashFunction;
+
+namespace hashbrown::detail
+{
+   inline constexpr std::size_t cache_line_size = 64;
+
+   // Every slot has one control byte. Full slots store the low 7 bits of the
+   // hash (h2), so the sign bit tells special bytes from full ones.
+   using ctrl_t = std::int8_t;
+
+   inline constexpr ctrl_t kEmpty = -128;
+   inline constexpr ctrl_t kDeleted = -2;
+
+   // Hash and equality functors that declare is_transparent accept any type
+   // comparable with the key, so lookups need not construct a Key.
+   template <typename T>
+   concept transparent = requires { typename T::is_transparent; };
+
+   // Random access in the classic iterator sense, which std::move_iterator
+   // keeps even though C++20 only counts it as an input iterator.
+   template <typename It>
+   concept random_access = std::input_iterator<It>
+      && std::derived_from<typename std::iterator_traits<It>::iterator_category, std::random_access_iterator_tag>;
+
+   // Whether a map keeps every entry's full hash next to it, so growth never
+   // calls the hasher again and lookups compare hashes before keys. A hasher
+   // decides with a static constexpr bool store_hash member; otherwise only
+   // keys that are not cheap scalars get it.
+   template <typename Key, typename Hash>
+   constexpr bool stores_hash()
+   {
+      if constexpr (requires { { Hash::store_hash } -> std::convertible_to<bool>; })
+      {
+         return Hash::store_hash;
+      }
+      else
+      {
+         return !std::is_scalar_v<Key>;
+      }
+   }
+
+   constexpr bool is_full(ctrl_t ctrl)
+   {
+      return ctrl >= 0;
+   }
+
+   constexpr std::size_t h1(std::size_t hash)
+   {
+      return hash >> 7;
+   }
+
+   constexpr ctrl_t h2(std::size_t hash)
+   {
+      return static_cast<ctrl_t>(hash & 0x7F);
+   }
+
+   class BitMask
+   {
+      public:
+         constexpr explicit BitMask(std::uint32_t mask)
+            : _mask(mask)
+         {
+         }
+
+         constexpr explicit operator bool() const
+         {
+            return _mask != 0;
+         }
+
+         constexpr std::uint32_t lowest() const
+         {
+            return static_cast<std::uint32_t>(std::countr_zero(_mask));
+         }
+
+         constexpr BitMask& operator++()
+         {
+            _mask &= _mask - 1;
+            return *this;
+         }
+
+         constexpr std::uint32_t operator*() const
+         {
+            return lowest();
+         }
+
+         constexpr BitMask begin() const
+         {
+            return *this;
+         }
+
+         constexpr BitMask end() const
+         {
+            return BitMask{0};
+         }
+
+         friend constexpr bool operator==(const BitMask& a, const BitMask& b)
+         {
+            return a._mask == b._mask;
+         }
+
+      private:
+         std::uint32_t _mask;
+   };
+
+   // Sixteen control bytes inspected at once. With SSE2 every query is one
+   // compare plus a movemask; otherwise we fall back to a plain byte loop.
+   class Group
+   {
+      public:
+         static constexpr std::size_t width = 16;
+
+         explicit Group(const ctrl_t* pos)
+         {
+#if defined(__SSE2__)
+            _ctrl = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pos));
+#else
+            std::memcpy(_ctrl, pos, width);
+#endif
+         }
+
+         BitMask match(ctrl_t hash) const
+         {
+#if defined(__SSE2__)
+            const auto cmp = _mm_cmpeq_epi8(_mm_set1_epi8(hash), _ctrl);
+            return BitMask{static_cast<std::uint32_t>(_mm_movemask_epi8(cmp))};
+#else
+            return mask_if([hash](ctrl_t c) { return c == hash; });
+#endif
+         }
+
+         BitMask match_empty() const
+         {
+            return match(kEmpty);
+         }
+
+         BitMask match_empty_or_deleted() const
+         {
+#if defined(__SSE2__)
+            return BitMask{static_cast<std::uint32_t>(_mm_movemask_epi8(_ctrl))};
+#else
+            return mask_if([](ctrl_t c) { return !is_full(c); });
+#endif
+         }
+
+         BitMask match_full() const
+         {
+#if defined(__SSE2__)
+            return BitMask{static_cast<std::uint32_t>(~_mm_movemask_epi8(_ctrl)) & 0xFFFF};
+#else
+            return mask_if([](ctrl_t c) { return is_full(c); });
+#endif
+         }
+
+      private:
+#if defined(__SSE2__)
+         __m128i _ctrl;
+#else
+         template <typename Pred>
+         BitMask mask_if(Pred pred) const
+         {
+            std::uint32_t mask = 0;
+            for (std::size_t i = 0; i < width; ++i)
+            {
+               mask |= static_cast<std::uint32_t>(pred(_ctrl[i])) << i;
+            }
+            return BitMask{mask};
+         }
+
+         ctrl_t _ctrl[width];
+#endif
+   };
+
+   // Triangular probing over whole groups. The number of groups is a power of
+   // two, so the sequence visits every group exactly once.
+   class ProbeSeq
+   {
+      public:
+         ProbeSeq(std::size_t hash, std::size_t group_mask)
+            : _mask(group_mask)
+            , _group(h1(hash) & group_mask)
+            , _index(0)
+         {
+         }
+
+         std::size_t offset() const
+         {
+            return _group * Group::width;
+         }
+
+         void next()
+         {
+            ++_index;
+            _group = (_group + _index) & _mask;
+         }
+
+      private:
+         std::size_t _mask;
+         std::size_t _group;
+         std::size_t _index;
+   };
+
+   inline void prefetch(const void* address)
+   {
+#if defined(__GNUC__) || defined(__clang__)
+      __builtin_prefetch(address);
+#elif defined(__SSE2__)
+      _mm_prefetch(static_cast<const char*>(address), _MM_HINT_T0);
+#endif
+   }
+
+   inline std::size_t find_first_non_full(const ctrl_t* ctrl, std::size_t capacity, std::size_t hash)
+   {
+      ProbeSeq seq{hash, capacity / Group::width - 1};
+
+      while (true)
+      {
+         const Group group{ctrl + seq.offset()};
+         if (const auto mask = group.match_empty_or_deleted())
+         {
+            return seq.offset() + mask.lowest();
+         }
+         seq.next();
+      }
+   }
+
+   inline constexpr float default_max_load_factor = 0.875f;
+
+   // Probing stops at the first group with an empty slot, so a table can
+   // never be allowed to fill up completely.
+   inline void check_max_load_factor(float ml)
+   {
+      if (!(ml > 0.0f && ml <= default_max_load_factor))
+      {
+         throw std::invalid_argument("HashBrown: max_load_factor must be in (0, 0.875]");
+      }
+   }
+
+   constexpr std::size_t max_items(std::size_t capacity, float max_load_factor)
+   {
+      const auto items = static_cast<std::size_t>(static_cast<double>(capacity) * max_load_factor);
+      return std::max<std::size_t>(items, 1);
+   }
+
+   constexpr std::size_t capacity_for(std::size_t count, float max_load_factor)
+   {
+      auto capacity = Group::width;
+      while (max_items(capacity, max_load_factor) < count)
+      {
+         capacity *= 2;
+      }
+      return capacity;
+   }
+
+   inline constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+   // The storage of one table: control bytes, slots and, with StoredHash,
+   // every slot's full hash. HashBrown and HashBrownSet keep their entries
+   // in these and differ only in what a Slot holds. The functions below
+   // take the allocator of Slot that the table's memory comes from.
+   template <typename Slot, bool StoredHash>
+   struct Table
+   {
+      static constexpr bool stored_hash = StoredHash;
+
+      ctrl_t* ctrl = nullptr;
+      Slot* slots = nullptr;
+      // Parallel to slots; only allocated when stored_hash is set.
+      std::size_t* hashes = nullptr;
+      std::size_t capacity = 0;
+      std::size_t size = 0;
+      std::size_t growth_left = 0;
+   };
+
+   // An empty table of capacity slots that inserts may fill growth_left of.
+   template <typename TableType, typename SlotAllocator>
+   TableType allocate_table(SlotAllocator& alloc, std::size_t capacity, std::size_t growth_left)
+   {
+      using slot_traits = std::allocator_traits<SlotAllocator>;
+      using ctrl_allocator = typename slot_traits::template rebind_alloc<ctrl_t>;
+      using hash_allocator = typename slot_traits::template rebind_alloc<std::size_t>;
+
+      TableType table;
+      ctrl_allocator ctrl_alloc{alloc};
+      table.ctrl = std::allocator_traits<ctrl_allocator>::allocate(ctrl_alloc, capacity);
+      try
+      {
+         table.slots = slot_traits::allocate(alloc, capacity);
+         if constexpr (TableType::stored_hash)
+         {
+            try
+            {
+               hash_allocator hash_alloc{alloc};
+               table.hashes = std::allocator_traits<hash_allocator>::allocate(hash_alloc, capacity);
+            }
+            catch (...)
+            {
+               slot_traits::deallocate(alloc, table.slots, capacity);
+               throw;
+            }
+         }
+      }
+      catch (...)
+      {
+         std::allocator_traits<ctrl_allocator>::deallocate(ctrl_alloc, table.ctrl, capacity);
+         throw;
+      }
+      std::fill_n(table.ctrl, capacity, kEmpty);
+      table.capacity = capacity;
+      table.growth_left = growth_left;
+      return table;
+   }
+
+   // Destroys every entry and gives the memory back, leaving table empty.
+   template <typename Slot, bool StoredHash, typename SlotAllocator>
+   void free_table(SlotAllocator& alloc, Table<Slot, StoredHash>& table)
+   {
+      using slot_traits = std::allocator_traits<SlotAllocator>;
+      using ctrl_allocator = typename slot_traits::template rebind_alloc<ctrl_t>;
+      using hash_allocator = typename slot_traits::template rebind_alloc<std::size_t>;
+
+      if (table.capacity == 0)
+      {
+         return;
+      }
+
+      for (std::size_t i = 0; i < table.capacity; ++i)
+      {
+         if (is_full(table.ctrl[i]))
+         {
+            slot_traits::destroy(alloc, table.slots + i);
+         }
+      }
+      ctrl_allocator ctrl_alloc{alloc};
+      if constexpr (StoredHash)
+      {
+         hash_allocator hash_alloc{alloc};
+         std::allocator_traits<hash_allocator>::deallocate(hash_alloc, table.hashes, table.capacity);
+      }
+      slot_traits::deallocate(alloc, table.slots, table.capacity);
+      std::allocator_traits<ctrl_allocator>::deallocate(ctrl_alloc, table.ctrl, table.capacity);
+      table = Table<Slot, StoredHash>{};
+   }
+
+   // A table of the same capacity with every entry in the same slot.
+   template <typename Slot, bool StoredHash, typename SlotAllocator>
+   Table<Slot, StoredHash> copy_table(SlotAllocator& alloc, const Table<Slot, StoredHash>& other)
+   {
+      using slot_traits = std::allocator_traits<SlotAllocator>;
+
+      // An allocated table is copied even when empty: mid-migration, the new
+      // table may have lost every entry moved into it so far.
+      if (other.capacity == 0)
+      {
+         return {};
+      }
+
+      auto table = allocate_table<Table<Slot, StoredHash>>(alloc, other.capacity, other.growth_left);
+      try
+      {
+         for (std::size_t i = 0; i < other.capacity; ++i)
+         {
+            if (is_full(other.ctrl[i]))
+            {
+               slot_traits::construct(alloc, table.slots + i, other.slots[i]);
+               if constexpr (StoredHash)
+               {
+                  table.hashes[i] = other.hashes[i];
+               }
+               table.ctrl[i] = other.ctrl[i];
+               ++table.size;
+            }
+         }
+      }
+      catch (...)
+      {
+         free_table(alloc, table);
+         throw;
+      }
+
+      // Tombstones are copied too so that every probe sequence stays intact.
+      std::copy_n(other.ctrl, other.capacity, table.ctrl);
+      return table;
+   }
+
+   template <typename Slot, bool StoredHash>
+   std::size_t find_first_non_full(const Table<Slot, StoredHash>& table, std::size_t hash)
+   {
+      return find_first_non_full(table.ctrl, table.capacity, hash);
+   }
+
+   // The index of the full slot with this hash for which matches(slot)
+   // holds, or npos.
+   template <typename Slot, bool StoredHash, typename Matches>
+   std::size_t find_slot(const Table<Slot, StoredHash>& table, std::size_t hash, const Matches& matches)
+   {
+      if (table.capacity == 0)
+      {
+         return npos;
+      }
+
+      const auto tag = h2(hash);
+      ProbeSeq seq{hash, table.capacity / Group::width - 1};
+
+      while (true)
+      {
+         const Group group{table.ctrl + seq.offset()};
+         for (const auto i : group.match(tag))
+         {
+            const auto index = seq.offset() + i;
+            if constexpr (StoredHash)
+            {
+               if (table.hashes[index] != hash)
+               {
+                  continue;
+               }
+            }
+            if (matches(table.slots[index]))
+            {
+               return index;
+            }
+         }
+
+         if (group.match_empty())
+         {
+            return npos;
+         }
+         seq.next();
+      }
+   }
+
+   // The capacity a table that ran out of room is rebuilt at. It only grows
+   // when live entries fill at least half of the usable space; otherwise it
+   // is clogged with tombstones and a same-size rebuild reclaims them.
+   inline std::size_t growth_target(std::size_t capacity, std::size_t size, float max_load_factor)
+   {
+      return size + 1 > max_items(capacity, max_load_factor) / 2
+         ? std::max(2 * capacity, capacity_for(size + 1, max_load_factor))
+         : capacity;
+   }
+
+   // Claims a slot for an entry with this hash and counts it as full; the
+   // caller constructs the entry there. When the table has no room left,
+   // grow() runs first and has to leave table with room.
+   template <typename Slot, bool StoredHash, typename Grow>
+   std::size_t prepare_insert(Table<Slot, StoredHash>& table, std::size_t hash, const Grow& grow)
+   {
+      auto index = table.capacity == 0 ? npos : find_first_non_full(table, hash);
+
+      if (index == npos || (table.growth_left == 0 && table.ctrl[index] == kEmpty))
+      {
+         grow();
+         index = find_first_non_full(table, hash);
+      }
+
+      if (table.ctrl[index] == kEmpty)
+      {
+         --table.growth_left;
+      }
+      ++table.size;
+      table.ctrl[index] = h2(hash);
+      if constexpr (StoredHash)
+      {
+         table.hashes[index] = hash;
+      }
+      return index;
+   }
+
+   // Gives back a slot prepare_insert claimed but no entry was built in. It
+   // becomes a tombstone, so the growth it cost stays spent.
+   template <typename Slot, bool StoredHash>
+   void abandon_slot(Table<Slot, StoredHash>& table, std::size_t index)
+   {
+      table.ctrl[index] = kDeleted;
+      --table.size;
+   }
+
+   template <typename Slot, bool StoredHash, typename SlotAllocator>
+   void erase_slot(SlotAllocator& alloc, Table<Slot, StoredHash>& table, std::size_t index)
+   {
+      std::allocator_traits<SlotAllocator>::destroy(alloc, table.slots + index);
+      --table.size;
+
+      // A probe only continues past a group that has no empty slot. If this
+      // group already has one, no probe sequence can depend on this slot being
+      // occupied, so it can go straight back to empty instead of a tombstone.
+      const Group group{table.ctrl + index / Group::width * Group::width};
+      if (group.match_empty())
+      {
+         table.ctrl[index] = kEmpty;
+         ++table.growth_left;
+      }
+      else
+      {
+         table.ctrl[index] = kDeleted;
+      }
+   }
+
+   // Moves the entry in from's slot from_index, whose hash is hash, into to.
+   // The slot it leaves keeps its control byte for the caller to set.
+   template <typename Slot, bool StoredHash, typename SlotAllocator>
+   void transfer_slot(SlotAllocator& alloc, Table<Slot, StoredHash>& to, Table<Slot, StoredHash>& from,
+                      std::size_t from_index, std::size_t hash)
+   {
+      using slot_traits = std::allocator_traits<SlotAllocator>;
+
+      const auto index = find_first_non_full(to, hash);
+      const auto ctrl = to.ctrl[index];
+      slot_traits::construct(alloc, to.slots + index, std::move(from.slots[from_index]));
+      slot_traits::destroy(alloc, from.slots + from_index);
+      to.ctrl[index] = h2(hash);
+      if constexpr (StoredHash)
+      {
+         to.hashes[index] = hash;
+      }
+      // Like prepare_insert, only a slot that was never used costs growth; a
+      // reused tombstone does not.
+      if (ctrl == kEmpty)
+      {
+         assert(to.growth_left != 0);
+         --to.growth_left;
+      }
+      ++to.size;
+   }
+
+   // Rebuilds table at new_capacity, which drops its tombstones.
+   // hash_at(table, index) gives the hash of the entry in a full slot.
+   template <typename Slot, bool StoredHash, typename SlotAllocator, typename HashAt>
+   void resize_table(SlotAllocator& alloc, Table<Slot, StoredHash>& table, std::size_t new_capacity,
+                     float max_load_factor, const HashAt& hash_at)
+   {
+      auto fresh = allocate_table<Table<Slot, StoredHash>>(alloc, new_capacity, max_items(new_capacity, max_load_factor));
+      auto old_table = std::exchange(table, fresh);
+
+      for (std::size_t i = 0; i < old_table.capacity; ++i)
+      {
+         if (is_full(old_table.ctrl[i]))
+         {
+            transfer_slot(alloc, table, old_table, i, hash_at(old_table, i));
+            old_table.ctrl[i] = kEmpty;
+         }
+      }
+      free_table(alloc, old_table);
+   }
+
+   // The on-disk layout written by HashBrown::save and mapped by
+   // HashBrownView. All offsets are from the start of the file, so the file
+   // can be mapped anywhere; integers are in host byte order.
+   struct SnapshotHeader
+   {
+      static constexpr char expected_magic[8] = {'H', 'B', 'S', 'N', 'A', 'P', '\0', '\1'};
+      static constexpr std::uint32_t current_version = 1;
+
+      char magic[8];
+      std::uint32_t version;
+      std::uint32_t group_width;
+      std::uint64_t key_size;
+      std::uint64_t value_size;
+      std::uint64_t slot_size;
+      std::uint64_t slot_align;
+      std::uint64_t capacity;
+      std::uint64_t size;
+      // The hasher's seed, and the hash it gives a value-initialised key, so
+      // a view can rebuild the hasher and detect one that does not match.
+      std::uint64_t seed;
+      std::uint64_t check;
+      std::uint64_t ctrl_offset;
+      std::uint64_t slots_offset;
+   };
+
+   template <typename Hash>
+   std::uint64_t seed_of(const Hash& hash)
+   {
+      if constexpr (requires { { hash.seed() } -> std::convertible_to<std::uint64_t>; })
+      {
+         return hash.seed();
+      }
+      else
+      {
+         return 0;
+      }
+   }
+
+   template <typename Key, typename Hash>
+   std::uint64_t snapshot_check(const Hash& hash)
+   {
+      if constexpr (std::is_default_constructible_v<Key>)
+      {
+         return hash(Key{});
+      }
+      else
+      {
+         return 0;
+      }
+   }
+
+   // Building with HASHBROWN_STATS defined to 1 makes every HashBrown count
+   // lookups and resizes. It changes the class layout, so it has to be the
+   // same in every translation unit of a program.
+#if defined(HASHBROWN_STATS) && HASHBROWN_STATS
+   inline constexpr bool stats_enabled = true;
+#else
+   inline constexpr bool stats_enabled = false;
+#endif
+
+   // A relaxed load and store instead of a read-modify-write: const lookups
+   // running in parallel may lose a count, but they never race, and the
+   // increment stays a plain add.
+   class Counter
+   {
+      public:
+         void add(std::uint64_t amount = 1) noexcept
+         {
+            _value.store(_value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+         }
+
+         std::uint64_t get() const noexcept
+         {
+            return _value.load(std::memory_order_relaxed);
+         }
+
+      private:
+         std::atomic<std::uint64_t> _value{0};
+   };
+
+   struct Counters
+   {
+      Counter hits;
+      Counter misses;
+      Counter resizes;
+      Counter resize_ns;
+   };
+
+   struct NoCounters
+   {
+   };
+
+   using counters_t = std::conditional_t<stats_enabled, Counters, NoCounters>;
+
+   // Adds the time until it goes out of scope to a resize in progress.
+   class ResizeTimer
+   {
+      public:
+         ResizeTimer(Counters& counters, bool starts_resize)
+            : _counters(counters)
+            , _start(std::chrono::steady_clock::now())
+         {
+            if (starts_resize)
+            {
+               _counters.resizes.add();
+            }
+         }
+
+         ResizeTimer(const ResizeTimer&) = delete;
+         ResizeTimer& operator=(const ResizeTimer&) = delete;
+
+         ~ResizeTimer()
+         {
+            const auto elapsed = std::chrono::steady_clock::now() - _start;
+            _counters.resize_ns.add(static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+         }
+
+      private:
+         Counters& _counters;
+         std::chrono::steady_clock::time_point _start;
+   };
+
+   // Overloads on the counters type, so that without HASHBROWN_STATS every
+   // call below is an empty inline function.
+   inline void count_lookup(Counters& counters, bool hit)
+   {
+      (hit ? counters.hits : counters.misses).add();
+   }
+
+   inline void count_lookup(NoCounters&, bool)
+   {
+   }
+
+   inline ResizeTimer time_resize(Counters& counters, bool starts_resize)
+   {
+      return ResizeTimer(counters, starts_resize);
+   }
+
+   inline NoCounters time_resize(NoCounters&, bool)
+   {
+      return {};
+   }
+
+   template <typename Stats>
+   void read_counters(const Counters& counters, Stats& stats)
+   {
+      stats.hits = counters.hits.get();
+      stats.misses = counters.misses.get();
+      stats.resizes = counters.resizes.get();
+      stats.resize_ns = counters.resize_ns.get();
+   }
+
+   template <typename Stats>
+   void read_counters(const NoCounters&, Stats&)
+   {
+   }
+
+   inline void append_json(std::string& out, double value)
+   {
+      char buffer[32];
+      const auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+      out.append(buffer, result.ptr);
+   }
+
+   inline void append_json(std::string& out, std::uint64_t value)
+   {
+      out += std::to_string(value);
+   }
+
+   inline void append_json(std::string& out, const std::vector<std::size_t>& values)
+   {
+      out += '[';
+      for (std::size_t i = 0; i < values.size(); ++i)
+      {
+         out += i == 0 ? "" : ",";
+         append_json(out, std::uint64_t{values[i]});
+      }
+      out += ']';
+   }
+
+   // Fibonacci hashing: spreads the hash across the high bits so that shard
+   // selection works even for identity hashes of small integers.
+   constexpr std::size_t shard_of(std::size_t hash, unsigned shard_bits)
+   {
+      if (shard_bits == 0)
+      {
+         return 0;
+      }
+      const auto mixed = static_cast<std::uint64_t>(hash) * 0x9E3779B97F4A7C15ull;
+      return static_cast<std::size_t>(mixed >> (64 - shard_bits));
+   }
+
+   // How many threads to split items across: threads, or every hardware
+   // thread when it is 0, but never so many that one gets less than grain.
+   inline std::size_t worker_count(std::size_t threads, std::size_t items, std::size_t grain)
+   {
+      if (threads == 0)
+      {
+         threads = std::max(1u, std::thread::hardware_concurrency());
+      }
+      return std::max<std::size_t>(1, std::min(threads, items / grain));
+   }
+
+   // Calls work(worker) for every worker in [0, workers), each on its own
+   // thread with worker 0 on the caller's. Once all have finished, the first
+   // exception any of them threw is rethrown.
+   template <typename Work>
+   void run_workers(std::size_t workers, const Work& work)
+   {
+      std::vector<std::exception_ptr> errors(workers);
+      {
+         std::vector<std::jthread> threads;
+         threads.reserve(workers - 1);
+         for (std::size_t worker = 1; worker < workers; ++worker)
+         {
+            threads.emplace_back([&work, &errors, worker] {
+               try
+               {
+                  work(worker);
+               }
+               catch (...)
+               {
+                  errors[worker] = std::current_exception();
+               }
+            });
+         }
+
+         try
+         {
+            work(0);
+         }
+         catch (...)
+         {
+            errors[0] = std::current_exception();
+         }
+      }
+
+      for (const auto& error : errors)
+      {
+         if (error)
+         {
+            std::rethrow_exception(error);
+         }
+      }
+   }
+}
+
+namespace hashbrown
+{
+   // What HashBrown::stats() reports. The shape of the table is measured
+   // when stats() is called and is always there; the event counters are
+   // only kept in builds with HASHBROWN_STATS and read zero otherwise.
+   struct Stats
+   {
+      std::size_t size = 0;
+      std::size_t capacity = 0;
+      std::size_t tombstones = 0;
+      double load_factor = 0.0;
+
+      // probe_lengths[i] entries are found in the (i + 1)th group of their
+      // probe sequence.
+      std::vector<std::size_t> probe_lengths;
+      // group_occupancy[i] groups have i full slots.
+      std::vector<std::size_t> group_occupancy;
+
+      std::size_t allocated_bytes = 0;
+      double bytes_per_entry = 0.0;
+
+      bool instrumented = detail::stats_enabled;
+      std::uint64_t hits = 0;
+      std::uint64_t misses = 0;
+      std::uint64_t resizes = 0;
+      std::uint64_t resize_ns = 0;
+
+      double mean_probe_length() const
+      {
+         std::size_t entries = 0;
+         std::size_t groups = 0;
+         for (std::size_t i = 0; i < probe_lengths.size(); ++i)
+         {
+            entries += probe_lengths[i];
+            groups += probe_lengths[i] * (i + 1);
+         }
+         return entries == 0 ? 0.0 : static_cast<double>(groups) / static_cast<double>(entries);
+      }
+
+      std::string to_json() const
+      {
+         std::string out = "{";
+         const auto field = [&out](const char* name, const auto& value) {
+            out += out.size() == 1 ? "\"" : ",\"";
+            out += name;
+            out += "\":";
+            detail::append_json(out, value);
+         };
+         field("size", std::uint64_t{size});
+         field("capacity", std::uint64_t{capacity});
+         field("tombstones", std::uint64_t{tombstones});
+         field("load_factor", load_factor);
+         field("mean_probe_length", mean_probe_length());
+         field("probe_lengths", probe_lengths);
+         field("group_occupancy", group_occupancy);
+         field("allocated_bytes", std::uint64_t{allocated_bytes});
+         field("bytes_per_entry", bytes_per_entry);
+         out += instrumented ? ",\"instrumented\":true" : ",\"instrumented\":false";
+         field("hits", hits);
+         field("misses", misses);
+         field("resizes", resizes);
+         field("resize_ns", resize_ns);
+         out += '}';
+         return out;
+      }
+   };
+
+   // Selects the overloads of HashBrown's bulk operations that split their
+   // work across threads. A thread count of 0 means one per hardware thread.
+   // Work too small to be worth sharing runs on the calling thread.
+   struct Parallel
+   {
+      std::size_t threads = 0;
+   };
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+class PerfectHashBrown;
+
+template <typename Key,
+          typename Value,
+          typename Hash = HashFunction<Key>,
+          typename KeyEqual = std::equal_to<>,
+          typename Allocator = std::allocator<std::pair<Key, Value>>>
+class HashBrown
+{
+   template <bool IsConst>
+   class Iterator;
+   class NodeHandle;
+   struct InsertReturn;
+
+   static constexpr bool transparent_lookup =
+      hashbrown::detail::transparent<Hash> && hashbrown::detail::transparent<KeyEqual>;
+
+   static constexpr bool move_assign_noexcept =
+      std::allocator_traits<Allocator>::propagate_on_container_move_assignment::value
+      || std::allocator_traits<Allocator>::is_always_equal::value;
+
+   public:
+      static constexpr bool stored_hash = hashbrown::detail::stores_hash<Key, Hash>();
+
+      using value_type = std::pair<Key, Value>;
+      using reference = value_type&;
+      using pointer = value_type*;
+      using const_reference = const value_type&;
+      using iterator = Iterator<false>;
+      using const_iterator = Iterator<true>;
+      using allocator_type = Allocator;
+      using node_type = NodeHandle;
+      using insert_return_type = InsertReturn;
+
+      constexpr HashBrown();
+      explicit HashBrown(const Allocator& alloc);
+      explicit HashBrown(const Hash& hash, const KeyEqual& equal = KeyEqual(), const Allocator& alloc = Allocator());
+      HashBrown(std::initializer_list<value_type> il, const Allocator& alloc = Allocator());
+      HashBrown(const HashBrown& other);
+      HashBrown(const HashBrown& other, const Allocator& alloc);
+      HashBrown(HashBrown&& other) noexcept;
+      HashBrown(HashBrown&& other, const Allocator& alloc);
+      HashBrown& operator=(const HashBrown& other);
+      HashBrown& operator=(HashBrown&& other) noexcept(move_assign_noexcept);
+      ~HashBrown();
+
+      iterator begin();
+      const_iterator begin() const;
+      const_iterator cbegin() const;
+
+      iterator end();
+      const_iterator end() const;
+      const_iterator cend() const;
+
+      // Call fn on every entry, splitting the slots into contiguous runs of
+      // groups that threads take in turn; each thread walks its run in slot
+      // order. fn runs concurrently and must not insert or erase.
+      template <typename Fn>
+      void for_each(hashbrown::Parallel policy, Fn fn);
+      template <typename Fn>
+      void for_each(hashbrown::Parallel policy, Fn fn) const;
+
+      // Folds transform(entry) over every entry with reduce, as
+      // std::transform_reduce does. Each run of slots is folded on its own and
+      // the results are combined with init in slot order, so reduce has to be
+      // associative but the result does not depend on the threads' timing.
+      template <typename T, typename Reduce, typename Transform>
+      T transform_reduce(hashbrown::Parallel policy, T init, Reduce reduce, Transform transform) const;
+
+      iterator erase(const Key& key);
+      template <typename K>
+      iterator erase(const K& key) requires transparent_lookup;
+
+      void insert(std::initializer_list<value_type> il);
+      template <std::input_iterator InputIt>
+      void insert(InputIt first, InputIt last);
+      iterator insert(Key key, Value value);
+      iterator insert(const value_type& value);
+      iterator insert(value_type&& value);
+
+      // Inserts a random-access range on several threads. The keys are hashed
+      // in parallel and radix-partitioned by the leading bits of their home
+      // group; each partition owns that slice of the table and is filled by
+      // one thread, without locks. Entries whose probe sequence would leave
+      // their slice are inserted afterwards by the caller. The map ends up
+      // with the same entries as the serial insert, later duplicates
+      // overwriting earlier ones, though the few entries that left their
+      // slice may sit in different slots. Entries are constructed from
+      // several threads at once, which the allocator has to allow.
+      template <hashbrown::detail::random_access It>
+      void insert(hashbrown::Parallel policy, It first, It last);
+
+      // Like insert, emplace overwrites the value of a present key. The key
+      // is looked up before anything is built whenever it can be picked out
+      // of the arguments: a key followed by a value, or a piecewise tuple
+      // holding just the key.
+      template <typename... Args>
+      iterator emplace(Args&&... args);
+
+      // Builds the value in place from args only if the key is absent; a
+      // present key leaves args untouched.
+      template <typename... Args>
+      std::pair<iterator, bool> try_emplace(const Key& key, Args&&... args);
+      template <typename... Args>
+      std::pair<iterator, bool> try_emplace(Key&& key, Args&&... args);
+
+      template <typename M>
+      std::pair<iterator, bool> insert_or_assign(const Key& key, M&& obj);
+      template <typename M>
+      std::pair<iterator, bool> insert_or_assign(Key&& key, M&& obj);
+
+      // Node handles carry an entry, and its hash where it can be trusted,
+      // from one map to another. The entry is moved out of its slot and into
+      // the next one, so keys and values are relocated, never copied.
+      node_type extract(const_iterator position);
+      node_type extract(const Key& key);
+      template <typename K>
+      node_type extract(const K& key) requires transparent_lookup && (!std::is_convertible_v<const K&, const_iterator>);
+      insert_return_type insert(node_type&& node);
+
+      // Moves every entry whose key is not present here out of source.
+      void merge(HashBrown& source);
+      void merge(HashBrown&& source);
+
+      const Value* get(const Key& key) const;
+      template <typename K>
+      const Value* get(const K& key) const requires transparent_lookup;
+      bool contains(const Key& key) const;
+      template <typename K>
+      bool contains(const K& key) const requires transparent_lookup;
+
+      // Looks up every key and stores what get() would return for keys[i] in
+      // out[i]. Keys are handled in blocks: the whole block is hashed and, on
+      // tables too big to stay cached, its control groups and candidate slots
+      // are prefetched before any lookup is resolved, so the cache misses of a
+      // block overlap.
+      template <std::ranges::random_access_range Keys>
+      void get_many(const Keys& keys, std::span<const Value*> out) const
+         requires std::same_as<std::ranges::range_value_t<Keys>, Key> || transparent_lookup;
+      bool empty() const;
+      std::size_t size() const;
+      std::size_t capacity() const;
+      void clear();
+      void swap(HashBrown& other) noexcept;
+      allocator_type get_allocator() const;
+      Hash hash_function() const;
+      KeyEqual key_eq() const;
+
+      float load_factor() const;
+      float max_load_factor() const;
+      void max_load_factor(float ml);
+      void rehash(std::size_t count);
+      void reserve(std::size_t count);
+
+      // Writes a compacted copy of the table to path in the layout that
+      // HashBrownView maps. The file is written beside path and renamed over
+      // it, so readers never see a partial snapshot.
+      void save(const std::filesystem::path& path) const
+         requires std::is_trivially_copyable_v<Key> && std::is_trivially_copyable_v<Value>;
+
+      // Walks the table to report probe lengths, group occupancy and memory,
+      // plus the lookup and resize counters of instrumented builds.
+      hashbrown::Stats stats() const;
+
+      // Moves every entry into a read-only table indexed by a minimal
+      // perfect hash and leaves this map empty. Keys whose full hashes
+      // collide are kept beside the perfect hash and found by a search.
+      // Defined in frozen_hashbrown.hpp, which has to be included to call it.
+      PerfectHashBrown<Key, Value, Hash, KeyEqual, Allocator> freeze() &&;
+
+      // With incremental rehashing enabled, growth keeps the old table next
+      // to the new one and every mutating call moves a bounded number of
+      // slots across, instead of rebuilding the whole table in one insert.
+      void incremental_rehash(bool enabled);
+      bool incremental_rehash() const;
+      bool rehashing() const;
+
+   private:
+      using ctrl_t = hashbrown::detail::ctrl_t;
+      using Group = hashbrown::detail::Group;
+      using slot_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<value_type>;
+      using slot_traits = std::allocator_traits<slot_allocator>;
+
+      static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+      static constexpr std::size_t rehash_step = 2 * Group::width;
+      static constexpr std::size_t batch_block = 64;
+      // Below this footprint the table mostly stays cached and the extra
+      // prefetch passes of get_many() cost more than they hide.
+      static constexpr std::size_t batch_prefetch_bytes = std::size_t{16} << 20;
+      // Below this many entries per thread a parallel insert runs serially.
+      static constexpr std::size_t parallel_grain = std::size_t{1} << 14;
+      // Below this many slots per thread a parallel scan runs serially.
+      static constexpr std::size_t parallel_scan_grain = std::size_t{1} << 16;
+      // More partitions than threads lets a thread that drew a light
+      // partition take another.
+      static constexpr std::size_t partitions_per_worker = 16;
+
+      // What one thread of a parallel insert did to the table.
+      struct ParallelFill
+      {
+         std::size_t inserted = 0;
+         std::size_t empties_used = 0;
+         // Input positions of the entries left for the calling thread.
+         std::vector<std::size_t> spilled;
+      };
+
+      using Table = hashbrown::detail::Table<value_type, stored_hash>;
+
+      // While a migration is in flight, _old holds the entries that have not
+      // been moved yet. Indices past _table.capacity address _old.
+      Table _table;
+      Table _old;
+      std::size_t _migrated;
+      bool _incremental;
+      Hash _hasher;
+      KeyEqual _equal;
+      float _max_load_factor;
+      [[no_unique_address]] slot_allocator _alloc;
+      // Belong to this object: copies and moves start counting from zero.
+      [[no_unique_address]] mutable hashbrown::detail::counters_t _counters;
+
+
+      template <typename K>
+      std::size_t find_in(const Table& table, const K& key, std::size_t hash) const;
+      template <typename K>
+      std::size_t find_index(const K& key, std::size_t hash) const;
+      template <typename K>
+      iterator erase_key(const K& key);
+      template <typename K, typename... Args>
+      std::pair<iterator, bool> emplace_key(bool assign, K&& key, Args&&... args);
+      template <hashbrown::detail::random_access It>
+      void fill_partition(It first, std::span<const std::pair<std::size_t, std::size_t>> entries,
+                          std::size_t first_group, std::size_t end_group, ParallelFill& fill);
+      template <typename K>
+      node_type extract_key(const K& key);
+      node_type extract_index(std::size_t index, std::size_t hash);
+      bool same_hasher(const Hash& other) const;
+      std::size_t prepare_insert(std::size_t hash);
+      void erase_index(std::size_t index);
+      std::size_t next_full(std::size_t index) const;
+      template <typename Fn>
+      void for_each_full(std::size_t first_group, std::size_t end_group, Fn& fn) const;
+      template <typename Visit>
+      void scan_parallel(hashbrown::Parallel policy, std::size_t runs, const Visit& visit) const;
+      std::size_t scan_runs(hashbrown::Parallel policy) const;
+      value_type& slot(std::size_t index);
+      const value_type& slot(std::size_t index) const;
+
+      std::size_t max_items(std::size_t capacity) const;
+      std::size_t capacity_for(std::size_t count) const;
+      void destroy_table();
+      void swap_contents(HashBrown& other) noexcept;
+      std::size_t hash_at(const Table& table, std::size_t index) const;
+      void resize(std::size_t new_capacity);
+      void start_migration(std::size_t new_capacity);
+      void migrate_step();
+      void finish_migration();
+
+      template <bool IsConst>
+      class Iterator {
+         public:
+            using difference_type = std::ptrdiff_t;
+            using value_type = HashBrown<Key, Value, Hash, KeyEqual, Allocator>::value_type;
+            using reference = std::conditional_t<IsConst, const_reference, HashBrown<Key, Value, Hash, KeyEqual, Allocator>::reference>;
+            using pointer = std::conditional_t<IsConst, const value_type*, HashBrown<Key, Value, Hash, KeyEqual, Allocator>::pointer>;
+            using iterator_category = std::forward_iterator_tag;
+            using map_pointer = std::conditional_t<IsConst, const HashBrown*, HashBrown*>;
+
+            Iterator() = default;
+
+            Iterator(map_pointer hb, std::size_t index)
+               : _hb(hb)
+               , _index(index)
+            {
+            }
+
+            operator Iterator<true>() const requires (!IsConst)
+            {
+               return Iterator<true>{_hb, _index};
+            }
+
+            Iterator& operator++()
+            {
+               _index = _hb->next_full(_index + 1);
+               return *this;
+            }
+
+            Iterator operator++(int)
+            {
+               auto temp = *this;
+               ++*this;
+               return temp;
+            }
+
+            reference operator*() const
+            {
+               return _hb->slot(_index);
+            }
+
+            pointer operator->() const
+            {
+               return &this->operator*();
+            }
+
+            friend bool operator==(const Iterator& it_a, const Iterator& it_b)
+            {
+               return it_a._hb == it_b._hb
+                  && it_a._index == it_b._index;
+            }
+
+            friend bool operator!=(const Iterator& it_a, const Iterator& it_b)
+            {
+               return !(it_a == it_b);
+            }
+
+         private:
+            friend class HashBrown;
+
+            map_pointer _hb = nullptr;
+            std::size_t _index = 0;
+      };
+
+      class NodeHandle
+      {
+         public:
+            using key_type = Key;
+            using mapped_type = Value;
+            using allocator_type = Allocator;
+
+            NodeHandle() = default;
+
+            NodeHandle(NodeHandle&& other) noexcept
+            {
+               take(other);
+            }
+
+            NodeHandle& operator=(NodeHandle&& other) noexcept
+            {
+               if (this != &other)
+               {
+                  reset();
+                  take(other);
+               }
+               return *this;
+            }
+
+            ~NodeHandle()
+            {
+               reset();
+            }
+
+            bool empty() const noexcept
+            {
+               return !_alloc.has_value();
+            }
+
+            explicit operator bool() const noexcept
+            {
+               return !empty();
+            }
+
+            allocator_type get_allocator() const
+            {
+               return allocator_type(*_alloc);
+            }
+
+            // The key may be changed through this, so the carried hash can no
+            // longer be relied on.
+            key_type& key() const
+            {
+               _hash_valid = false;
+               return entry()->first;
+            }
+
+            mapped_type& mapped() const
+            {
+               return entry()->second;
+            }
+
+            void swap(NodeHandle& other) noexcept
+            {
+               NodeHandle temp{std::move(other)};
+               other = std::move(*this);
+               *this = std::move(temp);
+            }
+
+            friend void swap(NodeHandle& a, NodeHandle& b) noexcept
+            {
+               a.swap(b);
+            }
+
+         private:
+            friend class HashBrown;
+
+            NodeHandle(const slot_allocator& alloc, value_type& source, const Hash& hasher, std::size_t hash)
+               : _alloc(alloc)
+               , _hasher(hasher)
+               , _hash(hash)
+               , _hash_valid(true)
+            {
+               slot_traits::construct(*_alloc, entry(), std::move(source));
+            }
+
+            value_type* entry() const
+            {
+               return std::launder(reinterpret_cast<value_type*>(_storage));
+            }
+
+            void take(NodeHandle& other) noexcept
+            {
+               if (other.empty())
+               {
+                  return;
+               }
+               _alloc.emplace(std::move(*other._alloc));
+               slot_traits::construct(*_alloc, entry(), std::move(*other.entry()));
+               _hasher = std::move(other._hasher);
+               _hash = other._hash;
+               _hash_valid = other._hash_valid;
+               other.reset();
+            }
+
+            void reset() noexcept
+            {
+               if (_alloc)
+               {
+                  slot_traits::destroy(*_alloc, entry());
+                  _alloc.reset();
+               }
+            }
+
+            std::optional<slot_allocator> _alloc;
+            alignas(value_type) mutable unsigned char _storage[sizeof(value_type)];
+            [[no_unique_address]] Hash _hasher{};
+            std::size_t _hash = 0;
+            mutable bool _hash_valid = false;
+      };
+
+      struct InsertReturn
+      {
+         iterator position;
+         bool inserted;
+         node_type node;
+      };
+};
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+constexpr HashBrown<Key, Value, Hash, KeyEqual, Allocator>::HashBrown()
+   : HashBrown(Allocator())
+{
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+HashBrown<Key, Value, Hash, KeyEqual, Allocator>::HashBrown(const Allocator& alloc)
+   : HashBrown(Hash(), KeyEqual(), alloc)
+{
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+HashBrown<Key, Value, Hash, KeyEqual, Allocator>::HashBrown(const Hash& hash, const KeyEqual& equal, const Allocator& alloc)
+   : _table()
+   , _old()
+   , _migrated(0)
+   , _incremental(false)
+   , _hasher(hash)
+   , _equal(equal)
+   , _max_load_factor(hashbrown::detail::default_max_load_factor)
+   , _alloc(alloc)
+{
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+HashBrown<Key, Value, Hash, KeyEqual, Allocator>::HashBrown(std::initializer_list<value_type> il, const Allocator& alloc)
+   : HashBrown(alloc)
+{
+   insert(il);
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+HashBrown<Key, Value, Hash, KeyEqual, Allocator>::HashBrown(const HashBrown& other)
+   : HashBrown(other, slot_traits::select_on_container_copy_construction(other._alloc))
+{
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+HashBrown<Key, Value, Hash, KeyEqual, Allocator>::HashBrown(const HashBrown& other, const Allocator& alloc)
+   : _table()
+   , _old()
+   , _migrated(other._migrated)
+   , _incremental(other._incremental)
+   , _hasher(other._hasher)
+   , _equal(other._equal)
+   , _max_load_factor(other._max_load_factor)
+   , _alloc(alloc)
+{
+   _table = hashbrown::detail::copy_table(_alloc, other._table);
+   try
+   {
+      _old = hashbrown::detail::copy_table(_alloc, other._old);
+   }
+   catch (...)
+   {
+      hashbrown::detail::free_table(_alloc, _table);
+      throw;
+   }
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+HashBrown<Key, Value, Hash, KeyEqual, Allocator>::HashBrown(HashBrown&& other) noexcept
+   : _table(std::exchange(other._table, Table{}))
+   , _old(std::exchange(other._old, Table{}))
+   , _migrated(other._migrated)
+   , _incremental(other._incremental)
+   , _hasher(std::move(other._hasher))
+   , _equal(std::move(other._equal))
+   , _max_load_factor(other._max_load_factor)
+   , _alloc(std::move(other._alloc))
+{
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+HashBrown<Key, Value, Hash, KeyEqual, Allocator>::HashBrown(HashBrown&& other, const Allocator& alloc)
+   : HashBrown(alloc)
+{
+   _hasher = other._hasher;
+   _equal = other._equal;
+   _max_load_factor = other._max_load_factor;
+
+   if (_alloc == other._alloc)
+   {
+      swap_contents(other);
+      return;
+   }
+
+   // Memory from a different allocator cannot be adopted, so the entries
+   // are moved one by one into storage from ours.
+   other.finish_migration();
+   reserve(other.size());
+   for (auto& entry : other)
+   {
+      const auto hash = _hasher(entry.first);
+      const auto index = prepare_insert(hash);
+      slot_traits::construct(_alloc, _table.slots + index, std::move(entry));
+   }
+   _incremental = other._incremental;
+   other.clear();
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+HashBrown<Key, Value, Hash, KeyEqual, Allocator>& HashBrown<Key, Value, Hash, KeyEqual, Allocator>::operator=(const HashBrown& other)
+{
+   if (this != &other)
+   {
+      if constexpr (slot_traits::propagate_on_container_copy_assignment::value)
+      {
+         destroy_table();
+         _alloc = other._alloc;
+      }
+      HashBrown copy{other, _alloc};
+      swap_contents(copy);
+   }
+   return *this;
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+HashBrown<Key, Value, Hash, KeyEqual, Allocator>& HashBrown<Key, Value, Hash, KeyEqual, Allocator>::operator=(HashBrown&& other) noexcept(move_assign_noexcept)
+{
+   if (this != &other)
+   {
+      if constexpr (slot_traits::propagate_on_container_move_assignment::value)
+      {
+         destroy_table();
+         _alloc = std::move(other._alloc);
+      }
+      HashBrown moved{std::move(other), _alloc};
+      swap_contents(moved);
+   }
+   return *this;
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+HashBrown<Key, Value, Hash, KeyEqual, Allocator>::~HashBrown()
+{
+   destroy_table();
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+typename HashBrown<Key, Value, Hash, KeyEqual, Allocator>::iterator HashBrown<Key, Value, Hash, KeyEqual, Allocator>::erase(const Key& key)
+{
+   return erase_key(key);
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+template <typename K>
+typename HashBrown<Key, Value, Hash, KeyEqual, Allocator>::iterator HashBrown<Key, Value, Hash, KeyEqual, Allocator>::erase(const K& key)
+   requires transparent_lookup
+{
+   return erase_key(key);
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+void HashBrown<Key, Value, Hash, KeyEqual, Allocator>::insert(std::initializer_list<value_type> il)
+{
+   insert(il.begin(), il.end());
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+template <std::input_iterator InputIt>
+void HashBrown<Key, Value, Hash, KeyEqual, Allocator>::insert(InputIt first, InputIt last)
+{
+   if constexpr (std::forward_iterator<InputIt>)
+   {
+      reserve(size() + static_cast<std::size_t>(std::distance(first, last)));
+   }
+
+   for (; first != last; ++first)
+   {
+      insert(*first);
+   }
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+template <hashbrown::detail::random_access It>
+void HashBrown<Key, Value, Hash, KeyEqual, Allocator>::insert(hashbrown::Parallel policy, It first, It last)
+{
+   const auto count = static_cast<std::size_t>(std::distance(first, last));
+   const auto workers = hashbrown::detail::worker_count(policy.threads, count, parallel_grain);
+   if (workers < 2)
+   {
+      insert(first, last);
+      return;
+   }
+
+   // Make room for every entry and clear out tombstones first, so no thread
+   // ever needs the table to grow.
+   reserve(size() + count);
+   if (_table.growth_left < count)
+   {
+      resize(capacity_for(_table.size + count));
+   }
+
+   const auto groups = _table.capacity / Group::width;
+   const auto partitions = std::min(groups, std::bit_ceil(workers * partitions_per_worker));
+   const auto shift = static_cast<std::size_t>(std::countr_zero(groups) - std::countr_zero(partitions));
+   const auto partition_of = [&](std::size_t hash) {
+      return (hashbrown::detail::h1(hash) & (groups - 1)) >> shift;
+   };
+   const auto chunk_begin = [&](std::size_t worker) {
+      return count * worker / workers;
+   };
+
+   // Each thread hashes its chunk of the input and counts its entries per
+   // partition.
+   std::vector<std::size_t> hashes(count);
+   std::vector<std::size_t> offsets(workers * partitions);
+   hashbrown::detail::run_workers(workers, [&](std::size_t worker) {
+      auto* counts = offsets.data() + worker * partitions;
+      for (auto i = chunk_begin(worker); i < chunk_begin(worker + 1); ++i)
+      {
+         hashes[i] = _hasher((*(first + i)).first);
+         ++counts[partition_of(hashes[i])];
+      }
+   });
+
+   // Turn the counts into where each chunk's share of each partition
+   // starts. Chunks are laid out in input order within a partition, so
+   // every partition lists its entries in input order.
+   std::vector<std::size_t> starts(partitions + 1);
+   std::size_t offset = 0;
+   for (std::size_t partition = 0; partition < partitions; ++partition)
+   {
+      starts[partition] = offset;
+      for (std::size_t worker = 0; worker < workers; ++worker)
+      {
+         offset += std::exchange(offsets[worker * partitions + partition], offset);
+      }
+   }
+   starts[partitions] = offset;
+
+   std::vector<std::pair<std::size_t, std::size_t>> order(count);
+   hashbrown::detail::run_workers(workers, [&](std::size_t worker) {
+      auto* next = offsets.data() + worker * partitions;
+      for (auto i = chunk_begin(worker); i < chunk_begin(worker + 1); ++i)
+      {
+         order[next[partition_of(hashes[i])]++] = {hashes[i], i};
+      }
+   });
+   std::vector<std::size_t>().swap(hashes);
+
+   std::vector<ParallelFill> fills(workers);
+   std::atomic<std::size_t> next_partition{0};
+   const auto fill_all = [&](std::size_t worker) {
+      for (auto partition = next_partition.fetch_add(1); partition < partitions; partition = next_partition.fetch_add(1))
+      {
+         const std::span<const std::pair<std::size_t, std::size_t>> entries{order.data() + starts[partition],
+                                                                             starts[partition + 1] - starts[partition]};
+         fill_partition(first, entries, partition << shift, (partition + 1) << shift, fills[worker]);
+      }
+   };
+
+   // Whatever happens, the table has to account for the entries that were
+   // placed.
+   const auto account = [&] {
+      for (const auto& fill : fills)
+      {
+         _table.size += fill.inserted;
+         _table.growth_left -= fill.empties_used;
+      }
+   };
+   try
+   {
+      hashbrown::detail::run_workers(workers, fill_all);
+   }
+   catch (...)
+   {
+      account();
+      throw;
+   }
+   account();
+
+   // A key is spilled from its first occurrence on, so all of its spilled
+   // occurrences come from one partition, in input order.
+   for (const auto& fill : fills)
+   {
+      for (const auto i : fill.spilled)
+      {
+         insert(*(first + i));
+      }
+   }
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+typename HashBrown<Key, Value, Hash, KeyEqual, Allocator>::iterator HashBrown<Key, Value, Hash, KeyEqual, Allocator>::insert(Key key, Value value)
+{
+   return emplace_key(true, std::move(key), std::move(value)).first;
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+typename HashBrown<Key, Value, Hash, KeyEqual, Allocator>::iterator HashBrown<Key, Value, Hash, KeyEqual, Allocator>::insert(const value_type& value)
+{
+   return emplace_key(true, value.first, value.second).first;
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+typename HashBrown<Key, Value, Hash, KeyEqual, Allocator>::iterator HashBrown<Key, Value, Hash, KeyEqual, Allocator>::insert(value_type&& value)
+{
+   return emplace_key(true, std::move(value.first), std::move(value.second)).first;
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+template <typename... Args>
+typename HashBrown<Key, Value, Hash, KeyEqual, Allocator>::iterator HashBrown<Key, Value, Hash, KeyEqual, Allocator>::emplace(Args&&... args)
+{
+   using first_arg = std::remove_cvref_t<std::tuple_element_t<0, std::tuple<Args..., void>>>;
+
+   if constexpr (sizeof...(Args) == 3 && std::is_same_v<first_arg, std::piecewise_construct_t>)
+   {
+      return [this](std::piecewise_construct_t, auto&& key_args, auto&& value_args) {
+         auto emplace_value = [&](auto&& key) {
+            return std::apply([&](auto&&... vargs) {
+               return emplace_key(true, std::forward<decltype(key)>(key), std::forward<decltype(vargs)>(vargs)...).first;
+            }, std::forward<decltype(value_args)>(value_args));
+         };
+
+         using key_tuple = std::remove_cvref_t<decltype(key_args)>;
+         if constexpr (std::tuple_size_v<key_tuple> == 1
+                       && std::is_same_v<std::remove_cvref_t<std::tuple_element_t<0, key_tuple>>, Key>)
+         {
+            return emplace_value(std::get<0>(std::forward<decltype(key_args)>(key_args)));
+         }
+         else
+         {
+            return emplace_value(std::make_from_tuple<Key>(std::forward<decltype(key_args)>(key_args)));
+         }
+      }(std::forward<Args>(args)...);
+   }
+   else if constexpr (sizeof...(Args) == 2 && std::is_same_v<first_arg, Key>)
+   {
+      return emplace_key(true, std::forward<Args>(args)...).first;
+   }
+   else
+   {
+      value_type pair(std::forward<Args>(args)...);
+      return emplace_key(true, std::move(pair.first), std::move(pair.second)).first;
+   }
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+template <typename... Args>
+std::pair<typename HashBrown<Key, Value, Hash, KeyEqual, Allocator>::iterator, bool> HashBrown<Key, Value, Hash, KeyEqual, Allocator>::try_emplace(const Key& key, Args&&... args)
+{
+   return emplace_key(false, key, std::forward<Args>(args)...);
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+template <typename... Args>
+std::pair<typename HashBrown<Key, Value, Hash, KeyEqual, Allocator>::iterator, bool> HashBrown<Key, Value, Hash, KeyEqual, Allocator>::try_emplace(Key&& key, Args&&... args)
+{
+   return emplace_key(false, std::move(key), std::forward<Args>(args)...);
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+template <typename M>
+std::pair<typename HashBrown<Key, Value, Hash, KeyEqual, Allocator>::iterator, bool> HashBrown<Key, Value, Hash, KeyEqual, Allocator>::insert_or_assign(const Key& key, M&& obj)
+{
+   return emplace_key(true, key, std::forward<M>(obj));
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+template <typename M>
+std::pair<typename HashBrown<Key, Value, Hash, KeyEqual, Allocator>::iterator, bool> HashBrown<Key, Value, Hash, KeyEqual, Allocator>::insert_or_assign(Key&& key, M&& obj)
+{
+   return emplace_key(true, std::move(key), std::forward<M>(obj));
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+typename HashBrown<Key, Value, Hash, KeyEqual, Allocator>::node_type HashBrown<Key, Value, Hash, KeyEqual, Allocator>::extract(const_iterator position)
+{
+   const auto index = position._index;
+   const auto hash = index < _table.capacity
+      ? hash_at(_table, index)
+      : hash_at(_old, index - _table.capacity);
+   return extract_index(index, hash);
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+typename HashBrown<Key, Value, Hash, KeyEqual, Allocator>::node_type HashBrown<Key, Value, Hash, KeyEqual, Allocator>::extract(const Key& key)
+{
+   return extract_key(key);
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+template <typename K>
+typename HashBrown<Key, Value, Hash, KeyEqual, Allocator>::node_type HashBrown<Key, Value, Hash, KeyEqual, Allocator>::extract(const K& key)
+   requires transparent_lookup && (!std::is_convertible_v<const K&, const_iterator>)
+{
+   return extract_key(key);
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+typename HashBrown<Key, Value, Hash, KeyEqual, Allocator>::insert_return_type HashBrown<Key, Value, Hash, KeyEqual, Allocator>::insert(node_type&& node)
+{
+   if (node.empty())
+   {
+      return {end(), false, node_type{}};
+   }
+
+   migrate_step();
+
+   auto& entry = *node.entry();
+   const auto hash = node._hash_valid && same_hasher(node._hasher) ? node._hash : _hasher(entry.first);
+   const auto found = find_index(entry.first, hash);
+   if (found != npos)
+   {
+      return {iterator {this, found}, false, std::move(node)};
+   }
+
+   const auto index = prepare_insert(hash);
+   slot_traits::construct(_alloc, _table.slots + index, std::move(entry));
+   node.reset();
+   return {iterator {this, index}, true, node_type{}};
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+void HashBrown<Key, Value, Hash, KeyEqual, Allocator>::merge(HashBrown& source)
+{
+   if (&source == this)
+   {
+      return;
+   }
+
+   const auto reuse_hash = same_hasher(source._hasher);
+   for (auto* table : {&source._table, &source._old})
+   {
+      for (std::size_t i = 0; i < table->capacity && table->size != 0; ++i)
+      {
+         if (!hashbrown::detail::is_full(table->ctrl[i]))
+         {
+            continue;
+         }
+
+         // Every insert pays its share of a pending migration here too, or
+         // the new table could fill up before the old one is drained.
+         migrate_step();
+
+         auto& entry = table->slots[i];
+         const auto hash = reuse_hash ? source.hash_at(*table, i) : _hasher(entry.first);
+         if (find_index(entry.first, hash) != npos)
+         {
+            continue;
+         }
+
+         const auto index = prepare_insert(hash);
+         slot_traits::construct(_alloc, _table.slots + index, std::move(entry));
+         hashbrown::detail::erase_slot(source._alloc, *table, i);
+      }
+   }
+   source.migrate_step();
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+void HashBrown<Key, Value, Hash, KeyEqual, Allocator>::merge(HashBrown&& source)
+{
+   merge(source);
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+typename HashBrown<Key, Value, Hash, KeyEqual, Allocator>::iterator HashBrown<Key, Value, Hash, KeyEqual, Allocator>::begin()
+{
+   return iterator(this, next_full(0));
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+typename HashBrown<Key, Value, Hash, KeyEqual, Allocator>::const_iterator HashBrown<Key, Value, Hash, KeyEqual, Allocator>::begin() const
+{
+   return const_iterator(this, next_full(0));
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+typename HashBrown<Key, Value, Hash, KeyEqual, Allocator>::const_iterator HashBrown<Key, Value, Hash, KeyEqual, Allocator>::cbegin() const
+{
+   return begin();
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+typename HashBrown<Key, Value, Hash, KeyEqual, Allocator>::iterator HashBrown<Key, Value, Hash, KeyEqual, Allocator>::end()
+{
+   return iterator(this, _table.capacity + _old.capacity);
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+typename HashBrown<Key, Value, Hash, KeyEqual, Allocator>::const_iterator HashBrown<Key, Value, Hash, KeyEqual, Allocator>::end() const
+{
+   return const_iterator(this, _table.capacity + _old.capacity);
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+typename HashBrown<Key, Value, Hash, KeyEqual, Allocator>::const_iterator HashBrown<Key, Value, Hash, KeyEqual, Allocator>::cend() const
+{
+   return end();
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+template <typename Fn>
+void HashBrown<Key, Value, Hash, KeyEqual, Allocator>::for_each(hashbrown::Parallel policy, Fn fn)
+{
+   scan_parallel(policy, scan_runs(policy), [&](std::size_t, std::size_t first_group, std::size_t end_group) {
+      auto visit = [&](std::size_t index) { fn(slot(index)); };
+      for_each_full(first_group, end_group, visit);
+   });
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+template <typename Fn>
+void HashBrown<Key, Value, Hash, KeyEqual, Allocator>::for_each(hashbrown::Parallel policy, Fn fn) const
+{
+   scan_parallel(policy, scan_runs(policy), [&](std::size_t, std::size_t first_group, std::size_t end_group) {
+      auto visit = [&](std::size_t index) { fn(slot(index)); };
+      for_each_full(first_group, end_group, visit);
+   });
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+template <typename T, typename Reduce, typename Transform>
+T HashBrown<Key, Value, Hash, KeyEqual, Allocator>::transform_reduce(hashbrown::Parallel policy, T init, Reduce reduce,
+                                                                     Transform transform) const
+{
+   // A run that holds no entries has nothing to contribute, and no identity
+   // for reduce is known to stand in for it.
+   const auto runs = scan_runs(policy);
+   std::vector<std::optional<T>> partials(runs);
+   scan_parallel(policy, runs, [&](std::size_t run, std::size_t first_group, std::size_t end_group) {
+      auto& partial = partials[run];
+      auto visit = [&](std::size_t index) {
+         if (partial)
+         {
+            partial = reduce(std::move(*partial), transform(slot(index)));
+         }
+         else
+         {
+            partial.emplace(transform(slot(index)));
+         }
+      };
+      for_each_full(first_group, end_group, visit);
+   });
+
+   for (auto& partial : partials)
+   {
+      if (partial)
+      {
+         init = reduce(std::move(init), std::move(*partial));
+      }
+   }
+   return init;
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+template <typename K>
+std::size_t HashBrown<Key, Value, Hash, KeyEqual, Allocator>::find_in(const Table& table, const K& key, std::size_t hash) const
+{
+   return hashbrown::detail::find_slot(table, hash, [&](const value_type& entry) {
+      return _equal(entry.first, key);
+   });
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+template <typename K>
+std::size_t HashBrown<Key, Value, Hash, KeyEqual, Allocator>::find_index(const K& key, std::size_t hash) const
+{
+   const auto index = find_in(_table, key, hash);
+   if (index != npos || _old.capacity == 0)
+   {
+      return index;
+   }
+
+   const auto old_index = find_in(_old, key, hash);
+   return old_index == npos ? npos : _table.capacity + old_index;
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+template <typename K>
+typename HashBrown<Key, Value, Hash, KeyEqual, Allocator>::iterator HashBrown<Key, Value, Hash, KeyEqual, Allocator>::erase_key(const K& key)
+{
+   migrate_step();
+
+   const auto index = find_index(key, _hasher(key));
+   if (index == npos)
+   {
+      return end();
+   }
+
+   erase_index(index);
+   return iterator {this, next_full(index + 1)};
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+template <typename K, typename... Args>
+std::pair<typename HashBrown<Key, Value, Hash, KeyEqual, Allocator>::iterator, bool> HashBrown<Key, Value, Hash, KeyEqual, Allocator>::emplace_key(bool assign, K&& key, Args&&... args)
+{
+   migrate_step();
+
+   const auto hash = _hasher(key);
+   const auto found = find_index(key, hash);
+
+   if (found != npos)
+   {
+      if (assign)
+      {
+         if constexpr ((sizeof...(Args) == 1) && (std::is_assignable_v<Value&, Args&&> && ...))
+         {
+            ((slot(found).second = std::forward<Args>(args)), ...);
+         }
+         else
+         {
+            slot(found).second = Value(std::forward<Args>(args)...);
+         }
+      }
+      return {iterator {this, found}, false};
+   }
+
+   const auto index = prepare_insert(hash);
+   try
+   {
+      slot_traits::construct(_alloc, _table.slots + index,
+                             std::piecewise_construct,
+                             std::forward_as_tuple(std::forward<K>(key)),
+                             std::forward_as_tuple(std::forward<Args>(args)...));
+   }
+   catch (...)
+   {
+      hashbrown::detail::abandon_slot(_table, index);
+      throw;
+   }
+   return {iterator {this, index}, true};
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+template <hashbrown::detail::random_access It>
+void HashBrown<Key, Value, Hash, KeyEqual, Allocator>::fill_partition(It first, std::span<const std::pair<std::size_t, std::size_t>> entries,
+                                                                      std::size_t first_group, std::size_t end_group, ParallelFill& fill)
+{
+   // The serial find and insert in one pass, cut short as soon as the probe
+   // sequence reaches a group owned by another partition.
+   for (const auto& [hash, i] : entries)
+   {
+      decltype(auto) entry = *(first + i);
+      const auto h2 = hashbrown::detail::h2(hash);
+      hashbrown::detail::ProbeSeq seq{hash, _table.capacity / Group::width - 1};
+      auto free = npos;
+
+      while (true)
+      {
+         const auto group_index = seq.offset() / Group::width;
+         if (group_index < first_group || group_index >= end_group)
+         {
+            fill.spilled.push_back(i);
+            break;
+         }
+
+         const Group group{_table.ctrl + seq.offset()};
+         auto found = npos;
+         for (const auto j : group.match(h2))
+         {
+            const auto index = seq.offset() + j;
+            if constexpr (stored_hash)
+            {
+               if (_table.hashes[index] != hash)
+               {
+                  continue;
+               }
+            }
+            if (_equal(_table.slots[index].first, entry.first))
+            {
+               found = index;
+               break;
+            }
+         }
+         if (found != npos)
+         {
+            _table.slots[found].second = std::forward<decltype(entry)>(entry).second;
+            break;
+         }
+
+         if (free == npos)
+         {
+            if (const auto mask = group.match_empty_or_deleted())
+            {
+               free = seq.offset() + mask.lowest();
+            }
+         }
+         if (group.match_empty())
+         {
+            slot_traits::construct(_alloc, _table.slots + free, std::forward<decltype(entry)>(entry));
+            if (_table.ctrl[free] == hashbrown::detail::kEmpty)
+            {
+               ++fill.empties_used;
+            }
+            _table.ctrl[free] = h2;
+            if constexpr (stored_hash)
+            {
+               _table.hashes[free] = hash;
+            }
+            ++fill.inserted;
+            break;
+         }
+         seq.next();
+      }
+   }
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+template <typename K>
+typename HashBrown<Key, Value, Hash, KeyEqual, Allocator>::node_type HashBrown<Key, Value, Hash, KeyEqual, Allocator>::extract_key(const K& key)
+{
+   migrate_step();
+
+   const auto hash = _hasher(key);
+   const auto index = find_index(key, hash);
+   if (index == npos)
+   {
+      return node_type{};
+   }
+   return extract_index(index, hash);
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+typename HashBrown<Key, Value, Hash, KeyEqual, Allocator>::node_type HashBrown<Key, Value, Hash, KeyEqual, Allocator>::extract_index(std::size_t index, std::size_t hash)
+{
+   node_type node{_alloc, slot(index), _hasher, hash};
+   erase_index(index);
+   return node;
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+bool HashBrown<Key, Value, Hash, KeyEqual, Allocator>::same_hasher(const Hash& other) const
+{
+   // A hash computed by another hasher is only reusable if both would have
+   // computed the same one, e.g. they are stateless or carry the same seed.
+   if constexpr (std::is_empty_v<Hash>)
+   {
+      return true;
+   }
+   else if constexpr (std::equality_comparable<Hash>)
+   {
+      return _hasher == other;
+   }
+   else
+   {
+      return false;
+   }
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+std::size_t HashBrown<Key, Value, Hash, KeyEqual, Allocator>::prepare_insert(std::size_t hash)
+{
+   return hashbrown::detail::prepare_insert(_table, hash, [this] {
+      finish_migration();
+      const auto target = hashbrown::detail::growth_target(_table.capacity, _table.size, _max_load_factor);
+      if (_incremental && _table.size != 0)
+      {
+         start_migration(target);
+      }
+      else
+      {
+         resize(target);
+      }
+   });
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+void HashBrown<Key, Value, Hash, KeyEqual, Allocator>::erase_index(std::size_t index)
+{
+   if (index < _table.capacity)
+   {
+      hashbrown::detail::erase_slot(_alloc, _table, index);
+   }
+   else
+   {
+      hashbrown::detail::erase_slot(_alloc, _old, index - _table.capacity);
+   }
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+std::size_t HashBrown<Key, Value, Hash, KeyEqual, Allocator>::next_full(std::size_t index) const
+{
+   while (index < _table.capacity && !hashbrown::detail::is_full(_table.ctrl[index]))
+   {
+      ++index;
+   }
+   if (index < _table.capacity)
+   {
+      return index;
+   }
+
+   index = std::max(index, _table.capacity);
+   while (index < _table.capacity + _old.capacity
+          && !hashbrown::detail::is_full(_old.ctrl[index - _table.capacity]))
+   {
+      ++index;
+   }
+   return std::min(index, _table.capacity + _old.capacity);
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+template <typename Fn>
+void HashBrown<Key, Value, Hash, KeyEqual, Allocator>::for_each_full(std::size_t first_group, std::size_t end_group,
+                                                                     Fn& fn) const
+{
+   // Groups are numbered across _table and then _old, like slot indices.
+   for (auto group = first_group; group < end_group; ++group)
+   {
+      const auto index = group * Group::width;
+      const auto* ctrl = index < _table.capacity ? _table.ctrl + index : _old.ctrl + (index - _table.capacity);
+      for (const auto i : Group{ctrl}.match_full())
+      {
+         fn(index + i);
+      }
+   }
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+std::size_t HashBrown<Key, Value, Hash, KeyEqual, Allocator>::scan_runs(hashbrown::Parallel policy) const
+{
+   const auto slots = _table.capacity + _old.capacity;
+   const auto workers = hashbrown::detail::worker_count(policy.threads, slots, parallel_scan_grain);
+   return workers < 2 ? 1 : std::min(slots / Group::width, workers * partitions_per_worker);
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+template <typename Visit>
+void HashBrown<Key, Value, Hash, KeyEqual, Allocator>::scan_parallel(hashbrown::Parallel policy, std::size_t runs,
+                                                                     const Visit& visit) const
+{
+   const auto groups = (_table.capacity + _old.capacity) / Group::width;
+   const auto run_begin = [&](std::size_t run) {
+      return groups * run / runs;
+   };
+   if (runs == 1)
+   {
+      visit(0, 0, groups);
+      return;
+   }
+
+   // Threads take the runs in turn, so one that drew entries that are slow
+   // to visit does not hold the others up.
+   const auto workers = std::min(runs, hashbrown::detail::worker_count(policy.threads, runs, 1));
+   std::atomic<std::size_t> next_run{0};
+   hashbrown::detail::run_workers(workers, [&](std::size_t) {
+      for (auto run = next_run.fetch_add(1); run < runs; run = next_run.fetch_add(1))
+      {
+         visit(run, run_begin(run), run_begin(run + 1));
+      }
+   });
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+typename HashBrown<Key, Value, Hash, KeyEqual, Allocator>::value_type& HashBrown<Key, Value, Hash, KeyEqual, Allocator>::slot(std::size_t index)
+{
+   return index < _table.capacity ? _table.slots[index] : _old.slots[index - _table.capacity];
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+const typename HashBrown<Key, Value, Hash, KeyEqual, Allocator>::value_type& HashBrown<Key, Value, Hash, KeyEqual, Allocator>::slot(std::size_t index) const
+{
+   return index < _table.capacity ? _table.slots[index] : _old.slots[index - _table.capacity];
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+std::size_t HashBrown<Key, Value, Hash, KeyEqual, Allocator>::max_items(std::size_t capacity) const
+{
+   return hashbrown::detail::max_items(capacity, _max_load_factor);
+}
 
-template <typename Key, typename Value, typename Hash = HashFunction<Key>>
-class HashBrown
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+std::size_t HashBrown<Key, Value, Hash, KeyEqual, Allocator>::capacity_for(std::size_t count) const
 {
-   struct Bucket;
-   class Iterator;
+   return hashbrown::detail::capacity_for(count, _max_load_factor);
+}
 
-   public:
-      using value_type = std::pair<Key, Value>;
-      using reference = value_type&;
-      using pointer = value_type*;
-      using const_reference = const value_type&;
-      using iterator = Iterator;
-      using local_iterator = typename std::vector<value_type>::iterator;
-      using const_iterator = const Iterator;
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+void HashBrown<Key, Value, Hash, KeyEqual, Allocator>::destroy_table()
+{
+   hashbrown::detail::free_table(_alloc, _old);
+   hashbrown::detail::free_table(_alloc, _table);
+   _migrated = 0;
+}
 
-      constexpr HashBrown();
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+float HashBrown<Key, Value, Hash, KeyEqual, Allocator>::load_factor() const
+{
+   if (_table.capacity == 0)
+   {
+      return 0.0f;
+   }
+   return static_cast<float>(size()) / static_cast<float>(_table.capacity);
+}
 
-      iterator begin();
-      const_iterator begin() const;
-      const_iterator cbegin() const;
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+float HashBrown<Key, Value, Hash, KeyEqual, Allocator>::max_load_factor() const
+{
+   return _max_load_factor;
+}
 
-      iterator end();
-      const_iterator end() const;
-      const_iterator cend() const;
-   
-      iterator erase(const Key& key);
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+void HashBrown<Key, Value, Hash, KeyEqual, Allocator>::max_load_factor(float ml)
+{
+   hashbrown::detail::check_max_load_factor(ml);
 
-      void insert(std::initializer_list<value_type> il);
-      template <typename InputIt>
-      void insert(InputIt first, InputIt last);
-      iterator insert(Key key, Value value);
-      iterator insert(const value_type& value);
-      iterator insert(value_type&& value);
-      template <typename... Args>
-      iterator emplace(Args&&... args);
+   finish_migration();
+   _max_load_factor = ml;
+   if (_table.capacity != 0)
+   {
+      resize(std::max(_table.capacity, capacity_for(_table.size)));
+   }
+}
 
-      const Value* get(Key&& key) const;
-      bool empty() const;
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+void HashBrown<Key, Value, Hash, KeyEqual, Allocator>::rehash(std::size_t count)
+{
+   finish_migration();
 
-   private:
-      std::vector<Bucket> _buckets;
-      Hash _hasher;
-      std::size_t _items;
+   if (_table.size == 0 && count == 0)
+   {
+      destroy_table();
+      return;
+   }
 
-      std::size_t get_bucket_index(const Key& key) const;
-      float load_factor() const;
-      void resize();
+   auto target = capacity_for(_table.size);
+   while (target < count)
+   {
+      target *= 2;
+   }
 
-      class Iterator {
-         public:
-            using difference_type = std::ptrdiff_t;
-            using value_type = HashBrown<Key, Value, Hash>::value_type;
-            using reference = HashBrown<Key, Value, Hash>::reference;
-            using pointer = HashBrown<Key, Value, Hash>::pointer;
-            using iterator_category = std::forward_iterator_tag;
-      
-            Iterator(HashBrown<Key, Value, Hash>* hb, std::size_t bucket, std::size_t pos = 0)
-               : _hb(hb)
-               , _bucket(bucket)
-               , _pos(pos)
-            {
-            }
-      
-            Iterator& operator++()
-            {
-               const auto bucket = _hb->_buckets[_bucket];
-               
-               if (_pos == bucket.items.size())
-               {
-                  _pos = 0;
-                  _bucket++;
-               }
-               ++_pos;
-               return *this;
-            }
-      
-            Iterator& operator++(int)
-            {
-               auto temp = this;
-               ++*this;
-               return this;
-            }
-      
-            reference operator*()
-            {
-               auto& bucket = _hb->_buckets[_bucket];
-               return bucket.items[_pos];
-            }
-      
-            pointer operator->()
-            {
-               return &this->operator*();
-            }
-      
-            friend bool operator==(const Iterator& it_a, const Iterator& it_b)
+   if (target != _table.capacity)
+   {
+      resize(target);
+   }
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+void HashBrown<Key, Value, Hash, KeyEqual, Allocator>::reserve(std::size_t count)
+{
+   finish_migration();
+
+   const auto room = _table.capacity == 0 ? 0 : max_items(_table.capacity);
+   if (count > room)
+   {
+      rehash(capacity_for(count));
+   }
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+void HashBrown<Key, Value, Hash, KeyEqual, Allocator>::save(const std::filesystem::path& path) const
+   requires std::is_trivially_copyable_v<Key> && std::is_trivially_copyable_v<Value>
+{
+   using hashbrown::detail::SnapshotHeader;
+
+   const auto capacity = capacity_for(size());
+   const auto align_up = [](std::uint64_t offset, std::uint64_t alignment) {
+      return (offset + alignment - 1) / alignment * alignment;
+   };
+
+   SnapshotHeader header{};
+   std::memcpy(header.magic, SnapshotHeader::expected_magic, sizeof(header.magic));
+   header.version = SnapshotHeader::current_version;
+   header.group_width = Group::width;
+   header.key_size = sizeof(Key);
+   header.value_size = sizeof(Value);
+   header.slot_size = sizeof(value_type);
+   header.slot_align = alignof(value_type);
+   header.capacity = capacity;
+   header.size = size();
+   header.seed = hashbrown::detail::seed_of(_hasher);
+   header.check = hashbrown::detail::snapshot_check<Key>(_hasher);
+   header.ctrl_offset = align_up(sizeof(SnapshotHeader), hashbrown::detail::cache_line_size);
+   header.slots_offset = align_up(header.ctrl_offset + capacity, hashbrown::detail::cache_line_size);
+
+   // Lay the entries out afresh: this drops tombstones, folds in a pending
+   // migration and gives the smallest table the load factor allows.
+   std::vector<char> image(header.slots_offset + capacity * sizeof(value_type));
+   std::memcpy(image.data(), &header, sizeof(header));
+   auto ctrl = reinterpret_cast<ctrl_t*>(image.data() + header.ctrl_offset);
+   std::fill_n(ctrl, capacity, hashbrown::detail::kEmpty);
+   for (const auto& entry : *this)
+   {
+      const auto hash = _hasher(entry.first);
+      const auto index = hashbrown::detail::find_first_non_full(ctrl, capacity, hash);
+      ctrl[index] = hashbrown::detail::h2(hash);
+      std::memcpy(image.data() + header.slots_offset + index * sizeof(value_type), &entry, sizeof(value_type));
+   }
+
+   auto staging = path;
+   staging += ".tmp";
+   {
+      std::ofstream out{staging, std::ios::binary | std::ios::trunc};
+      out.write(image.data(), static_cast<std::streamsize>(image.size()));
+      out.close();
+      if (!out)
+      {
+         throw std::runtime_error("HashBrown::save: cannot write " + staging.string());
+      }
+   }
+   std::filesystem::rename(staging, path);
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+hashbrown::Stats HashBrown<Key, Value, Hash, KeyEqual, Allocator>::stats() const
+{
+   hashbrown::Stats stats;
+   stats.size = size();
+   stats.capacity = capacity();
+   stats.load_factor = load_factor();
+   stats.group_occupancy.assign(Group::width + 1, 0);
+
+   // During a migration the old table's moved-out slots are tombstones by
+   // design, so only the current table's are counted.
+   for (const auto table : {&_table, &_old})
+   {
+      for (std::size_t group = 0; group < table->capacity; group += Group::width)
+      {
+         std::size_t full = 0;
+         for (auto index = group; index < group + Group::width; ++index)
+         {
+            if (!hashbrown::detail::is_full(table->ctrl[index]))
             {
-               return it_a._hb == it_b._hb
-                  && it_a._bucket == it_b._bucket
-                  && it_a._pos == it_b._pos;
+               stats.tombstones += table == &_table && table->ctrl[index] == hashbrown::detail::kDeleted;
+               continue;
             }
-      
-            friend bool operator!=(const Iterator& it_a, const Iterator& it_b)
+            ++full;
+
+            hashbrown::detail::ProbeSeq seq{hash_at(*table, index), table->capacity / Group::width - 1};
+            std::size_t groups = 1;
+            while (seq.offset() != group)
             {
-               return !(it_a == it_b);
+               seq.next();
+               ++groups;
             }
-      
-         private:
-            HashBrown<Key, Value, Hash>* _hb;
-            std::size_t _bucket;
-            std::size_t _pos;
-      };
-};
+            stats.probe_lengths.resize(std::max(stats.probe_lengths.size(), groups));
+            ++stats.probe_lengths[groups - 1];
+         }
+         if (table == &_table)
+         {
+            ++stats.group_occupancy[full];
+         }
+      }
+      stats.allocated_bytes += table->capacity * (sizeof(ctrl_t) + sizeof(value_type) + (stored_hash ? sizeof(std::size_t) : 0));
+   }
+   if (stats.size != 0)
+   {
+      stats.bytes_per_entry = static_cast<double>(stats.allocated_bytes) / static_cast<double>(stats.size);
+   }
+
+   hashbrown::detail::read_counters(_counters, stats);
+   return stats;
+}
 
-template <typename Key, typename Value, typename Hash>
-constexpr HashBrown<Key, Value, Hash>::HashBrown()
-   : _buckets(1)
-   , _hasher()
-   , _items(0)
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+void HashBrown<Key, Value, Hash, KeyEqual, Allocator>::incremental_rehash(bool enabled)
 {
+   if (!enabled)
+   {
+      finish_migration();
+   }
+   _incremental = enabled;
 }
 
-template <typename Key, typename Value, typename Hash>
-typename HashBrown<Key, Value, Hash>::iterator HashBrown<Key, Value, Hash>::erase(const Key& key)
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+bool HashBrown<Key, Value, Hash, KeyEqual, Allocator>::incremental_rehash() const
 {
-   const auto bucket_index = get_bucket_index(key);
-   auto& bucket = _buckets[bucket_index];
+   return _incremental;
+}
 
-   auto find_it = std::ranges::find_if(bucket.items, [key](const auto& pair) {
-         const auto ekey = pair.first;
-         return ekey == key;
-   });
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+bool HashBrown<Key, Value, Hash, KeyEqual, Allocator>::rehashing() const
+{
+   return _old.capacity != 0;
+}
 
-   --_items;
-   auto erase_it = bucket.items.erase(find_it);
-   return iterator {
-      this,
-      bucket_index,
-      static_cast<std::size_t>(std::distance(bucket.items.begin(), erase_it))
-   };
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+std::size_t HashBrown<Key, Value, Hash, KeyEqual, Allocator>::hash_at(const Table& table, std::size_t index) const
+{
+   if constexpr (stored_hash)
+   {
+      return table.hashes[index];
+   }
+   else
+   {
+      return _hasher(table.slots[index].first);
+   }
 }
 
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+void HashBrown<Key, Value, Hash, KeyEqual, Allocator>::resize(std::size_t new_capacity)
+{
+   finish_migration();
+   [[maybe_unused]] const auto timer = hashbrown::detail::time_resize(_counters, true);
+
+   hashbrown::detail::resize_table(_alloc, _table, new_capacity, _max_load_factor, [this](const Table& table, std::size_t index) {
+      return hash_at(table, index);
+   });
+}
 
-template <typename Key, typename Value, typename Hash>
-void HashBrown<Key, Value, Hash>::insert(std::initializer_list<value_type> il)
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+void HashBrown<Key, Value, Hash, KeyEqual, Allocator>::start_migration(std::size_t new_capacity)
 {
-   insert(il.begin(), il.end());
+   // Size the new table so it cannot fill up before the old one is drained:
+   // it has to hold every live entry plus one insert per migration step.
+   const auto steps = _table.capacity / rehash_step + 1;
+   new_capacity = std::max(new_capacity, capacity_for(_table.size + steps));
+   [[maybe_unused]] const auto timer = hashbrown::detail::time_resize(_counters, true);
+
+   _old = std::exchange(_table, hashbrown::detail::allocate_table<Table>(_alloc, new_capacity, max_items(new_capacity)));
+   _migrated = 0;
 }
 
-template <typename Key, typename Value, typename Hash>
-template <typename InputIt>
-void HashBrown<Key, Value, Hash>::insert(InputIt first, InputIt last)
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+void HashBrown<Key, Value, Hash, KeyEqual, Allocator>::migrate_step()
 {
-   for (; first != last; ++first)
+   if (_old.capacity == 0)
    {
-      insert(*first);
+      return;
+   }
+   [[maybe_unused]] const auto timer = hashbrown::detail::time_resize(_counters, false);
+
+   // Moved slots become tombstones rather than empty so that probes for the
+   // entries still waiting in the old table keep working.
+   const auto stop = std::min(_migrated + rehash_step, _old.capacity);
+   for (; _migrated < stop && _old.size != 0; ++_migrated)
+   {
+      if (hashbrown::detail::is_full(_old.ctrl[_migrated]))
+      {
+         hashbrown::detail::transfer_slot(_alloc, _table, _old, _migrated, hash_at(_old, _migrated));
+         _old.ctrl[_migrated] = hashbrown::detail::kDeleted;
+         --_old.size;
+      }
+   }
+
+   if (_old.size == 0)
+   {
+      hashbrown::detail::free_table(_alloc, _old);
+      _migrated = 0;
    }
 }
 
-template <typename Key, typename Value, typename Hash>
-typename HashBrown<Key, Value, Hash>::iterator HashBrown<Key, Value, Hash>::insert(Key key, Value value)
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+void HashBrown<Key, Value, Hash, KeyEqual, Allocator>::finish_migration()
 {
-
-   if (_buckets.empty() || _items < 3 * _buckets.size() / 4) {
-      resize();
+   while (_old.capacity != 0)
+   {
+      migrate_step();
    }
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+const Value* HashBrown<Key, Value, Hash, KeyEqual, Allocator>::get(const Key& key) const
+{
+   const auto index = find_index(key, _hasher(key));
+   hashbrown::detail::count_lookup(_counters, index != npos);
 
-   const auto bucket_index = get_bucket_index(key);
-   auto& bucket = _buckets[bucket_index];
-   
-   for (auto it = bucket.items.begin(); it != bucket.items.end(); ++it)
+   if (index != npos)
    {
-      const auto& ekey = it->first;
-      auto& evalue = it->second;
+      return &slot(index).second;
+   }
+   return nullptr;
+}
 
-      if (ekey == key)
-      {
-         std::swap(evalue, value);
-         return iterator {this,
-                         bucket_index,
-                         static_cast<std::size_t>(std::distance(bucket.items.begin(), it))
-         };
-      }
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+template <typename K>
+const Value* HashBrown<Key, Value, Hash, KeyEqual, Allocator>::get(const K& key) const
+   requires transparent_lookup
+{
+   const auto index = find_index(key, _hasher(key));
+   hashbrown::detail::count_lookup(_counters, index != npos);
+
+   if (index != npos)
+   {
+      return &slot(index).second;
    }
+   return nullptr;
+}
 
-   _items++;
-   bucket.items.push_back(std::make_pair(std::forward<Key>(key), std::forward<Value>(value)));
-   return iterator {
-      this,
-      bucket_index,
-      bucket.items.size() - 1,
-   };
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+bool HashBrown<Key, Value, Hash, KeyEqual, Allocator>::contains(const Key& key) const
+{
+   const auto found = find_index(key, _hasher(key)) != npos;
+   hashbrown::detail::count_lookup(_counters, found);
+   return found;
 }
 
-template <typename Key, typename Value, typename Hash>
-typename HashBrown<Key, Value, Hash>::iterator HashBrown<Key, Value, Hash>::insert(const value_type& value)
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+template <typename K>
+bool HashBrown<Key, Value, Hash, KeyEqual, Allocator>::contains(const K& key) const
+   requires transparent_lookup
 {
-   const auto& key = value.first;
-   const auto& pair_value = value.second;
-   return insert(key, pair_value);
+   const auto found = find_index(key, _hasher(key)) != npos;
+   hashbrown::detail::count_lookup(_counters, found);
+   return found;
 }
 
-template <typename Key, typename Value, typename Hash>
-typename HashBrown<Key, Value, Hash>::iterator HashBrown<Key, Value, Hash>::insert(value_type&& value)
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+template <std::ranges::random_access_range Keys>
+void HashBrown<Key, Value, Hash, KeyEqual, Allocator>::get_many(const Keys& keys, std::span<const Value*> out) const
+   requires std::same_as<std::ranges::range_value_t<Keys>, Key> || transparent_lookup
 {
-   return emplace(std::forward<value_type>(value));
+   const auto count = static_cast<std::size_t>(std::ranges::size(keys));
+   if (out.size() < count)
+   {
+      throw std::invalid_argument("HashBrown::get_many: output is smaller than the key range");
+   }
+
+   const auto first = std::ranges::begin(keys);
+   const auto group_mask = _table.capacity / Group::width - 1;
+   const auto pipelined = _table.capacity * (sizeof(value_type) + sizeof(ctrl_t)) >= batch_prefetch_bytes;
+   std::size_t hashes[batch_block];
+
+   for (std::size_t base = 0; base < count; base += batch_block)
+   {
+      const auto block = std::min(batch_block, count - base);
+      for (std::size_t i = 0; i < block; ++i)
+      {
+         hashes[i] = _hasher(first[base + i]);
+      }
+
+      if (pipelined)
+      {
+         // Pass one: start loading each key's first group.
+         for (std::size_t i = 0; i < block; ++i)
+         {
+            const hashbrown::detail::ProbeSeq seq{hashes[i], group_mask};
+            hashbrown::detail::prefetch(_table.ctrl + seq.offset());
+         }
+
+         // Pass two: the groups have arrived, so start loading the first slot
+         // whose control byte matches. Without a match this touches the
+         // group's first slot, which is cheaper than a mispredicted branch.
+         for (std::size_t i = 0; i < block; ++i)
+         {
+            const hashbrown::detail::ProbeSeq seq{hashes[i], group_mask};
+            const Group group{_table.ctrl + seq.offset()};
+            const auto lowest = group.match(hashbrown::detail::h2(hashes[i])).lowest() & (Group::width - 1);
+            hashbrown::detail::prefetch(_table.slots + seq.offset() + lowest);
+         }
+      }
+
+      // Pass three: resolve each lookup against now warm cache lines.
+      for (std::size_t i = 0; i < block; ++i)
+      {
+         const auto index = find_index(first[base + i], hashes[i]);
+         hashbrown::detail::count_lookup(_counters, index != npos);
+         out[base + i] = index == npos ? nullptr : &slot(index).second;
+      }
+   }
 }
 
-template <typename Key, typename Value, typename Hash>
-template <typename... Args>
-typename HashBrown<Key, Value, Hash>::iterator HashBrown<Key, Value, Hash>::emplace(Args&&... args)
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+bool HashBrown<Key, Value, Hash, KeyEqual, Allocator>::empty() const
 {
-   const std::pair pair = {std::forward<Args>(args)...};
-   return insert(pair);
+   return begin() == end();
 }
-      
-template <typename Key, typename Value, typename Hash>
-typename HashBrown<Key, Value, Hash>::iterator HashBrown<Key, Value, Hash>::begin()
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+std::size_t HashBrown<Key, Value, Hash, KeyEqual, Allocator>::size() const
 {
-   return iterator(this, 0, 0);
+   return _table.size + _old.size;
 }
 
-template <typename Key, typename Value, typename Hash>
-typename HashBrown<Key, Value, Hash>::const_iterator HashBrown<Key, Value, Hash>::begin() const
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+std::size_t HashBrown<Key, Value, Hash, KeyEqual, Allocator>::capacity() const
 {
-   return const_cast<HashBrown*>(this)->begin();
+   return _table.capacity;
 }
 
-template <typename Key, typename Value, typename Hash>
-typename HashBrown<Key, Value, Hash>::const_iterator HashBrown<Key, Value, Hash>::cbegin() const
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+void HashBrown<Key, Value, Hash, KeyEqual, Allocator>::clear()
 {
-   return begin();
+   destroy_table();
 }
 
-template <typename Key, typename Value, typename Hash>
-typename HashBrown<Key, Value, Hash>::iterator HashBrown<Key, Value, Hash>::end()
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+void HashBrown<Key, Value, Hash, KeyEqual, Allocator>::swap(HashBrown& other) noexcept
 {
-   const auto bucket = _buckets.size() - 1;
-   return Iterator(this, bucket, _items);
+   if constexpr (slot_traits::propagate_on_container_swap::value)
+   {
+      using std::swap;
+      swap(_alloc, other._alloc);
+   }
+   swap_contents(other);
 }
 
-template <typename Key, typename Value, typename Hash>
-typename HashBrown<Key, Value, Hash>::const_iterator HashBrown<Key, Value, Hash>::end() const
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+typename HashBrown<Key, Value, Hash, KeyEqual, Allocator>::allocator_type HashBrown<Key, Value, Hash, KeyEqual, Allocator>::get_allocator() const
 {
-   return cend();
+   return allocator_type(_alloc);
 }
 
-template <typename Key, typename Value, typename Hash>
-typename HashBrown<Key, Value, Hash>::const_iterator HashBrown<Key, Value, Hash>::cend() const
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+Hash HashBrown<Key, Value, Hash, KeyEqual, Allocator>::hash_function() const
 {
-   return const_cast<HashBrown*>(this)->end();
+   return _hasher;
 }
 
-template <typename Key, typename Value, typename Hash>
-std::size_t HashBrown<Key, Value, Hash>::get_bucket_index(const Key& key) const
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+KeyEqual HashBrown<Key, Value, Hash, KeyEqual, Allocator>::key_eq() const
 {
-   const auto hash = _hasher(key);
-   const auto bucket_index = hash % _buckets.size();
-   return bucket_index;
+   return _equal;
 }
 
-template <typename Key, typename Value, typename Hash>
-float HashBrown<Key, Value, Hash>::load_factor() const
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+void HashBrown<Key, Value, Hash, KeyEqual, Allocator>::swap_contents(HashBrown& other) noexcept
 {
-   return 1.0;
+   using std::swap;
+   swap(_table, other._table);
+   swap(_old, other._old);
+   swap(_migrated, other._migrated);
+   swap(_incremental, other._incremental);
+   swap(_hasher, other._hasher);
+   swap(_equal, other._equal);
+   swap(_max_load_factor, other._max_load_factor);
 }
 
-template <typename Key, typename Value, typename Hash>
-void HashBrown<Key, Value, Hash>::resize()
+namespace hashbrown
 {
-   const auto determine_target_size = [this]() -> std::size_t {
-      const auto size = _buckets.size();
-      switch(size)
+   namespace detail
+   {
+      inline constexpr std::uint64_t secret[3] = {
+         0x2D358DCCAA6C78A5ull,
+         0x8BB84B93962EACC9ull,
+         0x4B33A62ED433D4A3ull,
+      };
+
+      // The full 128-bit product of a and b.
+      constexpr void multiply(std::uint64_t& a, std::uint64_t& b)
       {
-         case 0:
-            return 1;
-         default:
-            return 2 * size;
+#if defined(__SIZEOF_INT128__)
+         const auto product = static_cast<unsigned __int128>(a) * b;
+         a = static_cast<std::uint64_t>(product);
+         b = static_cast<std::uint64_t>(product >> 64);
+#else
+         const auto lo_lo = (a & 0xFFFFFFFFull) * (b & 0xFFFFFFFFull);
+         const auto hi_lo = (a >> 32) * (b & 0xFFFFFFFFull);
+         const auto lo_hi = (a & 0xFFFFFFFFull) * (b >> 32);
+         const auto hi_hi = (a >> 32) * (b >> 32);
+         const auto cross = (lo_lo >> 32) + (hi_lo & 0xFFFFFFFFull) + lo_hi;
+         a = (cross << 32) | (lo_lo & 0xFFFFFFFFull);
+         b = (hi_lo >> 32) + (cross >> 32) + hi_hi;
+#endif
+      }
+
+      // Folding the product's halves together lets every input bit reach
+      // both the low bits (h2) and the high bits (h1) of the result.
+      constexpr std::uint64_t folded_multiply(std::uint64_t a, std::uint64_t b)
+      {
+         multiply(a, b);
+         return a ^ b;
+      }
+
+      // Little-endian loads. At run time on little-endian hosts they are a
+      // plain memcpy; the byte loop keeps them usable in constant expressions
+      // and gives the same hashes on every host.
+      template <typename Byte>
+      constexpr std::uint64_t read_le(const Byte* p, std::size_t bytes)
+      {
+         std::uint64_t v = 0;
+         if (!std::is_constant_evaluated() && std::endian::native == std::endian::little)
+         {
+            std::memcpy(&v, p, bytes);
+            return v;
+         }
+         for (std::size_t i = 0; i < bytes; ++i)
+         {
+            v |= std::uint64_t{static_cast<unsigned char>(p[i])} << (8 * i);
+         }
+         return v;
+      }
+
+      template <typename Byte>
+      constexpr std::uint64_t read64(const Byte* p)
+      {
+         return read_le(p, 8);
       }
-   };
 
-   const auto target_size = determine_target_size();
-   std::vector<Bucket> new_buckets{target_size};
-   
-   for (auto & [key, value] : _buckets
-                    | std::views::transform([](auto& bucket) { return bucket.items; })
-                    | std::views::join)
+      template <typename Byte>
+      constexpr std::uint64_t read32(const Byte* p)
+      {
+         return read_le(p, 4);
+      }
+
+      template <typename Byte>
+      constexpr std::uint64_t hash_bytes(const Byte* p, std::size_t length, std::uint64_t seed);
+   }
+
+   // A multiply-xorshift finalizer for one 64-bit word, seeded. The seed is
+   // mixed into the value only: were it to touch the multiplier, some seed
+   // would zero it and send every key to the same hash. A zero seed mixes to
+   // zero, so unseeded hashes stay as they were.
+   constexpr std::uint64_t hash_int(std::uint64_t value, std::uint64_t seed = 0)
    {
-      const auto hash = Hash{}(key);
-      const auto bucket = hash % new_buckets.size();
-      new_buckets[bucket].items.emplace_back(key, value);
+      const auto mixed_seed = detail::folded_multiply(seed, detail::secret[2]);
+      return detail::folded_multiply(value ^ mixed_seed ^ detail::secret[0], detail::secret[1]);
    }
 
-   std::swap(_buckets, new_buckets);
-}
+   // A wyhash/rapidhash style hash over a byte range: 48 bytes per round in
+   // three independent lanes, each folded through a 64x64->128 multiply.
+   inline std::uint64_t hash_bytes(const void* data, std::size_t length, std::uint64_t seed = 0)
+   {
+      return detail::hash_bytes(static_cast<const unsigned char*>(data), length, seed);
+   }
 
-template <typename Key, typename Value, typename Hash>
-const Value* HashBrown<Key, Value, Hash>::get(Key&& key) const
-{
-   const auto bucket_index = get_bucket_index(key);
-   const auto& bucket = _buckets[bucket_index];
-   const auto find_it = std::ranges::find_if(bucket.items, [key](const auto& pair) {
-         const auto ekey = pair.first;
-         return ekey == key;
-   });
+   constexpr std::uint64_t hash_bytes(std::string_view bytes, std::uint64_t seed = 0)
+   {
+      return detail::hash_bytes(bytes.data(), bytes.size(), seed);
+   }
 
-   if (find_it != bucket.items.cend())
+   template <typename Byte>
+   constexpr std::uint64_t detail::hash_bytes(const Byte* p, std::size_t length, std::uint64_t seed)
    {
-      return &find_it->second;
+      seed ^= folded_multiply(seed ^ secret[0], secret[1]) ^ length;
+
+      std::uint64_t a = 0;
+      std::uint64_t b = 0;
+      if (length <= 16)
+      {
+         if (length >= 4)
+         {
+            const auto delta = (length >> 3) << 2;
+            a = (read32(p) << 32) | read32(p + delta);
+            b = (read32(p + length - 4) << 32) | read32(p + length - 4 - delta);
+         }
+         else if (length > 0)
+         {
+            a = (read_le(p, 1) << 56) | (read_le(p + (length >> 1), 1) << 32) | read_le(p + length - 1, 1);
+         }
+      }
+      else
+      {
+         auto left = length;
+         if (left > 48)
+         {
+            auto lane1 = seed;
+            auto lane2 = seed;
+            do
+            {
+               seed = folded_multiply(read64(p) ^ secret[0], read64(p + 8) ^ seed);
+               lane1 = folded_multiply(read64(p + 16) ^ secret[1], read64(p + 24) ^ lane1);
+               lane2 = folded_multiply(read64(p + 32) ^ secret[2], read64(p + 40) ^ lane2);
+               p += 48;
+               left -= 48;
+            } while (left > 48);
+            seed ^= lane1 ^ lane2;
+         }
+
+         if (left > 16)
+         {
+            seed = folded_multiply(read64(p) ^ secret[2], read64(p + 8) ^ seed);
+            if (left > 32)
+            {
+               seed = folded_multiply(read64(p + 16) ^ secret[2], read64(p + 24) ^ seed);
+            }
+         }
+         a = read64(p + left - 16);
+         b = read64(p + left - 8);
+      }
+
+      a ^= secret[1];
+      b ^= seed;
+      detail::multiply(a, b);
+      return folded_multiply(a ^ secret[0] ^ length, b ^ secret[1]);
    }
-   return nullptr;
-}
 
-template <typename Key, typename Value, typename Hash>
-bool HashBrown<Key, Value, Hash>::empty() const
-{
-   return begin() == end();
+   // A seed from the system's entropy source, for maps whose keys come from
+   // untrusted input.
+   inline std::uint64_t random_seed()
+   {
+      std::random_device device;
+      return (std::uint64_t{device()} << 32) ^ device();
+   }
 }
 
+// The default hasher. Integers, enums and pointers go through hash_int and
+// strings through hash_bytes; anything else has its std::hash value mixed,
+// since std::hash is the identity for many types. A seeded instance hashes
+// every key differently from the unseeded default.
 template <typename T>
 struct HashFunction
 {
-   std::size_t operator()(const T& t)
+   HashFunction() = default;
+
+   constexpr explicit HashFunction(std::uint64_t seed)
+      : _seed(seed)
+   {
+   }
+
+   constexpr std::size_t operator()(const T& t) const
+   {
+      if constexpr (std::is_integral_v<T> || std::is_enum_v<T>)
+      {
+         return static_cast<std::size_t>(hashbrown::hash_int(static_cast<std::uint64_t>(t), _seed));
+      }
+      else if constexpr (std::is_pointer_v<T>)
+      {
+         return static_cast<std::size_t>(hashbrown::hash_int(reinterpret_cast<std::uintptr_t>(t), _seed));
+      }
+      else
+      {
+         return static_cast<std::size_t>(hashbrown::hash_int(std::hash<T>{}(t), _seed));
+      }
+   }
+
+   constexpr std::uint64_t seed() const
+   {
+      return _seed;
+   }
+
+   bool operator==(const HashFunction&) const = default;
+
+   private:
+      std::uint64_t _seed = 0;
+};
+
+template <typename CharT, typename Traits, typename Allocator>
+struct HashFunction<std::basic_string<CharT, Traits, Allocator>>
+{
+   using is_transparent = void;
+
+   HashFunction() = default;
+
+   constexpr explicit HashFunction(std::uint64_t seed)
+      : _seed(seed)
+   {
+   }
+
+   constexpr std::size_t operator()(std::basic_string_view<CharT, Traits> sv) const
    {
-      return std::hash<T>{}(t);
+      if constexpr (sizeof(CharT) == 1)
+      {
+         return static_cast<std::size_t>(hashbrown::detail::hash_bytes(sv.data(), sv.size(), _seed));
+      }
+      else
+      {
+         return static_cast<std::size_t>(hashbrown::hash_bytes(sv.data(), sv.size() * sizeof(CharT), _seed));
+      }
    }
-   
-   std::size_t operator()(const T& t) const
+
+   constexpr std::uint64_t seed() const
    {
-      return std::hash<T>{}(t);
+      return _seed;
    }
+
+   bool operator==(const HashFunction&) const = default;
+
+   private:
+      std::uint64_t _seed = 0;
 };
 
-template <typename Key, typename Value, typename Hash>
-struct HashBrown<Key, Value, Hash>::Bucket
+template <typename CharT, typename Traits>
+struct HashFunction<std::basic_string_view<CharT, Traits>>
+   : HashFunction<std::basic_string<CharT, Traits>>
 {
-   std::vector<HashBrown<Key, Value, Hash>::value_type> items;
+   using HashFunction<std::basic_string<CharT, Traits>>::HashFunction;
 };
 
+namespace hashbrown::pmr
+{
+   template <typename Key, typename Value, typename Hash = HashFunction<Key>, typename KeyEqual = std::equal_to<>>
+   using HashBrown = ::HashBrown<Key, Value, Hash, KeyEqual, std::pmr::polymorphic_allocator<std::pair<Key, Value>>>;
+}
@@ -0,0 +1,794 @@
+#pragma once
+
+#include <hashbrown.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <memory_resource>
+#include <type_traits>
+#include <utility>
+
+// A HashBrown that stores keys only: the same table core from
+// hashbrown::detail, so the same probing, stored-hash policy and growth
+// rules, with slots that hold a Key and nothing else. The set operators probe with the hashes a table already
+// holds whenever both tables hash alike, so no key is hashed twice.
+template <typename Key,
+          typename Hash = HashFunction<Key>,
+          typename KeyEqual = std::equal_to<>,
+          typename Allocator = std::allocator<Key>>
+class HashBrownSet
+{
+   class Iterator;
+
+   static constexpr bool transparent_lookup =
+      hashbrown::detail::transparent<Hash> && hashbrown::detail::transparent<KeyEqual>;
+
+   static constexpr bool move_assign_noexcept =
+      std::allocator_traits<Allocator>::propagate_on_container_move_assignment::value
+      || std::allocator_traits<Allocator>::is_always_equal::value;
+
+   public:
+      static constexpr bool stored_hash = hashbrown::detail::stores_hash<Key, Hash>();
+
+      using key_type = Key;
+      using value_type = Key;
+      using reference = const Key&;
+      using const_reference = const Key&;
+      // Keys cannot change in place, so both iterators are const.
+      using iterator = Iterator;
+      using const_iterator = Iterator;
+      using allocator_type = Allocator;
+
+      constexpr HashBrownSet();
+      explicit HashBrownSet(const Allocator& alloc);
+      explicit HashBrownSet(const Hash& hash, const KeyEqual& equal = KeyEqual(), const Allocator& alloc = Allocator());
+      HashBrownSet(std::initializer_list<Key> il, const Allocator& alloc = Allocator());
+      HashBrownSet(const HashBrownSet& other);
+      HashBrownSet(const HashBrownSet& other, const Allocator& alloc);
+      HashBrownSet(HashBrownSet&& other) noexcept;
+      HashBrownSet& operator=(const HashBrownSet& other);
+      HashBrownSet& operator=(HashBrownSet&& other) noexcept(move_assign_noexcept);
+      ~HashBrownSet();
+
+      iterator begin() const;
+      iterator cbegin() const;
+      iterator end() const;
+      iterator cend() const;
+
+      iterator erase(const Key& key);
+      template <typename K>
+      iterator erase(const K& key) requires transparent_lookup;
+
+      void insert(std::initializer_list<Key> il);
+      template <std::input_iterator InputIt>
+      void insert(InputIt first, InputIt last);
+      std::pair<iterator, bool> insert(const Key& key);
+      std::pair<iterator, bool> insert(Key&& key);
+      template <typename... Args>
+      std::pair<iterator, bool> emplace(Args&&... args);
+
+      // The stored key equal to key, e.g. to intern strings.
+      const Key* get(const Key& key) const;
+      template <typename K>
+      const Key* get(const K& key) const requires transparent_lookup;
+      bool contains(const Key& key) const;
+      template <typename K>
+      bool contains(const K& key) const requires transparent_lookup;
+      bool empty() const;
+      std::size_t size() const;
+      std::size_t capacity() const;
+      void clear();
+      void swap(HashBrownSet& other) noexcept;
+      allocator_type get_allocator() const;
+      Hash hash_function() const;
+      KeyEqual key_eq() const;
+
+      float load_factor() const;
+      float max_load_factor() const;
+      void max_load_factor(float ml);
+      void rehash(std::size_t count);
+      void reserve(std::size_t count);
+
+      // Union, intersection and difference in place. The result keeps this
+      // set's hasher, allocator and load factor.
+      HashBrownSet& operator|=(const HashBrownSet& other);
+      HashBrownSet& operator&=(const HashBrownSet& other);
+      HashBrownSet& operator-=(const HashBrownSet& other);
+
+      friend HashBrownSet operator|(const HashBrownSet& a, const HashBrownSet& b)
+      {
+         HashBrownSet result{a};
+         result |= b;
+         return result;
+      }
+
+      friend HashBrownSet operator&(const HashBrownSet& a, const HashBrownSet& b)
+      {
+         HashBrownSet result{a._hasher, a._equal, a.get_allocator()};
+         result._max_load_factor = a._max_load_factor;
+         result.add_common(a, b);
+         return result;
+      }
+
+      friend HashBrownSet operator-(const HashBrownSet& a, const HashBrownSet& b)
+      {
+         HashBrownSet result{a._hasher, a._equal, a.get_allocator()};
+         result._max_load_factor = a._max_load_factor;
+         result.add_missing(a, b);
+         return result;
+      }
+
+      friend bool operator==(const HashBrownSet& a, const HashBrownSet& b)
+      {
+         if (a._table.size != b._table.size)
+         {
+            return false;
+         }
+         for (auto slot = a.next_full(0); slot < a._table.capacity; slot = a.next_full(slot + 1))
+         {
+            if (b.find_slot(a._table.slots[slot], b.hash_from(a, slot)) == npos)
+            {
+               return false;
+            }
+         }
+         return true;
+      }
+
+   private:
+      using key_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Key>;
+      using key_traits = std::allocator_traits<key_allocator>;
+      using Table = hashbrown::detail::Table<Key, stored_hash>;
+
+      static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+      Table _table;
+      Hash _hasher;
+      KeyEqual _equal;
+      float _max_load_factor;
+      [[no_unique_address]] key_allocator _alloc;
+
+      template <typename K>
+      std::size_t find_slot(const K& key, std::size_t hash) const;
+      template <typename K>
+      iterator erase_key(const K& key);
+      template <typename K>
+      std::pair<iterator, bool> insert_hashed(K&& key, std::size_t hash);
+      void erase_slot(std::size_t slot);
+      std::size_t next_full(std::size_t slot) const;
+      std::size_t hash_at(const Table& table, std::size_t slot) const;
+      std::size_t hash_from(const HashBrownSet& source, std::size_t slot) const;
+      bool same_hasher(const Hash& other) const;
+      void add_common(const HashBrownSet& a, const HashBrownSet& b);
+      void add_missing(const HashBrownSet& a, const HashBrownSet& b);
+
+      void destroy();
+      void resize(std::size_t new_capacity);
+      void swap_contents(HashBrownSet& other) noexcept;
+
+      class Iterator {
+         public:
+            using difference_type = std::ptrdiff_t;
+            using value_type = Key;
+            using reference = const Key&;
+            using pointer = const Key*;
+            using iterator_category = std::forward_iterator_tag;
+
+            Iterator() = default;
+
+            Iterator(const HashBrownSet* hb, std::size_t slot)
+               : _hb(hb)
+               , _slot(slot)
+            {
+            }
+
+            Iterator& operator++()
+            {
+               _slot = _hb->next_full(_slot + 1);
+               return *this;
+            }
+
+            Iterator operator++(int)
+            {
+               auto temp = *this;
+               ++*this;
+               return temp;
+            }
+
+            reference operator*() const
+            {
+               return _hb->_table.slots[_slot];
+            }
+
+            pointer operator->() const
+            {
+               return &this->operator*();
+            }
+
+            friend bool operator==(const Iterator& it_a, const Iterator& it_b)
+            {
+               return it_a._hb == it_b._hb
+                  && it_a._slot == it_b._slot;
+            }
+
+            friend bool operator!=(const Iterator& it_a, const Iterator& it_b)
+            {
+               return !(it_a == it_b);
+            }
+
+         private:
+            const HashBrownSet* _hb = nullptr;
+            std::size_t _slot = 0;
+      };
+};
+
+template <typename Key, typename Hash, typename KeyEqual, typename Allocator>
+constexpr HashBrownSet<Key, Hash, KeyEqual, Allocator>::HashBrownSet()
+   : HashBrownSet(Allocator())
+{
+}
+
+template <typename Key, typename Hash, typename KeyEqual, typename Allocator>
+HashBrownSet<Key, Hash, KeyEqual, Allocator>::HashBrownSet(const Allocator& alloc)
+   : HashBrownSet(Hash(), KeyEqual(), alloc)
+{
+}
+
+template <typename Key, typename Hash, typename KeyEqual, typename Allocator>
+HashBrownSet<Key, Hash, KeyEqual, Allocator>::HashBrownSet(const Hash& hash, const KeyEqual& equal, const Allocator& alloc)
+   : _table()
+   , _hasher(hash)
+   , _equal(equal)
+   , _max_load_factor(hashbrown::detail::default_max_load_factor)
+   , _alloc(alloc)
+{
+}
+
+template <typename Key, typename Hash, typename KeyEqual, typename Allocator>
+HashBrownSet<Key, Hash, KeyEqual, Allocator>::HashBrownSet(std::initializer_list<Key> il, const Allocator& alloc)
+   : HashBrownSet(alloc)
+{
+   insert(il);
+}
+
+template <typename Key, typename Hash, typename KeyEqual, typename Allocator>
+HashBrownSet<Key, Hash, KeyEqual, Allocator>::HashBrownSet(const HashBrownSet& other)
+   : HashBrownSet(other, key_traits::select_on_container_copy_construction(other._alloc))
+{
+}
+
+template <typename Key, typename Hash, typename KeyEqual, typename Allocator>
+HashBrownSet<Key, Hash, KeyEqual, Allocator>::HashBrownSet(const HashBrownSet& other, const Allocator& alloc)
+   : HashBrownSet(alloc)
+{
+   _hasher = other._hasher;
+   _equal = other._equal;
+   _max_load_factor = other._max_load_factor;
+
+   if (other._table.size != 0)
+   {
+      _table = hashbrown::detail::copy_table(_alloc, other._table);
+   }
+}
+
+template <typename Key, typename Hash, typename KeyEqual, typename Allocator>
+HashBrownSet<Key, Hash, KeyEqual, Allocator>::HashBrownSet(HashBrownSet&& other) noexcept
+   : _table(std::exchange(other._table, Table{}))
+   , _hasher(std::move(other._hasher))
+   , _equal(std::move(other._equal))
+   , _max_load_factor(other._max_load_factor)
+   , _alloc(std::move(other._alloc))
+{
+}
+
+template <typename Key, typename Hash, typename KeyEqual, typename Allocator>
+HashBrownSet<Key, Hash, KeyEqual, Allocator>& HashBrownSet<Key, Hash, KeyEqual, Allocator>::operator=(const HashBrownSet& other)
+{
+   if (this != &other)
+   {
+      if constexpr (key_traits::propagate_on_container_copy_assignment::value)
+      {
+         destroy();
+         _alloc = other._alloc;
+      }
+      HashBrownSet copy{other, _alloc};
+      swap_contents(copy);
+   }
+   return *this;
+}
+
+template <typename Key, typename Hash, typename KeyEqual, typename Allocator>
+HashBrownSet<Key, Hash, KeyEqual, Allocator>& HashBrownSet<Key, Hash, KeyEqual, Allocator>::operator=(HashBrownSet&& other) noexcept(move_assign_noexcept)
+{
+   if (this == &other)
+   {
+      return *this;
+   }
+
+   if constexpr (key_traits::propagate_on_container_move_assignment::value)
+   {
+      destroy();
+      _alloc = std::move(other._alloc);
+      swap_contents(other);
+   }
+   else if (_alloc == other._alloc)
+   {
+      destroy();
+      swap_contents(other);
+   }
+   else
+   {
+      // Storage from another allocator cannot be adopted; move the keys.
+      clear();
+      reserve(other._table.size);
+      for (auto slot = other.next_full(0); slot < other._table.capacity; slot = other.next_full(slot + 1))
+      {
+         insert(std::move(other._table.slots[slot]));
+      }
+      other.clear();
+   }
+   return *this;
+}
+
+template <typename Key, typename Hash, typename KeyEqual, typename Allocator>
+HashBrownSet<Key, Hash, KeyEqual, Allocator>::~HashBrownSet()
+{
+   destroy();
+}
+
+template <typename Key, typename Hash, typename KeyEqual, typename Allocator>
+typename HashBrownSet<Key, Hash, KeyEqual, Allocator>::iterator HashBrownSet<Key, Hash, KeyEqual, Allocator>::begin() const
+{
+   return iterator(this, next_full(0));
+}
+
+template <typename Key, typename Hash, typename KeyEqual, typename Allocator>
+typename HashBrownSet<Key, Hash, KeyEqual, Allocator>::iterator HashBrownSet<Key, Hash, KeyEqual, Allocator>::cbegin() const
+{
+   return begin();
+}
+
+template <typename Key, typename Hash, typename KeyEqual, typename Allocator>
+typename HashBrownSet<Key, Hash, KeyEqual, Allocator>::iterator HashBrownSet<Key, Hash, KeyEqual, Allocator>::end() const
+{
+   return iterator(this, _table.capacity);
+}
+
+template <typename Key, typename Hash, typename KeyEqual, typename Allocator>
+typename HashBrownSet<Key, Hash, KeyEqual, Allocator>::iterator HashBrownSet<Key, Hash, KeyEqual, Allocator>::cend() const
+{
+   return end();
+}
+
+template <typename Key, typename Hash, typename KeyEqual, typename Allocator>
+typename HashBrownSet<Key, Hash, KeyEqual, Allocator>::iterator HashBrownSet<Key, Hash, KeyEqual, Allocator>::erase(const Key& key)
+{
+   return erase_key(key);
+}
+
+template <typename Key, typename Hash, typename KeyEqual, typename Allocator>
+template <typename K>
+typename HashBrownSet<Key, Hash, KeyEqual, Allocator>::iterator HashBrownSet<Key, Hash, KeyEqual, Allocator>::erase(const K& key)
+   requires transparent_lookup
+{
+   return erase_key(key);
+}
+
+template <typename Key, typename Hash, typename KeyEqual, typename Allocator>
+void HashBrownSet<Key, Hash, KeyEqual, Allocator>::insert(std::initializer_list<Key> il)
+{
+   insert(il.begin(), il.end());
+}
+
+template <typename Key, typename Hash, typename KeyEqual, typename Allocator>
+template <std::input_iterator InputIt>
+void HashBrownSet<Key, Hash, KeyEqual, Allocator>::insert(InputIt first, InputIt last)
+{
+   if constexpr (std::forward_iterator<InputIt>)
+   {
+      reserve(_table.size + static_cast<std::size_t>(std::distance(first, last)));
+   }
+
+   for (; first != last; ++first)
+   {
+      insert(*first);
+   }
+}
+
+template <typename Key, typename Hash, typename KeyEqual, typename Allocator>
+std::pair<typename HashBrownSet<Key, Hash, KeyEqual, Allocator>::iterator, bool> HashBrownSet<Key, Hash, KeyEqual, Allocator>::insert(const Key& key)
+{
+   return insert_hashed(key, _hasher(key));
+}
+
+template <typename Key, typename Hash, typename KeyEqual, typename Allocator>
+std::pair<typename HashBrownSet<Key, Hash, KeyEqual, Allocator>::iterator, bool> HashBrownSet<Key, Hash, KeyEqual, Allocator>::insert(Key&& key)
+{
+   const auto hash = _hasher(key);
+   return insert_hashed(std::move(key), hash);
+}
+
+template <typename Key, typename Hash, typename KeyEqual, typename Allocator>
+template <typename... Args>
+std::pair<typename HashBrownSet<Key, Hash, KeyEqual, Allocator>::iterator, bool> HashBrownSet<Key, Hash, KeyEqual, Allocator>::emplace(Args&&... args)
+{
+   Key key(std::forward<Args>(args)...);
+   return insert(std::move(key));
+}
+
+template <typename Key, typename Hash, typename KeyEqual, typename Allocator>
+const Key* HashBrownSet<Key, Hash, KeyEqual, Allocator>::get(const Key& key) const
+{
+   const auto slot = find_slot(key, _hasher(key));
+   return slot == npos ? nullptr : _table.slots + slot;
+}
+
+template <typename Key, typename Hash, typename KeyEqual, typename Allocator>
+template <typename K>
+const Key* HashBrownSet<Key, Hash, KeyEqual, Allocator>::get(const K& key) const
+   requires transparent_lookup
+{
+   const auto slot = find_slot(key, _hasher(key));
+   return slot == npos ? nullptr : _table.slots + slot;
+}
+
+template <typename Key, typename Hash, typename KeyEqual, typename Allocator>
+bool HashBrownSet<Key, Hash, KeyEqual, Allocator>::contains(const Key& key) const
+{
+   return find_slot(key, _hasher(key)) != npos;
+}
+
+template <typename Key, typename Hash, typename KeyEqual, typename Allocator>
+template <typename K>
+bool HashBrownSet<Key, Hash, KeyEqual, Allocator>::contains(const K& key) const
+   requires transparent_lookup
+{
+   return find_slot(key, _hasher(key)) != npos;
+}
+
+template <typename Key, typename Hash, typename KeyEqual, typename Allocator>
+bool HashBrownSet<Key, Hash, KeyEqual, Allocator>::empty() const
+{
+   return _table.size == 0;
+}
+
+template <typename Key, typename Hash, typename KeyEqual, typename Allocator>
+std::size_t HashBrownSet<Key, Hash, KeyEqual, Allocator>::size() const
+{
+   return _table.size;
+}
+
+template <typename Key, typename Hash, typename KeyEqual, typename Allocator>
+std::size_t HashBrownSet<Key, Hash, KeyEqual, Allocator>::capacity() const
+{
+   return _table.capacity;
+}
+
+template <typename Key, typename Hash, typename KeyEqual, typename Allocator>
+void HashBrownSet<Key, Hash, KeyEqual, Allocator>::clear()
+{
+   destroy();
+}
+
+template <typename Key, typename Hash, typename KeyEqual, typename Allocator>
+void HashBrownSet<Key, Hash, KeyEqual, Allocator>::swap(HashBrownSet& other) noexcept
+{
+   if constexpr (key_traits::propagate_on_container_swap::value)
+   {
+      using std::swap;
+      swap(_alloc, other._alloc);
+   }
+   swap_contents(other);
+}
+
+template <typename Key, typename Hash, typename KeyEqual, typename Allocator>
+typename HashBrownSet<Key, Hash, KeyEqual, Allocator>::allocator_type HashBrownSet<Key, Hash, KeyEqual, Allocator>::get_allocator() const
+{
+   return allocator_type(_alloc);
+}
+
+template <typename Key, typename Hash, typename KeyEqual, typename Allocator>
+Hash HashBrownSet<Key, Hash, KeyEqual, Allocator>::hash_function() const
+{
+   return _hasher;
+}
+
+template <typename Key, typename Hash, typename KeyEqual, typename Allocator>
+KeyEqual HashBrownSet<Key, Hash, KeyEqual, Allocator>::key_eq() const
+{
+   return _equal;
+}
+
+template <typename Key, typename Hash, typename KeyEqual, typename Allocator>
+float HashBrownSet<Key, Hash, KeyEqual, Allocator>::load_factor() const
+{
+   if (_table.capacity == 0)
+   {
+      return 0.0f;
+   }
+   return static_cast<float>(_table.size) / static_cast<float>(_table.capacity);
+}
+
+template <typename Key, typename Hash, typename KeyEqual, typename Allocator>
+float HashBrownSet<Key, Hash, KeyEqual, Allocator>::max_load_factor() const
+{
+   return _max_load_factor;
+}
+
+template <typename Key, typename Hash, typename KeyEqual, typename Allocator>
+void HashBrownSet<Key, Hash, KeyEqual, Allocator>::max_load_factor(float ml)
+{
+   hashbrown::detail::check_max_load_factor(ml);
+
+   _max_load_factor = ml;
+   if (_table.capacity != 0)
+   {
+      resize(std::max(_table.capacity, hashbrown::detail::capacity_for(_table.size, _max_load_factor)));
+   }
+}
+
+template <typename Key, typename Hash, typename KeyEqual, typename Allocator>
+void HashBrownSet<Key, Hash, KeyEqual, Allocator>::rehash(std::size_t count)
+{
+   if (_table.size == 0 && count == 0)
+   {
+      destroy();
+      return;
+   }
+
+   auto target = hashbrown::detail::capacity_for(_table.size, _max_load_factor);
+   while (target < count)
+   {
+      target *= 2;
+   }
+
+   if (target != _table.capacity || _table.growth_left != hashbrown::detail::max_items(_table.capacity, _max_load_factor) - _table.size)
+   {
+      resize(target);
+   }
+}
+
+template <typename Key, typename Hash, typename KeyEqual, typename Allocator>
+void HashBrownSet<Key, Hash, KeyEqual, Allocator>::reserve(std::size_t count)
+{
+   if (count > _table.size + _table.growth_left)
+   {
+      rehash(hashbrown::detail::capacity_for(count, _max_load_factor));
+   }
+}
+
+template <typename Key, typename Hash, typename KeyEqual, typename Allocator>
+HashBrownSet<Key, Hash, KeyEqual, Allocator>& HashBrownSet<Key, Hash, KeyEqual, Allocator>::operator|=(const HashBrownSet& other)
+{
+   if (&other == this)
+   {
+      return *this;
+   }
+
+   for (auto slot = other.next_full(0); slot < other._table.capacity; slot = other.next_full(slot + 1))
+   {
+      insert_hashed(other._table.slots[slot], hash_from(other, slot));
+   }
+   return *this;
+}
+
+template <typename Key, typename Hash, typename KeyEqual, typename Allocator>
+HashBrownSet<Key, Hash, KeyEqual, Allocator>& HashBrownSet<Key, Hash, KeyEqual, Allocator>::operator&=(const HashBrownSet& other)
+{
+   if (&other == this)
+   {
+      return *this;
+   }
+
+   // Erasing never moves a key, so the sweep can drop keys as it goes.
+   for (auto slot = next_full(0); slot < _table.capacity; slot = next_full(slot + 1))
+   {
+      if (other.find_slot(_table.slots[slot], other.hash_from(*this, slot)) == npos)
+      {
+         erase_slot(slot);
+      }
+   }
+   return *this;
+}
+
+template <typename Key, typename Hash, typename KeyEqual, typename Allocator>
+HashBrownSet<Key, Hash, KeyEqual, Allocator>& HashBrownSet<Key, Hash, KeyEqual, Allocator>::operator-=(const HashBrownSet& other)
+{
+   if (&other == this)
+   {
+      clear();
+      return *this;
+   }
+
+   // Walk whichever side is smaller.
+   if (other._table.size < _table.size)
+   {
+      for (auto slot = other.next_full(0); slot < other._table.capacity; slot = other.next_full(slot + 1))
+      {
+         const auto found = find_slot(other._table.slots[slot], hash_from(other, slot));
+         if (found != npos)
+         {
+            erase_slot(found);
+         }
+      }
+   }
+   else
+   {
+      for (auto slot = next_full(0); slot < _table.capacity; slot = next_full(slot + 1))
+      {
+         if (other.find_slot(_table.slots[slot], other.hash_from(*this, slot)) != npos)
+         {
+            erase_slot(slot);
+         }
+      }
+   }
+   return *this;
+}
+
+template <typename Key, typename Hash, typename KeyEqual, typename Allocator>
+template <typename K>
+std::size_t HashBrownSet<Key, Hash, KeyEqual, Allocator>::find_slot(const K& key, std::size_t hash) const
+{
+   return hashbrown::detail::find_slot(_table, hash, [&](const Key& stored) {
+      return _equal(stored, key);
+   });
+}
+
+template <typename Key, typename Hash, typename KeyEqual, typename Allocator>
+template <typename K>
+typename HashBrownSet<Key, Hash, KeyEqual, Allocator>::iterator HashBrownSet<Key, Hash, KeyEqual, Allocator>::erase_key(const K& key)
+{
+   const auto slot = find_slot(key, _hasher(key));
+   if (slot == npos)
+   {
+      return end();
+   }
+
+   erase_slot(slot);
+   return iterator {this, next_full(slot)};
+}
+
+template <typename Key, typename Hash, typename KeyEqual, typename Allocator>
+template <typename K>
+std::pair<typename HashBrownSet<Key, Hash, KeyEqual, Allocator>::iterator, bool> HashBrownSet<Key, Hash, KeyEqual, Allocator>::insert_hashed(K&& key, std::size_t hash)
+{
+   if (const auto found = find_slot(key, hash); found != npos)
+   {
+      return {iterator {this, found}, false};
+   }
+
+   const auto slot = hashbrown::detail::prepare_insert(_table, hash, [this] {
+      resize(hashbrown::detail::growth_target(_table.capacity, _table.size, _max_load_factor));
+   });
+   try
+   {
+      key_traits::construct(_alloc, _table.slots + slot, std::forward<K>(key));
+   }
+   catch (...)
+   {
+      hashbrown::detail::abandon_slot(_table, slot);
+      throw;
+   }
+   return {iterator {this, slot}, true};
+}
+
+template <typename Key, typename Hash, typename KeyEqual, typename Allocator>
+void HashBrownSet<Key, Hash, KeyEqual, Allocator>::erase_slot(std::size_t slot)
+{
+   hashbrown::detail::erase_slot(_alloc, _table, slot);
+}
+
+template <typename Key, typename Hash, typename KeyEqual, typename Allocator>
+std::size_t HashBrownSet<Key, Hash, KeyEqual, Allocator>::next_full(std::size_t slot) const
+{
+   while (slot < _table.capacity && !hashbrown::detail::is_full(_table.ctrl[slot]))
+   {
+      ++slot;
+   }
+   return slot;
+}
+
+template <typename Key, typename Hash, typename KeyEqual, typename Allocator>
+std::size_t HashBrownSet<Key, Hash, KeyEqual, Allocator>::hash_at(const Table& table, std::size_t slot) const
+{
+   if constexpr (stored_hash)
+   {
+      return table.hashes[slot];
+   }
+   else
+   {
+      return _hasher(table.slots[slot]);
+   }
+}
+
+template <typename Key, typename Hash, typename KeyEqual, typename Allocator>
+std::size_t HashBrownSet<Key, Hash, KeyEqual, Allocator>::hash_from(const HashBrownSet& source, std::size_t slot) const
+{
+   // The source's hash for one of its keys, as this set would compute it.
+   if constexpr (stored_hash)
+   {
+      if (same_hasher(source._hasher))
+      {
+         return source._table.hashes[slot];
+      }
+   }
+   return _hasher(source._table.slots[slot]);
+}
+
+template <typename Key, typename Hash, typename KeyEqual, typename Allocator>
+bool HashBrownSet<Key, Hash, KeyEqual, Allocator>::same_hasher(const Hash& other) const
+{
+   if constexpr (std::is_empty_v<Hash>)
+   {
+      return true;
+   }
+   else if constexpr (std::equality_comparable<Hash>)
+   {
+      return _hasher == other;
+   }
+   else
+   {
+      return false;
+   }
+}
+
+template <typename Key, typename Hash, typename KeyEqual, typename Allocator>
+void HashBrownSet<Key, Hash, KeyEqual, Allocator>::add_common(const HashBrownSet& a, const HashBrownSet& b)
+{
+   const auto& small = a._table.size <= b._table.size ? a : b;
+   const auto& large = a._table.size <= b._table.size ? b : a;
+   reserve(small._table.size);
+   for (auto slot = small.next_full(0); slot < small._table.capacity; slot = small.next_full(slot + 1))
+   {
+      if (large.find_slot(small._table.slots[slot], large.hash_from(small, slot)) != npos)
+      {
+         insert_hashed(small._table.slots[slot], hash_from(small, slot));
+      }
+   }
+}
+
+template <typename Key, typename Hash, typename KeyEqual, typename Allocator>
+void HashBrownSet<Key, Hash, KeyEqual, Allocator>::add_missing(const HashBrownSet& a, const HashBrownSet& b)
+{
+   for (auto slot = a.next_full(0); slot < a._table.capacity; slot = a.next_full(slot + 1))
+   {
+      if (b.find_slot(a._table.slots[slot], b.hash_from(a, slot)) == npos)
+      {
+         insert_hashed(a._table.slots[slot], hash_from(a, slot));
+      }
+   }
+}
+
+template <typename Key, typename Hash, typename KeyEqual, typename Allocator>
+void HashBrownSet<Key, Hash, KeyEqual, Allocator>::destroy()
+{
+   hashbrown::detail::free_table(_alloc, _table);
+}
+
+template <typename Key, typename Hash, typename KeyEqual, typename Allocator>
+void HashBrownSet<Key, Hash, KeyEqual, Allocator>::resize(std::size_t new_capacity)
+{
+   hashbrown::detail::resize_table(_alloc, _table, new_capacity, _max_load_factor, [this](const Table& table, std::size_t slot) {
+      return hash_at(table, slot);
+   });
+}
+
+template <typename Key, typename Hash, typename KeyEqual, typename Allocator>
+void HashBrownSet<Key, Hash, KeyEqual, Allocator>::swap_contents(HashBrownSet& other) noexcept
+{
+   using std::swap;
+   swap(_table, other._table);
+   swap(_hasher, other._hasher);
+   swap(_equal, other._equal);
+   swap(_max_load_factor, other._max_load_factor);
+}
+
+namespace hashbrown::pmr
+{
+   template <typename Key, typename Hash = HashFunction<Key>, typename KeyEqual = std::equal_to<>>
+   using HashBrownSet = ::HashBrownSet<Key, Hash, KeyEqual, std::pmr::polymorphic_allocator<Key>>;
+}
@@ -0,0 +1,301 @@
+#pragma once
+
+#include <hashbrown.hpp>
+
+#include <bit>
+#include <cerrno>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <stdexcept>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// A read-only HashBrown over a snapshot written by HashBrown::save. The file
+// is mapped, not read: lookups probe the page cache directly, opening costs
+// the same at any size, and every process mapping the file shares its pages.
+template <typename Key, typename Value, typename Hash = HashFunction<Key>, typename KeyEqual = std::equal_to<>>
+class HashBrownView
+{
+   static_assert(std::is_trivially_copyable_v<Key> && std::is_trivially_copyable_v<Value>,
+                 "snapshots store keys and values as raw bytes");
+
+   static constexpr bool transparent_lookup =
+      hashbrown::detail::transparent<Hash> && hashbrown::detail::transparent<KeyEqual>;
+
+   public:
+      using value_type = std::pair<Key, Value>;
+
+      explicit HashBrownView(const std::filesystem::path& path);
+      HashBrownView(HashBrownView&& other) noexcept;
+      HashBrownView& operator=(HashBrownView&& other) noexcept;
+      HashBrownView(const HashBrownView&) = delete;
+      HashBrownView& operator=(const HashBrownView&) = delete;
+      ~HashBrownView();
+
+      const Value* get(const Key& key) const;
+      template <typename K>
+      const Value* get(const K& key) const requires transparent_lookup;
+      bool contains(const Key& key) const;
+      template <typename K>
+      bool contains(const K& key) const requires transparent_lookup;
+      bool empty() const;
+      std::size_t size() const;
+      std::size_t capacity() const;
+
+   private:
+      using ctrl_t = hashbrown::detail::ctrl_t;
+      using Group = hashbrown::detail::Group;
+
+      void* _mapping;
+      std::size_t _length;
+      const ctrl_t* _ctrl;
+      const value_type* _slots;
+      std::size_t _capacity;
+      std::size_t _size;
+      Hash _hasher;
+      KeyEqual _equal;
+
+      template <typename K>
+      const Value* find(const K& key) const;
+      void validate(const hashbrown::detail::SnapshotHeader& header) const;
+      void unmap() noexcept;
+};
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual>
+HashBrownView<Key, Value, Hash, KeyEqual>::HashBrownView(const std::filesystem::path& path)
+   : _mapping(nullptr)
+   , _length(0)
+   , _ctrl(nullptr)
+   , _slots(nullptr)
+   , _capacity(0)
+   , _size(0)
+   , _hasher()
+   , _equal()
+{
+   const auto fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+   if (fd < 0)
+   {
+      throw std::system_error(errno, std::generic_category(), "HashBrownView: cannot open " + path.string());
+   }
+
+   struct stat info;
+   if (::fstat(fd, &info) != 0)
+   {
+      const auto error = errno;
+      ::close(fd);
+      throw std::system_error(error, std::generic_category(), "HashBrownView: cannot stat " + path.string());
+   }
+
+   _length = static_cast<std::size_t>(info.st_size);
+   if (_length < sizeof(hashbrown::detail::SnapshotHeader))
+   {
+      ::close(fd);
+      throw std::runtime_error("HashBrownView: " + path.string() + " is too short to be a snapshot");
+   }
+
+   _mapping = ::mmap(nullptr, _length, PROT_READ, MAP_SHARED, fd, 0);
+   const auto error = errno;
+   ::close(fd);
+   if (_mapping == MAP_FAILED)
+   {
+      _mapping = nullptr;
+      throw std::system_error(error, std::generic_category(), "HashBrownView: cannot map " + path.string());
+   }
+
+   try
+   {
+      hashbrown::detail::SnapshotHeader header;
+      std::memcpy(&header, _mapping, sizeof(header));
+
+      if constexpr (std::constructible_from<Hash, std::uint64_t>)
+      {
+         _hasher = Hash(header.seed);
+      }
+      validate(header);
+
+      const auto base = static_cast<const char*>(_mapping);
+      _ctrl = reinterpret_cast<const ctrl_t*>(base + header.ctrl_offset);
+      _slots = reinterpret_cast<const value_type*>(base + header.slots_offset);
+      _capacity = static_cast<std::size_t>(header.capacity);
+      _size = static_cast<std::size_t>(header.size);
+   }
+   catch (...)
+   {
+      unmap();
+      throw;
+   }
+
+   // Probes land anywhere in the file, so readahead would only waste I/O.
+   ::madvise(_mapping, _length, MADV_RANDOM);
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual>
+HashBrownView<Key, Value, Hash, KeyEqual>::HashBrownView(HashBrownView&& other) noexcept
+   : _mapping(std::exchange(other._mapping, nullptr))
+   , _length(std::exchange(other._length, 0))
+   , _ctrl(std::exchange(other._ctrl, nullptr))
+   , _slots(std::exchange(other._slots, nullptr))
+   , _capacity(std::exchange(other._capacity, 0))
+   , _size(std::exchange(other._size, 0))
+   , _hasher(std::move(other._hasher))
+   , _equal(std::move(other._equal))
+{
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual>
+HashBrownView<Key, Value, Hash, KeyEqual>& HashBrownView<Key, Value, Hash, KeyEqual>::operator=(HashBrownView&& other) noexcept
+{
+   if (this != &other)
+   {
+      unmap();
+      _mapping = std::exchange(other._mapping, nullptr);
+      _length = std::exchange(other._length, 0);
+      _ctrl = std::exchange(other._ctrl, nullptr);
+      _slots = std::exchange(other._slots, nullptr);
+      _capacity = std::exchange(other._capacity, 0);
+      _size = std::exchange(other._size, 0);
+      _hasher = std::move(other._hasher);
+      _equal = std::move(other._equal);
+   }
+   return *this;
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual>
+HashBrownView<Key, Value, Hash, KeyEqual>::~HashBrownView()
+{
+   unmap();
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual>
+const Value* HashBrownView<Key, Value, Hash, KeyEqual>::get(const Key& key) const
+{
+   return find(key);
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual>
+template <typename K>
+const Value* HashBrownView<Key, Value, Hash, KeyEqual>::get(const K& key) const
+   requires transparent_lookup
+{
+   return find(key);
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual>
+bool HashBrownView<Key, Value, Hash, KeyEqual>::contains(const Key& key) const
+{
+   return find(key) != nullptr;
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual>
+template <typename K>
+bool HashBrownView<Key, Value, Hash, KeyEqual>::contains(const K& key) const
+   requires transparent_lookup
+{
+   return find(key) != nullptr;
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual>
+bool HashBrownView<Key, Value, Hash, KeyEqual>::empty() const
+{
+   return _size == 0;
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual>
+std::size_t HashBrownView<Key, Value, Hash, KeyEqual>::size() const
+{
+   return _size;
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual>
+std::size_t HashBrownView<Key, Value, Hash, KeyEqual>::capacity() const
+{
+   return _capacity;
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual>
+template <typename K>
+const Value* HashBrownView<Key, Value, Hash, KeyEqual>::find(const K& key) const
+{
+   const std::size_t hash = _hasher(key);
+   const auto h2 = hashbrown::detail::h2(hash);
+   hashbrown::detail::ProbeSeq seq{hash, _capacity / Group::width - 1};
+
+   while (true)
+   {
+      const Group group{_ctrl + seq.offset()};
+      for (const auto i : group.match(h2))
+      {
+         const auto& entry = _slots[seq.offset() + i];
+         if (_equal(entry.first, key))
+         {
+            return &entry.second;
+         }
+      }
+
+      if (group.match_empty())
+      {
+         return nullptr;
+      }
+      seq.next();
+   }
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual>
+void HashBrownView<Key, Value, Hash, KeyEqual>::validate(const hashbrown::detail::SnapshotHeader& header) const
+{
+   using hashbrown::detail::SnapshotHeader;
+
+   if (std::memcmp(header.magic, SnapshotHeader::expected_magic, sizeof(header.magic)) != 0
+       || header.version != SnapshotHeader::current_version)
+   {
+      throw std::runtime_error("HashBrownView: not a snapshot this version can read");
+   }
+
+   if (header.group_width != Group::width
+       || header.key_size != sizeof(Key)
+       || header.value_size != sizeof(Value)
+       || header.slot_size != sizeof(value_type)
+       || header.slot_align != alignof(value_type))
+   {
+      throw std::runtime_error("HashBrownView: snapshot was written for a different key or value type");
+   }
+
+   if (header.check != hashbrown::detail::snapshot_check<Key>(_hasher))
+   {
+      throw std::runtime_error("HashBrownView: snapshot was written with a different hash function");
+   }
+
+   const auto capacity = header.capacity;
+   if (capacity < Group::width
+       || !std::has_single_bit(capacity)
+       || header.size > capacity
+       || header.ctrl_offset < sizeof(SnapshotHeader)
+       || header.ctrl_offset > header.slots_offset
+       || capacity > header.slots_offset - header.ctrl_offset
+       || header.slots_offset % alignof(value_type) != 0
+       || header.slots_offset > _length
+       || (_length - header.slots_offset) / sizeof(value_type) < capacity)
+   {
+      throw std::runtime_error("HashBrownView: snapshot is truncated or corrupt");
+   }
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual>
+void HashBrownView<Key, Value, Hash, KeyEqual>::unmap() noexcept
+{
+   if (_mapping != nullptr)
+   {
+      ::munmap(_mapping, _length);
+      _mapping = nullptr;
+   }
+}
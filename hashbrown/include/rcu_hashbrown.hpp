@@ -0,0 +1,393 @@
+#pragma once
+
+#include <hashbrown.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace hashbrown
+{
+   // Epoch-based reclamation. A reader announces the global epoch in its own
+   // cache-line sized record for the duration of a read; writers retire
+   // memory tagged with the epoch it was unlinked in and free it once every
+   // announced epoch is newer.
+   class EpochDomain
+   {
+      struct Record;
+
+      public:
+         class Guard
+         {
+            public:
+               explicit Guard(Record* record);
+               Guard(const Guard&) = delete;
+               Guard& operator=(const Guard&) = delete;
+               ~Guard();
+
+            private:
+               Record* _record;
+         };
+
+         static EpochDomain& instance();
+
+         EpochDomain(const EpochDomain&) = delete;
+         EpochDomain& operator=(const EpochDomain&) = delete;
+         ~EpochDomain();
+
+         [[nodiscard]] Guard pin();
+
+         template <typename T>
+         void retire(const T* pointer);
+         void collect();
+
+         std::size_t pending() const;
+
+      private:
+         struct alignas(detail::cache_line_size) Record
+         {
+            std::atomic<std::uint64_t> epoch{0};
+            std::atomic<bool> in_use{false};
+            unsigned depth = 0;
+            Record* next = nullptr;
+         };
+
+         struct Retired
+         {
+            std::uint64_t epoch;
+            const void* pointer;
+            void (*deleter)(const void*);
+         };
+
+         EpochDomain() = default;
+
+         Record* local_record();
+         Record* acquire_record();
+         void retire(const void* pointer, void (*deleter)(const void*));
+
+         std::atomic<std::uint64_t> _epoch{1};
+         std::atomic<Record*> _records{nullptr};
+         mutable std::mutex _retired_mutex;
+         std::vector<Retired> _retired;
+   };
+
+   inline EpochDomain::Guard::Guard(Record* record)
+      : _record(record)
+   {
+   }
+
+   inline EpochDomain::Guard::~Guard()
+   {
+      if (--_record->depth == 0)
+      {
+         _record->epoch.store(0, std::memory_order_release);
+      }
+   }
+
+   inline EpochDomain& EpochDomain::instance()
+   {
+      static EpochDomain domain;
+      return domain;
+   }
+
+   inline EpochDomain::~EpochDomain()
+   {
+      for (const auto& retired : _retired)
+      {
+         retired.deleter(retired.pointer);
+      }
+
+      auto record = _records.load();
+      while (record != nullptr)
+      {
+         delete std::exchange(record, record->next);
+      }
+   }
+
+   inline EpochDomain::Guard EpochDomain::pin()
+   {
+      auto record = local_record();
+      if (record->depth++ == 0)
+      {
+         record->epoch.store(_epoch.load(std::memory_order_acquire), std::memory_order_relaxed);
+         // The announcement has to be visible before the reader loads any
+         // shared pointer, or a writer could miss it while scanning.
+         std::atomic_thread_fence(std::memory_order_seq_cst);
+      }
+      return Guard{record};
+   }
+
+   template <typename T>
+   void EpochDomain::retire(const T* pointer)
+   {
+      retire(pointer, [](const void* p) { delete static_cast<const T*>(p); });
+   }
+
+   inline void EpochDomain::retire(const void* pointer, void (*deleter)(const void*))
+   {
+      // Readers that announce the bumped epoch started after the pointer was
+      // unlinked, so only readers at or before the old epoch can still see it.
+      const auto epoch = _epoch.fetch_add(1, std::memory_order_seq_cst);
+
+      std::lock_guard lock{_retired_mutex};
+      _retired.push_back(Retired{epoch, pointer, deleter});
+   }
+
+   inline void EpochDomain::collect()
+   {
+      auto oldest = std::numeric_limits<std::uint64_t>::max();
+      for (auto record = _records.load(std::memory_order_acquire); record != nullptr; record = record->next)
+      {
+         const auto epoch = record->epoch.load(std::memory_order_seq_cst);
+         if (epoch != 0)
+         {
+            oldest = std::min(oldest, epoch);
+         }
+      }
+
+      std::vector<Retired> ready;
+      {
+         std::lock_guard lock{_retired_mutex};
+         const auto split = std::partition(_retired.begin(), _retired.end(), [oldest](const Retired& retired) {
+            return retired.epoch >= oldest;
+         });
+         ready.assign(split, _retired.end());
+         _retired.erase(split, _retired.end());
+      }
+
+      for (const auto& retired : ready)
+      {
+         retired.deleter(retired.pointer);
+      }
+   }
+
+   inline std::size_t EpochDomain::pending() const
+   {
+      std::lock_guard lock{_retired_mutex};
+      return _retired.size();
+   }
+
+   inline EpochDomain::Record* EpochDomain::local_record()
+   {
+      // Hands the record back for reuse when the thread exits.
+      struct Owner
+      {
+         Record* record = nullptr;
+
+         ~Owner()
+         {
+            if (record != nullptr)
+            {
+               record->in_use.store(false, std::memory_order_release);
+            }
+         }
+      };
+
+      thread_local Owner owner;
+      if (owner.record == nullptr)
+      {
+         owner.record = acquire_record();
+      }
+      return owner.record;
+   }
+
+   inline EpochDomain::Record* EpochDomain::acquire_record()
+   {
+      for (auto record = _records.load(std::memory_order_acquire); record != nullptr; record = record->next)
+      {
+         bool expected = false;
+         if (record->in_use.compare_exchange_strong(expected, true, std::memory_order_acq_rel))
+         {
+            return record;
+         }
+      }
+
+      auto record = new Record;
+      record->in_use.store(true, std::memory_order_relaxed);
+      record->next = _records.load(std::memory_order_relaxed);
+      while (!_records.compare_exchange_weak(record->next, record, std::memory_order_acq_rel))
+      {
+      }
+      return record;
+   }
+}
+
+// A map for read-mostly data. Every write copies the current table, applies
+// the change and publishes the copy with one atomic store, so readers never
+// take a lock or write to memory another thread reads; the replaced table is
+// freed through the epoch domain once no reader can still hold it.
+template <typename Key, typename Value, typename Hash = HashFunction<Key>, typename KeyEqual = std::equal_to<>>
+class RcuHashBrown
+{
+   static constexpr bool transparent_lookup =
+      hashbrown::detail::transparent<Hash> && hashbrown::detail::transparent<KeyEqual>;
+
+   public:
+      using map_type = HashBrown<Key, Value, Hash, KeyEqual>;
+      using value_type = typename map_type::value_type;
+
+      RcuHashBrown();
+      explicit RcuHashBrown(map_type map);
+      RcuHashBrown(const RcuHashBrown&) = delete;
+      RcuHashBrown& operator=(const RcuHashBrown&) = delete;
+      ~RcuHashBrown();
+
+      std::optional<Value> get(const Key& key) const;
+      template <typename K>
+      std::optional<Value> get(const K& key) const requires transparent_lookup;
+      bool contains(const Key& key) const;
+      template <typename K>
+      bool contains(const K& key) const requires transparent_lookup;
+      std::size_t size() const;
+      bool empty() const;
+
+      // Calls fn with the current snapshot; the snapshot stays alive until
+      // fn returns.
+      template <typename Fn>
+      decltype(auto) read(Fn&& fn) const;
+
+      void insert(Key key, Value value);
+      bool erase(const Key& key);
+
+      // Applies several changes to one copy and publishes them together.
+      template <typename Fn>
+      void update(Fn&& fn);
+
+   private:
+      std::atomic<const map_type*> _current;
+      std::mutex _write_mutex;
+
+      void publish(std::unique_ptr<map_type> next);
+};
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual>
+RcuHashBrown<Key, Value, Hash, KeyEqual>::RcuHashBrown()
+   : RcuHashBrown(map_type{})
+{
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual>
+RcuHashBrown<Key, Value, Hash, KeyEqual>::RcuHashBrown(map_type map)
+   : _current(new map_type(std::move(map)))
+   , _write_mutex()
+{
+   // Touching the domain first makes it outlive this map even when the map
+   // is a static, since the destructor still collects through it.
+   hashbrown::EpochDomain::instance();
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual>
+RcuHashBrown<Key, Value, Hash, KeyEqual>::~RcuHashBrown()
+{
+   delete _current.load(std::memory_order_relaxed);
+   hashbrown::EpochDomain::instance().collect();
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual>
+std::optional<Value> RcuHashBrown<Key, Value, Hash, KeyEqual>::get(const Key& key) const
+{
+   return read([&key](const map_type& map) -> std::optional<Value> {
+      if (const auto value = map.get(key))
+      {
+         return *value;
+      }
+      return std::nullopt;
+   });
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual>
+template <typename K>
+std::optional<Value> RcuHashBrown<Key, Value, Hash, KeyEqual>::get(const K& key) const
+   requires transparent_lookup
+{
+   return read([&key](const map_type& map) -> std::optional<Value> {
+      if (const auto value = map.get(key))
+      {
+         return *value;
+      }
+      return std::nullopt;
+   });
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual>
+bool RcuHashBrown<Key, Value, Hash, KeyEqual>::contains(const Key& key) const
+{
+   return read([&key](const map_type& map) { return map.contains(key); });
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual>
+template <typename K>
+bool RcuHashBrown<Key, Value, Hash, KeyEqual>::contains(const K& key) const
+   requires transparent_lookup
+{
+   return read([&key](const map_type& map) { return map.contains(key); });
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual>
+std::size_t RcuHashBrown<Key, Value, Hash, KeyEqual>::size() const
+{
+   return read([](const map_type& map) { return map.size(); });
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual>
+bool RcuHashBrown<Key, Value, Hash, KeyEqual>::empty() const
+{
+   return size() == 0;
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual>
+template <typename Fn>
+decltype(auto) RcuHashBrown<Key, Value, Hash, KeyEqual>::read(Fn&& fn) const
+{
+   const auto guard = hashbrown::EpochDomain::instance().pin();
+   return std::invoke(std::forward<Fn>(fn), *_current.load(std::memory_order_acquire));
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual>
+void RcuHashBrown<Key, Value, Hash, KeyEqual>::insert(Key key, Value value)
+{
+   update([&](map_type& map) { map.insert(std::move(key), std::move(value)); });
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual>
+bool RcuHashBrown<Key, Value, Hash, KeyEqual>::erase(const Key& key)
+{
+   std::lock_guard lock{_write_mutex};
+   const auto current = _current.load(std::memory_order_relaxed);
+   if (!current->contains(key))
+   {
+      return false;
+   }
+
+   auto next = std::make_unique<map_type>(*current);
+   next->erase(key);
+   publish(std::move(next));
+   return true;
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual>
+template <typename Fn>
+void RcuHashBrown<Key, Value, Hash, KeyEqual>::update(Fn&& fn)
+{
+   std::lock_guard lock{_write_mutex};
+   auto next = std::make_unique<map_type>(*_current.load(std::memory_order_relaxed));
+   std::invoke(std::forward<Fn>(fn), *next);
+   publish(std::move(next));
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual>
+void RcuHashBrown<Key, Value, Hash, KeyEqual>::publish(std::unique_ptr<map_type> next)
+{
+   const auto previous = _current.exchange(next.release(), std::memory_order_seq_cst);
+   auto& domain = hashbrown::EpochDomain::instance();
+   domain.retire(previous);
+   domain.collect();
+}
@@ -0,0 +1,915 @@
+#pragma once
+
+#include <hashbrown.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <memory_resource>
+#include <stdexcept>
+#include <utility>
+
+// A HashBrown laid out for Robin Hood linear probing. Every slot records how
+// far its entry sits from its home slot, and an insert takes the slot of the
+// first entry that is closer to home than it would be, shifting the run
+// behind it up by one. Probe lengths stay short and even, so a lookup stops
+// as soon as it passes an entry closer to home than the key would be.
+// Erasing shifts the rest of the run back by one instead of leaving a
+// tombstone, so a table under steady erase and insert churn never needs a
+// rebuild.
+template <typename Key,
+          typename Value,
+          typename Hash = HashFunction<Key>,
+          typename KeyEqual = std::equal_to<>,
+          typename Allocator = std::allocator<std::pair<Key, Value>>>
+class RobinHoodHashBrown
+{
+   template <bool IsConst>
+   class Iterator;
+
+   static constexpr bool transparent_lookup =
+      hashbrown::detail::transparent<Hash> && hashbrown::detail::transparent<KeyEqual>;
+
+   static constexpr bool move_assign_noexcept =
+      std::allocator_traits<Allocator>::propagate_on_container_move_assignment::value
+      || std::allocator_traits<Allocator>::is_always_equal::value;
+
+   public:
+      static constexpr bool stored_hash = hashbrown::detail::stores_hash<Key, Hash>();
+
+      using value_type = std::pair<Key, Value>;
+      using reference = value_type&;
+      using pointer = value_type*;
+      using const_reference = const value_type&;
+      using iterator = Iterator<false>;
+      using const_iterator = Iterator<true>;
+      using allocator_type = Allocator;
+
+      constexpr RobinHoodHashBrown();
+      explicit RobinHoodHashBrown(const Allocator& alloc);
+      explicit RobinHoodHashBrown(const Hash& hash, const KeyEqual& equal = KeyEqual(), const Allocator& alloc = Allocator());
+      RobinHoodHashBrown(std::initializer_list<value_type> il, const Allocator& alloc = Allocator());
+      RobinHoodHashBrown(const RobinHoodHashBrown& other);
+      RobinHoodHashBrown(const RobinHoodHashBrown& other, const Allocator& alloc);
+      RobinHoodHashBrown(RobinHoodHashBrown&& other) noexcept;
+      RobinHoodHashBrown& operator=(const RobinHoodHashBrown& other);
+      RobinHoodHashBrown& operator=(RobinHoodHashBrown&& other) noexcept(move_assign_noexcept);
+      ~RobinHoodHashBrown();
+
+      iterator begin();
+      const_iterator begin() const;
+      const_iterator cbegin() const;
+
+      iterator end();
+      const_iterator end() const;
+      const_iterator cend() const;
+
+      // Returns an iterator to the entry after the erased one, so erasing
+      // while iterating visits every other entry exactly once.
+      iterator erase(const Key& key);
+      template <typename K>
+      iterator erase(const K& key) requires transparent_lookup;
+
+      void insert(std::initializer_list<value_type> il);
+      template <std::input_iterator InputIt>
+      void insert(InputIt first, InputIt last);
+      iterator insert(Key key, Value value);
+      iterator insert(const value_type& value);
+      iterator insert(value_type&& value);
+      template <typename... Args>
+      iterator emplace(Args&&... args);
+
+      const Value* get(const Key& key) const;
+      template <typename K>
+      const Value* get(const K& key) const requires transparent_lookup;
+      bool contains(const Key& key) const;
+      template <typename K>
+      bool contains(const K& key) const requires transparent_lookup;
+      bool empty() const;
+      std::size_t size() const;
+      std::size_t capacity() const;
+      void clear();
+      void swap(RobinHoodHashBrown& other) noexcept;
+      allocator_type get_allocator() const;
+      Hash hash_function() const;
+      KeyEqual key_eq() const;
+
+      float load_factor() const;
+      float max_load_factor() const;
+      void max_load_factor(float ml);
+      void rehash(std::size_t count);
+      void reserve(std::size_t count);
+
+      // The longest distance of any entry from its home slot, counted in
+      // slots; a lookup never probes further than this.
+      std::size_t max_probe_length() const;
+
+   private:
+      using dist_t = std::uint8_t;
+      using value_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<value_type>;
+      using value_traits = std::allocator_traits<value_allocator>;
+      using dist_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<dist_t>;
+      using hash_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<std::size_t>;
+
+      static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+      // Distances are stored one above the probe length, so 0 marks an empty
+      // slot and a byte bounds how far an entry may sit from home.
+      static constexpr std::size_t max_distance = 255;
+
+      struct Placement
+      {
+         std::size_t slot;
+         dist_t dist;
+      };
+
+      // Home slots span the capacity. An overflow area of up to max_distance
+      // slots follows it, so runs never wrap around and shifting an entry
+      // back never carries it past the iterator that erased before it.
+      dist_t* _dist;
+      value_type* _slots;
+      // Parallel to slots; only allocated when stored_hash is set.
+      std::size_t* _hashes;
+      std::size_t _capacity;
+      std::size_t _size;
+
+      Hash _hasher;
+      KeyEqual _equal;
+      float _max_load_factor;
+      [[no_unique_address]] value_allocator _alloc;
+
+      static std::size_t overflow_for(std::size_t capacity);
+
+      template <typename K>
+      std::size_t find_slot(const K& key, std::size_t hash) const;
+      template <typename K>
+      iterator erase_key(const K& key);
+      Placement prepare_insert(std::size_t hash);
+      void close_gap(std::size_t slot);
+      void move_slot(std::size_t to, std::size_t from);
+      std::size_t hash_at(std::size_t slot) const;
+      std::size_t slot_count() const;
+      std::size_t next_full(std::size_t slot) const;
+
+      void allocate(std::size_t capacity);
+      void deallocate();
+      void destroy();
+      void resize(std::size_t new_capacity);
+      void swap_contents(RobinHoodHashBrown& other) noexcept;
+
+      template <bool IsConst>
+      class Iterator {
+         public:
+            using difference_type = std::ptrdiff_t;
+            using value_type = RobinHoodHashBrown::value_type;
+            using reference = std::conditional_t<IsConst, const_reference, RobinHoodHashBrown::reference>;
+            using pointer = std::conditional_t<IsConst, const value_type*, RobinHoodHashBrown::pointer>;
+            using iterator_category = std::forward_iterator_tag;
+            using map_pointer = std::conditional_t<IsConst, const RobinHoodHashBrown*, RobinHoodHashBrown*>;
+
+            Iterator() = default;
+
+            Iterator(map_pointer hb, std::size_t slot)
+               : _hb(hb)
+               , _slot(slot)
+            {
+            }
+
+            operator Iterator<true>() const requires (!IsConst)
+            {
+               return Iterator<true>{_hb, _slot};
+            }
+
+            Iterator& operator++()
+            {
+               _slot = _hb->next_full(_slot + 1);
+               return *this;
+            }
+
+            Iterator operator++(int)
+            {
+               auto temp = *this;
+               ++*this;
+               return temp;
+            }
+
+            reference operator*() const
+            {
+               return _hb->_slots[_slot];
+            }
+
+            pointer operator->() const
+            {
+               return &this->operator*();
+            }
+
+            friend bool operator==(const Iterator& it_a, const Iterator& it_b)
+            {
+               return it_a._hb == it_b._hb
+                  && it_a._slot == it_b._slot;
+            }
+
+            friend bool operator!=(const Iterator& it_a, const Iterator& it_b)
+            {
+               return !(it_a == it_b);
+            }
+
+         private:
+            map_pointer _hb = nullptr;
+            std::size_t _slot = 0;
+      };
+};
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+constexpr RobinHoodHashBrown<Key, Value, Hash, KeyEqual, Allocator>::RobinHoodHashBrown()
+   : RobinHoodHashBrown(Allocator())
+{
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+RobinHoodHashBrown<Key, Value, Hash, KeyEqual, Allocator>::RobinHoodHashBrown(const Allocator& alloc)
+   : RobinHoodHashBrown(Hash(), KeyEqual(), alloc)
+{
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+RobinHoodHashBrown<Key, Value, Hash, KeyEqual, Allocator>::RobinHoodHashBrown(const Hash& hash, const KeyEqual& equal, const Allocator& alloc)
+   : _dist(nullptr)
+   , _slots(nullptr)
+   , _hashes(nullptr)
+   , _capacity(0)
+   , _size(0)
+   , _hasher(hash)
+   , _equal(equal)
+   , _max_load_factor(hashbrown::detail::default_max_load_factor)
+   , _alloc(alloc)
+{
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+RobinHoodHashBrown<Key, Value, Hash, KeyEqual, Allocator>::RobinHoodHashBrown(std::initializer_list<value_type> il, const Allocator& alloc)
+   : RobinHoodHashBrown(alloc)
+{
+   insert(il);
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+RobinHoodHashBrown<Key, Value, Hash, KeyEqual, Allocator>::RobinHoodHashBrown(const RobinHoodHashBrown& other)
+   : RobinHoodHashBrown(other, value_traits::select_on_container_copy_construction(other._alloc))
+{
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+RobinHoodHashBrown<Key, Value, Hash, KeyEqual, Allocator>::RobinHoodHashBrown(const RobinHoodHashBrown& other, const Allocator& alloc)
+   : RobinHoodHashBrown(alloc)
+{
+   _hasher = other._hasher;
+   _equal = other._equal;
+   _max_load_factor = other._max_load_factor;
+
+   if (other._size == 0)
+   {
+      return;
+   }
+
+   // Same capacity and hasher, so every entry keeps its slot.
+   allocate(other._capacity);
+   for (auto slot = other.next_full(0); slot < other.slot_count(); slot = other.next_full(slot + 1))
+   {
+      value_traits::construct(_alloc, _slots + slot, other._slots[slot]);
+      if constexpr (stored_hash)
+      {
+         _hashes[slot] = other._hashes[slot];
+      }
+      _dist[slot] = other._dist[slot];
+      ++_size;
+   }
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+RobinHoodHashBrown<Key, Value, Hash, KeyEqual, Allocator>::RobinHoodHashBrown(RobinHoodHashBrown&& other) noexcept
+   : _dist(std::exchange(other._dist, nullptr))
+   , _slots(std::exchange(other._slots, nullptr))
+   , _hashes(std::exchange(other._hashes, nullptr))
+   , _capacity(std::exchange(other._capacity, 0))
+   , _size(std::exchange(other._size, 0))
+   , _hasher(std::move(other._hasher))
+   , _equal(std::move(other._equal))
+   , _max_load_factor(other._max_load_factor)
+   , _alloc(std::move(other._alloc))
+{
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+RobinHoodHashBrown<Key, Value, Hash, KeyEqual, Allocator>& RobinHoodHashBrown<Key, Value, Hash, KeyEqual, Allocator>::operator=(const RobinHoodHashBrown& other)
+{
+   if (this != &other)
+   {
+      if constexpr (value_traits::propagate_on_container_copy_assignment::value)
+      {
+         destroy();
+         _alloc = other._alloc;
+      }
+      RobinHoodHashBrown copy{other, _alloc};
+      swap_contents(copy);
+   }
+   return *this;
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+RobinHoodHashBrown<Key, Value, Hash, KeyEqual, Allocator>& RobinHoodHashBrown<Key, Value, Hash, KeyEqual, Allocator>::operator=(RobinHoodHashBrown&& other) noexcept(move_assign_noexcept)
+{
+   if (this == &other)
+   {
+      return *this;
+   }
+
+   if constexpr (value_traits::propagate_on_container_move_assignment::value)
+   {
+      destroy();
+      _alloc = std::move(other._alloc);
+      swap_contents(other);
+   }
+   else if (_alloc == other._alloc)
+   {
+      destroy();
+      swap_contents(other);
+   }
+   else
+   {
+      // Storage from another allocator cannot be adopted; move the entries.
+      clear();
+      reserve(other._size);
+      for (auto& entry : other)
+      {
+         insert(std::move(entry.first), std::move(entry.second));
+      }
+      other.clear();
+   }
+   return *this;
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+RobinHoodHashBrown<Key, Value, Hash, KeyEqual, Allocator>::~RobinHoodHashBrown()
+{
+   destroy();
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+typename RobinHoodHashBrown<Key, Value, Hash, KeyEqual, Allocator>::iterator RobinHoodHashBrown<Key, Value, Hash, KeyEqual, Allocator>::begin()
+{
+   return iterator(this, next_full(0));
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+typename RobinHoodHashBrown<Key, Value, Hash, KeyEqual, Allocator>::const_iterator RobinHoodHashBrown<Key, Value, Hash, KeyEqual, Allocator>::begin() const
+{
+   return const_iterator(this, next_full(0));
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+typename RobinHoodHashBrown<Key, Value, Hash, KeyEqual, Allocator>::const_iterator RobinHoodHashBrown<Key, Value, Hash, KeyEqual, Allocator>::cbegin() const
+{
+   return begin();
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+typename RobinHoodHashBrown<Key, Value, Hash, KeyEqual, Allocator>::iterator RobinHoodHashBrown<Key, Value, Hash, KeyEqual, Allocator>::end()
+{
+   return iterator(this, slot_count());
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+typename RobinHoodHashBrown<Key, Value, Hash, KeyEqual, Allocator>::const_iterator RobinHoodHashBrown<Key, Value, Hash, KeyEqual, Allocator>::end() const
+{
+   return const_iterator(this, slot_count());
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+typename RobinHoodHashBrown<Key, Value, Hash, KeyEqual, Allocator>::const_iterator RobinHoodHashBrown<Key, Value, Hash, KeyEqual, Allocator>::cend() const
+{
+   return end();
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+typename RobinHoodHashBrown<Key, Value, Hash, KeyEqual, Allocator>::iterator RobinHoodHashBrown<Key, Value, Hash, KeyEqual, Allocator>::erase(const Key& key)
+{
+   return erase_key(key);
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+template <typename K>
+typename RobinHoodHashBrown<Key, Value, Hash, KeyEqual, Allocator>::iterator RobinHoodHashBrown<Key, Value, Hash, KeyEqual, Allocator>::erase(const K& key)
+   requires transparent_lookup
+{
+   return erase_key(key);
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+void RobinHoodHashBrown<Key, Value, Hash, KeyEqual, Allocator>::insert(std::initializer_list<value_type> il)
+{
+   insert(il.begin(), il.end());
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+template <std::input_iterator InputIt>
+void RobinHoodHashBrown<Key, Value, Hash, KeyEqual, Allocator>::insert(InputIt first, InputIt last)
+{
+   if constexpr (std::forward_iterator<InputIt>)
+   {
+      reserve(_size + static_cast<std::size_t>(std::distance(first, last)));
+   }
+
+   for (; first != last; ++first)
+   {
+      insert(*first);
+   }
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+typename RobinHoodHashBrown<Key, Value, Hash, KeyEqual, Allocator>::iterator RobinHoodHashBrown<Key, Value, Hash, KeyEqual, Allocator>::insert(Key key, Value value)
+{
+   const auto hash = _hasher(key);
+   const auto found = find_slot(key, hash);
+
+   if (found != npos)
+   {
+      std::swap(_slots[found].second, value);
+      return iterator {this, found};
+   }
+
+   const auto [slot, dist] = prepare_insert(hash);
+   try
+   {
+      value_traits::construct(_alloc, _slots + slot, std::move(key), std::move(value));
+   }
+   catch (...)
+   {
+      close_gap(slot);
+      throw;
+   }
+
+   if constexpr (stored_hash)
+   {
+      _hashes[slot] = hash;
+   }
+   _dist[slot] = dist;
+   ++_size;
+   return iterator {this, slot};
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+typename RobinHoodHashBrown<Key, Value, Hash, KeyEqual, Allocator>::iterator RobinHoodHashBrown<Key, Value, Hash, KeyEqual, Allocator>::insert(const value_type& value)
+{
+   return insert(value.first, value.second);
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+typename RobinHoodHashBrown<Key, Value, Hash, KeyEqual, Allocator>::iterator RobinHoodHashBrown<Key, Value, Hash, KeyEqual, Allocator>::insert(value_type&& value)
+{
+   return insert(std::move(value.first), std::move(value.second));
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+template <typename... Args>
+typename RobinHoodHashBrown<Key, Value, Hash, KeyEqual, Allocator>::iterator RobinHoodHashBrown<Key, Value, Hash, KeyEqual, Allocator>::emplace(Args&&... args)
+{
+   value_type pair(std::forward<Args>(args)...);
+   return insert(std::move(pair));
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+const Value* RobinHoodHashBrown<Key, Value, Hash, KeyEqual, Allocator>::get(const Key& key) const
+{
+   const auto slot = find_slot(key, _hasher(key));
+   return slot == npos ? nullptr : &_slots[slot].second;
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+template <typename K>
+const Value* RobinHoodHashBrown<Key, Value, Hash, KeyEqual, Allocator>::get(const K& key) const
+   requires transparent_lookup
+{
+   const auto slot = find_slot(key, _hasher(key));
+   return slot == npos ? nullptr : &_slots[slot].second;
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+bool RobinHoodHashBrown<Key, Value, Hash, KeyEqual, Allocator>::contains(const Key& key) const
+{
+   return find_slot(key, _hasher(key)) != npos;
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+template <typename K>
+bool RobinHoodHashBrown<Key, Value, Hash, KeyEqual, Allocator>::contains(const K& key) const
+   requires transparent_lookup
+{
+   return find_slot(key, _hasher(key)) != npos;
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+bool RobinHoodHashBrown<Key, Value, Hash, KeyEqual, Allocator>::empty() const
+{
+   return _size == 0;
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+std::size_t RobinHoodHashBrown<Key, Value, Hash, KeyEqual, Allocator>::size() const
+{
+   return _size;
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+std::size_t RobinHoodHashBrown<Key, Value, Hash, KeyEqual, Allocator>::capacity() const
+{
+   return _capacity;
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+void RobinHoodHashBrown<Key, Value, Hash, KeyEqual, Allocator>::clear()
+{
+   destroy();
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+void RobinHoodHashBrown<Key, Value, Hash, KeyEqual, Allocator>::swap(RobinHoodHashBrown& other) noexcept
+{
+   if constexpr (value_traits::propagate_on_container_swap::value)
+   {
+      using std::swap;
+      swap(_alloc, other._alloc);
+   }
+   swap_contents(other);
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+typename RobinHoodHashBrown<Key, Value, Hash, KeyEqual, Allocator>::allocator_type RobinHoodHashBrown<Key, Value, Hash, KeyEqual, Allocator>::get_allocator() const
+{
+   return allocator_type(_alloc);
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+Hash RobinHoodHashBrown<Key, Value, Hash, KeyEqual, Allocator>::hash_function() const
+{
+   return _hasher;
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+KeyEqual RobinHoodHashBrown<Key, Value, Hash, KeyEqual, Allocator>::key_eq() const
+{
+   return _equal;
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+float RobinHoodHashBrown<Key, Value, Hash, KeyEqual, Allocator>::load_factor() const
+{
+   if (_capacity == 0)
+   {
+      return 0.0f;
+   }
+   return static_cast<float>(_size) / static_cast<float>(_capacity);
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+float RobinHoodHashBrown<Key, Value, Hash, KeyEqual, Allocator>::max_load_factor() const
+{
+   return _max_load_factor;
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+void RobinHoodHashBrown<Key, Value, Hash, KeyEqual, Allocator>::max_load_factor(float ml)
+{
+   hashbrown::detail::check_max_load_factor(ml);
+
+   _max_load_factor = ml;
+   if (_capacity != 0)
+   {
+      resize(std::max(_capacity, hashbrown::detail::capacity_for(_size, _max_load_factor)));
+   }
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+void RobinHoodHashBrown<Key, Value, Hash, KeyEqual, Allocator>::rehash(std::size_t count)
+{
+   if (_size == 0 && count == 0)
+   {
+      destroy();
+      return;
+   }
+
+   auto target = hashbrown::detail::capacity_for(_size, _max_load_factor);
+   while (target < count)
+   {
+      target *= 2;
+   }
+
+   if (target != _capacity)
+   {
+      resize(target);
+   }
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+void RobinHoodHashBrown<Key, Value, Hash, KeyEqual, Allocator>::reserve(std::size_t count)
+{
+   if (_capacity == 0 || count > hashbrown::detail::max_items(_capacity, _max_load_factor))
+   {
+      rehash(hashbrown::detail::capacity_for(count, _max_load_factor));
+   }
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+std::size_t RobinHoodHashBrown<Key, Value, Hash, KeyEqual, Allocator>::max_probe_length() const
+{
+   dist_t longest = 0;
+   for (std::size_t slot = 0; slot < slot_count(); ++slot)
+   {
+      longest = std::max(longest, _dist[slot]);
+   }
+   return longest == 0 ? 0 : longest - 1u;
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+std::size_t RobinHoodHashBrown<Key, Value, Hash, KeyEqual, Allocator>::overflow_for(std::size_t capacity)
+{
+   return std::min(capacity, max_distance);
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+template <typename K>
+std::size_t RobinHoodHashBrown<Key, Value, Hash, KeyEqual, Allocator>::find_slot(const K& key, std::size_t hash) const
+{
+   if (_capacity == 0)
+   {
+      return npos;
+   }
+
+   // Entries along a run sit ever further from home, so the key cannot be
+   // past the first slot whose entry is closer to home than it would be.
+   auto slot = hash & (_capacity - 1);
+   for (std::size_t dist = 1; _dist[slot] >= dist; ++slot, ++dist)
+   {
+      if (_dist[slot] != dist)
+      {
+         continue;
+      }
+      if constexpr (stored_hash)
+      {
+         if (_hashes[slot] != hash)
+         {
+            continue;
+         }
+      }
+      if (_equal(_slots[slot].first, key))
+      {
+         return slot;
+      }
+   }
+   return npos;
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+template <typename K>
+typename RobinHoodHashBrown<Key, Value, Hash, KeyEqual, Allocator>::iterator RobinHoodHashBrown<Key, Value, Hash, KeyEqual, Allocator>::erase_key(const K& key)
+{
+   const auto slot = find_slot(key, _hasher(key));
+   if (slot == npos)
+   {
+      return end();
+   }
+
+   value_traits::destroy(_alloc, _slots + slot);
+   close_gap(slot);
+   --_size;
+   return iterator {this, next_full(slot)};
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+typename RobinHoodHashBrown<Key, Value, Hash, KeyEqual, Allocator>::Placement RobinHoodHashBrown<Key, Value, Hash, KeyEqual, Allocator>::prepare_insert(std::size_t hash)
+{
+   while (true)
+   {
+      if (_capacity == 0 || _size >= hashbrown::detail::max_items(_capacity, _max_load_factor))
+      {
+         resize(std::max(2 * _capacity, hashbrown::detail::capacity_for(_size + 1, _max_load_factor)));
+         continue;
+      }
+
+      auto slot = hash & (_capacity - 1);
+      std::size_t dist = 1;
+      while (_dist[slot] >= dist)
+      {
+         ++slot;
+         ++dist;
+      }
+
+      // The new entry takes this slot and the rest of the run moves up one,
+      // which only works if nothing ends up too far from home.
+      const auto limit = overflow_for(_capacity);
+      bool fits = dist <= limit;
+      auto empty = slot;
+      for (; _dist[empty] != 0; ++empty)
+      {
+         fits = fits && _dist[empty] < limit;
+      }
+
+      if (!fits)
+      {
+         // A run this long in a table under half full means the keys share
+         // hashes, and no amount of growing will spread them out.
+         if (_size < hashbrown::detail::max_items(_capacity, _max_load_factor) / 2)
+         {
+            throw std::overflow_error("RobinHoodHashBrown: probe length overflow, the hash function is too weak");
+         }
+         resize(2 * _capacity);
+         continue;
+      }
+
+      for (auto to = empty; to > slot; --to)
+      {
+         move_slot(to, to - 1);
+         _dist[to] = static_cast<dist_t>(_dist[to - 1] + 1);
+      }
+      _dist[slot] = 0;
+      return {slot, static_cast<dist_t>(dist)};
+   }
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+void RobinHoodHashBrown<Key, Value, Hash, KeyEqual, Allocator>::close_gap(std::size_t slot)
+{
+   // Backward-shift deletion: pull the rest of the run one step closer to
+   // home until an empty slot or an entry already at home. The last slot is
+   // always empty, so this never runs off the end.
+   while (_dist[slot + 1] > 1)
+   {
+      move_slot(slot, slot + 1);
+      _dist[slot] = static_cast<dist_t>(_dist[slot + 1] - 1);
+      ++slot;
+   }
+   _dist[slot] = 0;
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+void RobinHoodHashBrown<Key, Value, Hash, KeyEqual, Allocator>::move_slot(std::size_t to, std::size_t from)
+{
+   value_traits::construct(_alloc, _slots + to, std::move(_slots[from]));
+   value_traits::destroy(_alloc, _slots + from);
+   if constexpr (stored_hash)
+   {
+      _hashes[to] = _hashes[from];
+   }
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+std::size_t RobinHoodHashBrown<Key, Value, Hash, KeyEqual, Allocator>::hash_at(std::size_t slot) const
+{
+   if constexpr (stored_hash)
+   {
+      return _hashes[slot];
+   }
+   else
+   {
+      return _hasher(_slots[slot].first);
+   }
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+std::size_t RobinHoodHashBrown<Key, Value, Hash, KeyEqual, Allocator>::slot_count() const
+{
+   return _capacity + overflow_for(_capacity);
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+std::size_t RobinHoodHashBrown<Key, Value, Hash, KeyEqual, Allocator>::next_full(std::size_t slot) const
+{
+   const auto count = slot_count();
+   while (slot < count && _dist[slot] == 0)
+   {
+      ++slot;
+   }
+   return slot;
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+void RobinHoodHashBrown<Key, Value, Hash, KeyEqual, Allocator>::allocate(std::size_t capacity)
+{
+   dist_allocator dist_alloc{_alloc};
+   hash_allocator hash_alloc{_alloc};
+   const auto count = capacity + overflow_for(capacity);
+
+   _dist = std::allocator_traits<dist_allocator>::allocate(dist_alloc, count);
+   try
+   {
+      _slots = value_traits::allocate(_alloc, count);
+      if constexpr (stored_hash)
+      {
+         try
+         {
+            _hashes = std::allocator_traits<hash_allocator>::allocate(hash_alloc, count);
+         }
+         catch (...)
+         {
+            value_traits::deallocate(_alloc, _slots, count);
+            throw;
+         }
+      }
+   }
+   catch (...)
+   {
+      std::allocator_traits<dist_allocator>::deallocate(dist_alloc, _dist, count);
+      _dist = nullptr;
+      _slots = nullptr;
+      throw;
+   }
+
+   std::fill_n(_dist, count, dist_t{0});
+   _capacity = capacity;
+   _size = 0;
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+void RobinHoodHashBrown<Key, Value, Hash, KeyEqual, Allocator>::deallocate()
+{
+   if (_capacity == 0)
+   {
+      return;
+   }
+
+   dist_allocator dist_alloc{_alloc};
+   hash_allocator hash_alloc{_alloc};
+   const auto count = slot_count();
+
+   if constexpr (stored_hash)
+   {
+      std::allocator_traits<hash_allocator>::deallocate(hash_alloc, _hashes, count);
+   }
+   value_traits::deallocate(_alloc, _slots, count);
+   std::allocator_traits<dist_allocator>::deallocate(dist_alloc, _dist, count);
+
+   _dist = nullptr;
+   _slots = nullptr;
+   _hashes = nullptr;
+   _capacity = 0;
+   _size = 0;
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+void RobinHoodHashBrown<Key, Value, Hash, KeyEqual, Allocator>::destroy()
+{
+   for (auto slot = next_full(0); slot < slot_count(); slot = next_full(slot + 1))
+   {
+      value_traits::destroy(_alloc, _slots + slot);
+   }
+   deallocate();
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+void RobinHoodHashBrown<Key, Value, Hash, KeyEqual, Allocator>::resize(std::size_t new_capacity)
+{
+   RobinHoodHashBrown rebuilt{_alloc};
+   rebuilt._hasher = _hasher;
+   rebuilt._equal = _equal;
+   rebuilt._max_load_factor = _max_load_factor;
+   rebuilt.allocate(new_capacity);
+
+   for (auto slot = next_full(0); slot < slot_count(); slot = next_full(slot + 1))
+   {
+      const auto hash = hash_at(slot);
+      const auto [to, dist] = rebuilt.prepare_insert(hash);
+      value_traits::construct(_alloc, rebuilt._slots + to, std::move(_slots[slot]));
+      if constexpr (stored_hash)
+      {
+         rebuilt._hashes[to] = hash;
+      }
+      rebuilt._dist[to] = dist;
+      ++rebuilt._size;
+   }
+
+   swap_contents(rebuilt);
+}
+
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+void RobinHoodHashBrown<Key, Value, Hash, KeyEqual, Allocator>::swap_contents(RobinHoodHashBrown& other) noexcept
+{
+   using std::swap;
+   swap(_dist, other._dist);
+   swap(_slots, other._slots);
+   swap(_hashes, other._hashes);
+   swap(_capacity, other._capacity);
+   swap(_size, other._size);
+   swap(_hasher, other._hasher);
+   swap(_equal, other._equal);
+   swap(_max_load_factor, other._max_load_factor);
+}
+
+namespace hashbrown::pmr
+{
+   template <typename Key, typename Value, typename Hash = HashFunction<Key>, typename KeyEqual = std::equal_to<>>
+   using RobinHoodHashBrown = ::RobinHoodHashBrown<Key, Value, Hash, KeyEqual, std::pmr::polymorphic_allocator<std::pair<Key, Value>>>;
+}
@@ -0,0 +1,598 @@
+#pragma once
+
+#include <hashbrown.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// A HashBrown for maps that are nearly always tiny. The first N entries live
+// inside the object and are found by a linear scan that never hashes; the
+// insert that would make N + 1 moves them into a regular HashBrown. Until
+// then the map never touches the heap. Clearing it goes back to inline
+// storage.
+template <typename Key,
+          typename Value,
+          std::size_t N = 8,
+          typename Hash = HashFunction<Key>,
+          typename KeyEqual = std::equal_to<>,
+          typename Allocator = std::allocator<std::pair<Key, Value>>>
+class SmallHashBrown
+{
+   static_assert(N > 0, "SmallHashBrown needs room for at least one inline entry");
+
+   template <bool IsConst>
+   class Iterator;
+
+   using Map = HashBrown<Key, Value, Hash, KeyEqual, Allocator>;
+
+   static constexpr bool transparent_lookup =
+      hashbrown::detail::transparent<Hash> && hashbrown::detail::transparent<KeyEqual>;
+
+   using slot_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<std::pair<Key, Value>>;
+   using slot_traits = std::allocator_traits<slot_allocator>;
+
+   public:
+      using value_type = std::pair<Key, Value>;
+      using reference = value_type&;
+      using pointer = value_type*;
+      using const_reference = const value_type&;
+      using iterator = Iterator<false>;
+      using const_iterator = Iterator<true>;
+      using allocator_type = Allocator;
+
+      static constexpr std::size_t inline_capacity = N;
+
+      SmallHashBrown();
+      explicit SmallHashBrown(const Allocator& alloc);
+      explicit SmallHashBrown(const Hash& hash, const KeyEqual& equal = KeyEqual(), const Allocator& alloc = Allocator());
+      SmallHashBrown(std::initializer_list<value_type> il, const Allocator& alloc = Allocator());
+      SmallHashBrown(const SmallHashBrown& other);
+      SmallHashBrown(SmallHashBrown&& other) noexcept(std::is_nothrow_move_constructible_v<value_type>);
+      SmallHashBrown& operator=(const SmallHashBrown& other);
+      SmallHashBrown& operator=(SmallHashBrown&& other);
+      ~SmallHashBrown();
+
+      iterator begin();
+      const_iterator begin() const;
+      const_iterator cbegin() const;
+
+      iterator end();
+      const_iterator end() const;
+      const_iterator cend() const;
+
+      iterator erase(const Key& key);
+      template <typename K>
+      iterator erase(const K& key) requires transparent_lookup;
+
+      void insert(std::initializer_list<value_type> il);
+      template <std::input_iterator InputIt>
+      void insert(InputIt first, InputIt last);
+      iterator insert(Key key, Value value);
+      iterator insert(const value_type& value);
+      iterator insert(value_type&& value);
+      template <typename... Args>
+      iterator emplace(Args&&... args);
+
+      const Value* get(const Key& key) const;
+      template <typename K>
+      const Value* get(const K& key) const requires transparent_lookup;
+      bool contains(const Key& key) const;
+      template <typename K>
+      bool contains(const K& key) const requires transparent_lookup;
+      bool empty() const;
+      std::size_t size() const;
+      void clear();
+      allocator_type get_allocator() const;
+      Hash hash_function() const;
+      KeyEqual key_eq() const;
+
+      // Moves to the hashed representation up front when count will not fit
+      // inline.
+      void reserve(std::size_t count);
+
+      // Whether the entries still live inside the object.
+      bool is_inline() const;
+
+   private:
+      alignas(value_type) std::byte _storage[N * sizeof(value_type)];
+      std::size_t _count;
+      // Empty, and holding no memory, while the entries are inline.
+      Map _map;
+      [[no_unique_address]] KeyEqual _equal;
+
+      value_type* entries();
+      const value_type* entries() const;
+      template <typename K>
+      std::size_t find_inline(const K& key) const;
+      template <typename K>
+      iterator erase_key(const K& key);
+      template <typename V>
+      iterator insert_entry(V&& entry);
+      template <typename V>
+      void append_inline(V&& entry);
+      template <typename InputIt>
+      void fill_inline(InputIt first, InputIt last);
+      void spill(std::size_t count);
+      void destroy_inline() noexcept;
+
+      template <bool IsConst>
+      class Iterator {
+         public:
+            using difference_type = std::ptrdiff_t;
+            using value_type = SmallHashBrown::value_type;
+            using reference = std::conditional_t<IsConst, const_reference, SmallHashBrown::reference>;
+            using pointer = std::conditional_t<IsConst, const value_type*, SmallHashBrown::pointer>;
+            using iterator_category = std::forward_iterator_tag;
+            using map_iterator = std::conditional_t<IsConst, typename Map::const_iterator, typename Map::iterator>;
+
+            Iterator() = default;
+
+            // Inline entries are walked by pointer; once spilled, entry is
+            // null and it walks the HashBrown.
+            Iterator(pointer entry, map_iterator it)
+               : _entry(entry)
+               , _it(it)
+            {
+            }
+
+            operator Iterator<true>() const requires (!IsConst)
+            {
+               return Iterator<true>{_entry, _it};
+            }
+
+            Iterator& operator++()
+            {
+               if (_entry != nullptr)
+               {
+                  ++_entry;
+               }
+               else
+               {
+                  ++_it;
+               }
+               return *this;
+            }
+
+            Iterator operator++(int)
+            {
+               auto temp = *this;
+               ++*this;
+               return temp;
+            }
+
+            reference operator*() const
+            {
+               return _entry != nullptr ? *_entry : *_it;
+            }
+
+            pointer operator->() const
+            {
+               return &this->operator*();
+            }
+
+            friend bool operator==(const Iterator& it_a, const Iterator& it_b)
+            {
+               return it_a._entry == it_b._entry
+                  && it_a._it == it_b._it;
+            }
+
+            friend bool operator!=(const Iterator& it_a, const Iterator& it_b)
+            {
+               return !(it_a == it_b);
+            }
+
+         private:
+            pointer _entry = nullptr;
+            map_iterator _it;
+      };
+};
+
+template <typename Key, typename Value, std::size_t N, typename Hash, typename KeyEqual, typename Allocator>
+SmallHashBrown<Key, Value, N, Hash, KeyEqual, Allocator>::SmallHashBrown()
+   : SmallHashBrown(Allocator())
+{
+}
+
+template <typename Key, typename Value, std::size_t N, typename Hash, typename KeyEqual, typename Allocator>
+SmallHashBrown<Key, Value, N, Hash, KeyEqual, Allocator>::SmallHashBrown(const Allocator& alloc)
+   : SmallHashBrown(Hash(), KeyEqual(), alloc)
+{
+}
+
+template <typename Key, typename Value, std::size_t N, typename Hash, typename KeyEqual, typename Allocator>
+SmallHashBrown<Key, Value, N, Hash, KeyEqual, Allocator>::SmallHashBrown(const Hash& hash, const KeyEqual& equal, const Allocator& alloc)
+   : _count(0)
+   , _map(hash, equal, alloc)
+   , _equal(equal)
+{
+}
+
+template <typename Key, typename Value, std::size_t N, typename Hash, typename KeyEqual, typename Allocator>
+SmallHashBrown<Key, Value, N, Hash, KeyEqual, Allocator>::SmallHashBrown(std::initializer_list<value_type> il, const Allocator& alloc)
+   : SmallHashBrown(alloc)
+{
+   insert(il);
+}
+
+template <typename Key, typename Value, std::size_t N, typename Hash, typename KeyEqual, typename Allocator>
+SmallHashBrown<Key, Value, N, Hash, KeyEqual, Allocator>::SmallHashBrown(const SmallHashBrown& other)
+   : _count(0)
+   , _map(other._map)
+   , _equal(other._equal)
+{
+   fill_inline(other.entries(), other.entries() + other._count);
+}
+
+template <typename Key, typename Value, std::size_t N, typename Hash, typename KeyEqual, typename Allocator>
+SmallHashBrown<Key, Value, N, Hash, KeyEqual, Allocator>::SmallHashBrown(SmallHashBrown&& other) noexcept(std::is_nothrow_move_constructible_v<value_type>)
+   : _count(0)
+   , _map(std::move(other._map))
+   , _equal(other._equal)
+{
+   fill_inline(std::make_move_iterator(other.entries()), std::make_move_iterator(other.entries() + other._count));
+   other.destroy_inline();
+}
+
+template <typename Key, typename Value, std::size_t N, typename Hash, typename KeyEqual, typename Allocator>
+SmallHashBrown<Key, Value, N, Hash, KeyEqual, Allocator>& SmallHashBrown<Key, Value, N, Hash, KeyEqual, Allocator>::operator=(const SmallHashBrown& other)
+{
+   if (this != &other)
+   {
+      destroy_inline();
+      _map = other._map;
+      _equal = other._equal;
+      fill_inline(other.entries(), other.entries() + other._count);
+   }
+   return *this;
+}
+
+template <typename Key, typename Value, std::size_t N, typename Hash, typename KeyEqual, typename Allocator>
+SmallHashBrown<Key, Value, N, Hash, KeyEqual, Allocator>& SmallHashBrown<Key, Value, N, Hash, KeyEqual, Allocator>::operator=(SmallHashBrown&& other)
+{
+   if (this != &other)
+   {
+      destroy_inline();
+      _map = std::move(other._map);
+      _equal = std::move(other._equal);
+      fill_inline(std::make_move_iterator(other.entries()), std::make_move_iterator(other.entries() + other._count));
+      other.destroy_inline();
+   }
+   return *this;
+}
+
+template <typename Key, typename Value, std::size_t N, typename Hash, typename KeyEqual, typename Allocator>
+SmallHashBrown<Key, Value, N, Hash, KeyEqual, Allocator>::~SmallHashBrown()
+{
+   destroy_inline();
+}
+
+template <typename Key, typename Value, std::size_t N, typename Hash, typename KeyEqual, typename Allocator>
+typename SmallHashBrown<Key, Value, N, Hash, KeyEqual, Allocator>::iterator SmallHashBrown<Key, Value, N, Hash, KeyEqual, Allocator>::begin()
+{
+   return is_inline() ? iterator{entries(), {}} : iterator{nullptr, _map.begin()};
+}
+
+template <typename Key, typename Value, std::size_t N, typename Hash, typename KeyEqual, typename Allocator>
+typename SmallHashBrown<Key, Value, N, Hash, KeyEqual, Allocator>::const_iterator SmallHashBrown<Key, Value, N, Hash, KeyEqual, Allocator>::begin() const
+{
+   return is_inline() ? const_iterator{entries(), {}} : const_iterator{nullptr, _map.begin()};
+}
+
+template <typename Key, typename Value, std::size_t N, typename Hash, typename KeyEqual, typename Allocator>
+typename SmallHashBrown<Key, Value, N, Hash, KeyEqual, Allocator>::const_iterator SmallHashBrown<Key, Value, N, Hash, KeyEqual, Allocator>::cbegin() const
+{
+   return begin();
+}
+
+template <typename Key, typename Value, std::size_t N, typename Hash, typename KeyEqual, typename Allocator>
+typename SmallHashBrown<Key, Value, N, Hash, KeyEqual, Allocator>::iterator SmallHashBrown<Key, Value, N, Hash, KeyEqual, Allocator>::end()
+{
+   return is_inline() ? iterator{entries() + _count, {}} : iterator{nullptr, _map.end()};
+}
+
+template <typename Key, typename Value, std::size_t N, typename Hash, typename KeyEqual, typename Allocator>
+typename SmallHashBrown<Key, Value, N, Hash, KeyEqual, Allocator>::const_iterator SmallHashBrown<Key, Value, N, Hash, KeyEqual, Allocator>::end() const
+{
+   return is_inline() ? const_iterator{entries() + _count, {}} : const_iterator{nullptr, _map.end()};
+}
+
+template <typename Key, typename Value, std::size_t N, typename Hash, typename KeyEqual, typename Allocator>
+typename SmallHashBrown<Key, Value, N, Hash, KeyEqual, Allocator>::const_iterator SmallHashBrown<Key, Value, N, Hash, KeyEqual, Allocator>::cend() const
+{
+   return end();
+}
+
+template <typename Key, typename Value, std::size_t N, typename Hash, typename KeyEqual, typename Allocator>
+typename SmallHashBrown<Key, Value, N, Hash, KeyEqual, Allocator>::iterator SmallHashBrown<Key, Value, N, Hash, KeyEqual, Allocator>::erase(const Key& key)
+{
+   return erase_key(key);
+}
+
+template <typename Key, typename Value, std::size_t N, typename Hash, typename KeyEqual, typename Allocator>
+template <typename K>
+typename SmallHashBrown<Key, Value, N, Hash, KeyEqual, Allocator>::iterator SmallHashBrown<Key, Value, N, Hash, KeyEqual, Allocator>::erase(const K& key)
+   requires transparent_lookup
+{
+   return erase_key(key);
+}
+
+template <typename Key, typename Value, std::size_t N, typename Hash, typename KeyEqual, typename Allocator>
+void SmallHashBrown<Key, Value, N, Hash, KeyEqual, Allocator>::insert(std::initializer_list<value_type> il)
+{
+   insert(il.begin(), il.end());
+}
+
+template <typename Key, typename Value, std::size_t N, typename Hash, typename KeyEqual, typename Allocator>
+template <std::input_iterator InputIt>
+void SmallHashBrown<Key, Value, N, Hash, KeyEqual, Allocator>::insert(InputIt first, InputIt last)
+{
+   for (; first != last; ++first)
+   {
+      insert_entry(*first);
+   }
+}
+
+template <typename Key, typename Value, std::size_t N, typename Hash, typename KeyEqual, typename Allocator>
+typename SmallHashBrown<Key, Value, N, Hash, KeyEqual, Allocator>::iterator SmallHashBrown<Key, Value, N, Hash, KeyEqual, Allocator>::insert(Key key, Value value)
+{
+   return insert_entry(value_type(std::move(key), std::move(value)));
+}
+
+template <typename Key, typename Value, std::size_t N, typename Hash, typename KeyEqual, typename Allocator>
+typename SmallHashBrown<Key, Value, N, Hash, KeyEqual, Allocator>::iterator SmallHashBrown<Key, Value, N, Hash, KeyEqual, Allocator>::insert(const value_type& value)
+{
+   return insert_entry(value);
+}
+
+template <typename Key, typename Value, std::size_t N, typename Hash, typename KeyEqual, typename Allocator>
+typename SmallHashBrown<Key, Value, N, Hash, KeyEqual, Allocator>::iterator SmallHashBrown<Key, Value, N, Hash, KeyEqual, Allocator>::insert(value_type&& value)
+{
+   return insert_entry(std::move(value));
+}
+
+template <typename Key, typename Value, std::size_t N, typename Hash, typename KeyEqual, typename Allocator>
+template <typename... Args>
+typename SmallHashBrown<Key, Value, N, Hash, KeyEqual, Allocator>::iterator SmallHashBrown<Key, Value, N, Hash, KeyEqual, Allocator>::emplace(Args&&... args)
+{
+   if (!is_inline())
+   {
+      return iterator{nullptr, _map.emplace(std::forward<Args>(args)...)};
+   }
+   return insert_entry(value_type(std::forward<Args>(args)...));
+}
+
+template <typename Key, typename Value, std::size_t N, typename Hash, typename KeyEqual, typename Allocator>
+const Value* SmallHashBrown<Key, Value, N, Hash, KeyEqual, Allocator>::get(const Key& key) const
+{
+   if (!is_inline())
+   {
+      return _map.get(key);
+   }
+   const auto index = find_inline(key);
+   return index != _count ? &entries()[index].second : nullptr;
+}
+
+template <typename Key, typename Value, std::size_t N, typename Hash, typename KeyEqual, typename Allocator>
+template <typename K>
+const Value* SmallHashBrown<Key, Value, N, Hash, KeyEqual, Allocator>::get(const K& key) const
+   requires transparent_lookup
+{
+   if (!is_inline())
+   {
+      return _map.get(key);
+   }
+   const auto index = find_inline(key);
+   return index != _count ? &entries()[index].second : nullptr;
+}
+
+template <typename Key, typename Value, std::size_t N, typename Hash, typename KeyEqual, typename Allocator>
+bool SmallHashBrown<Key, Value, N, Hash, KeyEqual, Allocator>::contains(const Key& key) const
+{
+   return get(key) != nullptr;
+}
+
+template <typename Key, typename Value, std::size_t N, typename Hash, typename KeyEqual, typename Allocator>
+template <typename K>
+bool SmallHashBrown<Key, Value, N, Hash, KeyEqual, Allocator>::contains(const K& key) const
+   requires transparent_lookup
+{
+   return get(key) != nullptr;
+}
+
+template <typename Key, typename Value, std::size_t N, typename Hash, typename KeyEqual, typename Allocator>
+bool SmallHashBrown<Key, Value, N, Hash, KeyEqual, Allocator>::empty() const
+{
+   return size() == 0;
+}
+
+template <typename Key, typename Value, std::size_t N, typename Hash, typename KeyEqual, typename Allocator>
+std::size_t SmallHashBrown<Key, Value, N, Hash, KeyEqual, Allocator>::size() const
+{
+   return is_inline() ? _count : _map.size();
+}
+
+template <typename Key, typename Value, std::size_t N, typename Hash, typename KeyEqual, typename Allocator>
+void SmallHashBrown<Key, Value, N, Hash, KeyEqual, Allocator>::clear()
+{
+   destroy_inline();
+   _map.clear();
+}
+
+template <typename Key, typename Value, std::size_t N, typename Hash, typename KeyEqual, typename Allocator>
+typename SmallHashBrown<Key, Value, N, Hash, KeyEqual, Allocator>::allocator_type SmallHashBrown<Key, Value, N, Hash, KeyEqual, Allocator>::get_allocator() const
+{
+   return _map.get_allocator();
+}
+
+template <typename Key, typename Value, std::size_t N, typename Hash, typename KeyEqual, typename Allocator>
+Hash SmallHashBrown<Key, Value, N, Hash, KeyEqual, Allocator>::hash_function() const
+{
+   return _map.hash_function();
+}
+
+template <typename Key, typename Value, std::size_t N, typename Hash, typename KeyEqual, typename Allocator>
+KeyEqual SmallHashBrown<Key, Value, N, Hash, KeyEqual, Allocator>::key_eq() const
+{
+   return _equal;
+}
+
+template <typename Key, typename Value, std::size_t N, typename Hash, typename KeyEqual, typename Allocator>
+void SmallHashBrown<Key, Value, N, Hash, KeyEqual, Allocator>::reserve(std::size_t count)
+{
+   if (!is_inline())
+   {
+      _map.reserve(count);
+   }
+   else if (count > N)
+   {
+      spill(count);
+   }
+}
+
+template <typename Key, typename Value, std::size_t N, typename Hash, typename KeyEqual, typename Allocator>
+bool SmallHashBrown<Key, Value, N, Hash, KeyEqual, Allocator>::is_inline() const
+{
+   return _map.capacity() == 0;
+}
+
+template <typename Key, typename Value, std::size_t N, typename Hash, typename KeyEqual, typename Allocator>
+typename SmallHashBrown<Key, Value, N, Hash, KeyEqual, Allocator>::value_type* SmallHashBrown<Key, Value, N, Hash, KeyEqual, Allocator>::entries()
+{
+   return std::launder(reinterpret_cast<value_type*>(_storage));
+}
+
+template <typename Key, typename Value, std::size_t N, typename Hash, typename KeyEqual, typename Allocator>
+const typename SmallHashBrown<Key, Value, N, Hash, KeyEqual, Allocator>::value_type* SmallHashBrown<Key, Value, N, Hash, KeyEqual, Allocator>::entries() const
+{
+   return std::launder(reinterpret_cast<const value_type*>(_storage));
+}
+
+template <typename Key, typename Value, std::size_t N, typename Hash, typename KeyEqual, typename Allocator>
+template <typename K>
+std::size_t SmallHashBrown<Key, Value, N, Hash, KeyEqual, Allocator>::find_inline(const K& key) const
+{
+   const auto first = entries();
+   std::size_t index = 0;
+   while (index < _count && !_equal(first[index].first, key))
+   {
+      ++index;
+   }
+   return index;
+}
+
+template <typename Key, typename Value, std::size_t N, typename Hash, typename KeyEqual, typename Allocator>
+template <typename K>
+typename SmallHashBrown<Key, Value, N, Hash, KeyEqual, Allocator>::iterator SmallHashBrown<Key, Value, N, Hash, KeyEqual, Allocator>::erase_key(const K& key)
+{
+   if (!is_inline())
+   {
+      return iterator{nullptr, _map.erase(key)};
+   }
+
+   const auto index = find_inline(key);
+   if (index == _count)
+   {
+      return end();
+   }
+
+   // The last entry fills the gap; it has not been visited yet by anyone
+   // iterating up to the erased one.
+   const auto first = entries();
+   if (index != _count - 1)
+   {
+      first[index] = std::move(first[_count - 1]);
+   }
+   auto alloc = slot_allocator(_map.get_allocator());
+   slot_traits::destroy(alloc, first + _count - 1);
+   --_count;
+   return iterator{first + index, {}};
+}
+
+template <typename Key, typename Value, std::size_t N, typename Hash, typename KeyEqual, typename Allocator>
+template <typename V>
+typename SmallHashBrown<Key, Value, N, Hash, KeyEqual, Allocator>::iterator SmallHashBrown<Key, Value, N, Hash, KeyEqual, Allocator>::insert_entry(V&& entry)
+{
+   if (is_inline())
+   {
+      const auto first = entries();
+      const auto index = find_inline(entry.first);
+      if (index != _count)
+      {
+         first[index].second = std::forward<V>(entry).second;
+         return iterator{first + index, {}};
+      }
+      if (_count < N)
+      {
+         append_inline(std::forward<V>(entry));
+         return iterator{first + _count - 1, {}};
+      }
+      spill(N + 1);
+   }
+   return iterator{nullptr, _map.insert(std::forward<V>(entry))};
+}
+
+// Built through the map's allocator, so that allocator-aware keys and values
+// get the same resource inline as they would in the table.
+template <typename Key, typename Value, std::size_t N, typename Hash, typename KeyEqual, typename Allocator>
+template <typename V>
+void SmallHashBrown<Key, Value, N, Hash, KeyEqual, Allocator>::append_inline(V&& entry)
+{
+   auto alloc = slot_allocator(_map.get_allocator());
+   slot_traits::construct(alloc, entries() + _count, std::forward<V>(entry));
+   ++_count;
+}
+
+// Fills the empty inline storage, or leaves it empty if an entry throws.
+template <typename Key, typename Value, std::size_t N, typename Hash, typename KeyEqual, typename Allocator>
+template <typename InputIt>
+void SmallHashBrown<Key, Value, N, Hash, KeyEqual, Allocator>::fill_inline(InputIt first, InputIt last)
+{
+   try
+   {
+      for (; first != last; ++first)
+      {
+         append_inline(*first);
+      }
+   }
+   catch (...)
+   {
+      destroy_inline();
+      throw;
+   }
+}
+
+template <typename Key, typename Value, std::size_t N, typename Hash, typename KeyEqual, typename Allocator>
+void SmallHashBrown<Key, Value, N, Hash, KeyEqual, Allocator>::spill(std::size_t count)
+{
+   _map.reserve(std::max(count, _count));
+   for (auto entry = entries(); entry != entries() + _count; ++entry)
+   {
+      _map.insert(std::move(*entry));
+   }
+   destroy_inline();
+}
+
+template <typename Key, typename Value, std::size_t N, typename Hash, typename KeyEqual, typename Allocator>
+void SmallHashBrown<Key, Value, N, Hash, KeyEqual, Allocator>::destroy_inline() noexcept
+{
+   auto alloc = slot_allocator(_map.get_allocator());
+   for (auto entry = entries(); entry != entries() + _count; ++entry)
+   {
+      slot_traits::destroy(alloc, entry);
+   }
+   _count = 0;
+}
+
+namespace hashbrown::pmr
+{
+   template <typename Key, typename Value, std::size_t N = 8, typename Hash = HashFunction<Key>, typename KeyEqual = std::equal_to<>>
+   using SmallHashBrown = ::SmallHashBrown<Key, Value, N, Hash, KeyEqual, std::pmr::polymorphic_allocator<std::pair<Key, Value>>>;
+}
@@ -0,0 +1,273 @@
+#pragma once
+
+#include <hashbrown.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <span>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Group-by aggregation without a shared map. Every thread folds its values
+// into a private HashBrown of its own, on its own cache lines, with no
+// synchronisation at all; merge() then combines the private maps into one.
+// The merge splits every private map by hash into partitions, so the
+// partitions hold disjoint keys and are combined in parallel.
+//
+// Combine folds a value into the one already stored for its key, as
+// stored = combine(std::move(stored), value). It has to be associative, and
+// commutative too unless the order of the threads' contributions does not
+// matter: merge() folds thread 0's value first, then thread 1's, and so on.
+template <typename Key,
+          typename Value,
+          typename Combine = std::plus<>,
+          typename Hash = HashFunction<Key>,
+          typename KeyEqual = std::equal_to<>>
+class ThreadLocalAggregator
+{
+   static constexpr bool transparent_lookup =
+      hashbrown::detail::transparent<Hash> && hashbrown::detail::transparent<KeyEqual>;
+
+   public:
+      using map_type = HashBrown<Key, Value, Hash, KeyEqual>;
+      using value_type = typename map_type::value_type;
+
+      // One thread's private map. A Local must only be used by one thread at
+      // a time; different Locals may be used concurrently.
+      class alignas(hashbrown::detail::cache_line_size) Local
+      {
+         public:
+            void add(const Key& key, const Value& value);
+            template <typename K>
+            void add(const K& key, const Value& value) requires transparent_lookup && std::constructible_from<Key, const K&>;
+
+            const map_type& map() const;
+
+         private:
+            friend class ThreadLocalAggregator;
+
+            template <typename K>
+            void add_key(const K& key, const Value& value);
+
+            map_type _map;
+            Combine _combine;
+      };
+
+      // One Local per hardware thread.
+      ThreadLocalAggregator();
+      explicit ThreadLocalAggregator(std::size_t threads, const Combine& combine = Combine());
+
+      ThreadLocalAggregator(const ThreadLocalAggregator&) = delete;
+      ThreadLocalAggregator& operator=(const ThreadLocalAggregator&) = delete;
+
+      // The private map of thread number thread, which is below threads().
+      Local& local(std::size_t thread);
+      std::size_t threads() const;
+
+      // Combines every Local into one map and leaves the Locals empty, ready
+      // for the next round. Must not run while any thread is adding.
+      map_type merge(hashbrown::Parallel policy = {});
+
+   private:
+      // Below this many entries per thread the merge runs serially.
+      static constexpr std::size_t merge_grain = std::size_t{1} << 12;
+      // More partitions than threads lets a thread that drew a light
+      // partition take another.
+      static constexpr std::size_t partitions_per_worker = 4;
+
+      std::unique_ptr<Local[]> _locals;
+      std::size_t _threads;
+      Combine _combine;
+};
+
+template <typename Key, typename Value, typename Combine, typename Hash, typename KeyEqual>
+void ThreadLocalAggregator<Key, Value, Combine, Hash, KeyEqual>::Local::add(const Key& key, const Value& value)
+{
+   add_key(key, value);
+}
+
+template <typename Key, typename Value, typename Combine, typename Hash, typename KeyEqual>
+template <typename K>
+void ThreadLocalAggregator<Key, Value, Combine, Hash, KeyEqual>::Local::add(const K& key, const Value& value)
+   requires transparent_lookup && std::constructible_from<Key, const K&>
+{
+   add_key(key, value);
+}
+
+template <typename Key, typename Value, typename Combine, typename Hash, typename KeyEqual>
+template <typename K>
+void ThreadLocalAggregator<Key, Value, Combine, Hash, KeyEqual>::Local::add_key(const K& key, const Value& value)
+{
+   // A key is usually seen many times, so only a miss pays for building it.
+   if (auto stored = const_cast<Value*>(_map.get(key)))
+   {
+      *stored = _combine(std::move(*stored), value);
+   }
+   else
+   {
+      _map.insert(Key(key), value);
+   }
+}
+
+template <typename Key, typename Value, typename Combine, typename Hash, typename KeyEqual>
+const typename ThreadLocalAggregator<Key, Value, Combine, Hash, KeyEqual>::map_type& ThreadLocalAggregator<Key, Value, Combine, Hash, KeyEqual>::Local::map() const
+{
+   return _map;
+}
+
+template <typename Key, typename Value, typename Combine, typename Hash, typename KeyEqual>
+ThreadLocalAggregator<Key, Value, Combine, Hash, KeyEqual>::ThreadLocalAggregator()
+   : ThreadLocalAggregator(std::max(1u, std::thread::hardware_concurrency()))
+{
+}
+
+template <typename Key, typename Value, typename Combine, typename Hash, typename KeyEqual>
+ThreadLocalAggregator<Key, Value, Combine, Hash, KeyEqual>::ThreadLocalAggregator(std::size_t threads, const Combine& combine)
+   : _locals(std::make_unique<Local[]>(std::max<std::size_t>(threads, 1)))
+   , _threads(std::max<std::size_t>(threads, 1))
+   , _combine(combine)
+{
+   for (std::size_t i = 0; i < _threads; ++i)
+   {
+      _locals[i]._combine = combine;
+   }
+}
+
+template <typename Key, typename Value, typename Combine, typename Hash, typename KeyEqual>
+typename ThreadLocalAggregator<Key, Value, Combine, Hash, KeyEqual>::Local& ThreadLocalAggregator<Key, Value, Combine, Hash, KeyEqual>::local(std::size_t thread)
+{
+   return _locals[thread];
+}
+
+template <typename Key, typename Value, typename Combine, typename Hash, typename KeyEqual>
+std::size_t ThreadLocalAggregator<Key, Value, Combine, Hash, KeyEqual>::threads() const
+{
+   return _threads;
+}
+
+template <typename Key, typename Value, typename Combine, typename Hash, typename KeyEqual>
+typename ThreadLocalAggregator<Key, Value, Combine, Hash, KeyEqual>::map_type ThreadLocalAggregator<Key, Value, Combine, Hash, KeyEqual>::merge(hashbrown::Parallel policy)
+{
+   std::size_t total = 0;
+   for (std::size_t i = 0; i < _threads; ++i)
+   {
+      total += _locals[i]._map.size();
+   }
+
+   const auto workers = hashbrown::detail::worker_count(policy.threads, total, merge_grain);
+   const auto partitions = workers < 2 ? std::size_t{1} : std::bit_ceil(workers * partitions_per_worker);
+   const auto partition_bits = static_cast<unsigned>(std::countr_zero(partitions));
+   const auto hasher = _locals[0]._map.hash_function();
+
+   // Takes jobs [0, jobs) from a shared counter on every worker.
+   const auto share = [&](std::size_t jobs, const auto& job) {
+      std::atomic<std::size_t> next{0};
+      hashbrown::detail::run_workers(std::min(workers, jobs), [&](std::size_t) {
+         for (auto i = next.fetch_add(1); i < jobs; i = next.fetch_add(1))
+         {
+            job(i);
+         }
+      });
+   };
+
+   // Move every Local's entries out, split by partition. The Fibonacci mix
+   // picks partitions from bits the maps below do not index groups by.
+   std::vector<std::vector<value_type>> split(_threads * partitions);
+   share(_threads, [&](std::size_t thread) {
+      auto& map = _locals[thread]._map;
+      auto* buckets = split.data() + thread * partitions;
+      for (auto& bucket : std::span(buckets, partitions))
+      {
+         bucket.reserve(map.size() / partitions + map.size() / (8 * partitions) + 1);
+      }
+      for (auto& entry : map)
+      {
+         buckets[hashbrown::detail::shard_of(hasher(entry.first), partition_bits)].push_back(std::move(entry));
+      }
+      map.clear();
+   });
+
+   // Partitions hold disjoint keys, so each is combined on its own, folding
+   // in the threads' contributions in thread order.
+   std::vector<map_type> combined(partitions);
+   share(partitions, [&](std::size_t partition) {
+      auto& map = combined[partition];
+      std::size_t count = 0;
+      for (std::size_t thread = 0; thread < _threads; ++thread)
+      {
+         count += split[thread * partitions + partition].size();
+      }
+      map.reserve(count);
+
+      for (std::size_t thread = 0; thread < _threads; ++thread)
+      {
+         auto& bucket = split[thread * partitions + partition];
+         for (auto& [key, value] : bucket)
+         {
+            if (auto stored = const_cast<Value*>(map.get(key)))
+            {
+               *stored = _combine(std::move(*stored), std::move(value));
+            }
+            else
+            {
+               map.insert(std::move(key), std::move(value));
+            }
+         }
+         std::vector<value_type>().swap(bucket);
+      }
+   });
+
+   if (partitions == 1)
+   {
+      return std::move(combined[0]);
+   }
+
+   // Gather the partitions side by side in one buffer, each moved there by
+   // whichever thread takes it, so the bulk insert reads a single range.
+   std::vector<std::size_t> offsets(partitions + 1);
+   for (std::size_t partition = 0; partition < partitions; ++partition)
+   {
+      offsets[partition + 1] = offsets[partition] + combined[partition].size();
+   }
+   const auto count = offsets[partitions];
+
+   std::allocator<value_type> alloc;
+   auto* entries = alloc.allocate(count);
+   std::vector<char> gathered(partitions);
+   const auto release = [&] {
+      for (std::size_t partition = 0; partition < partitions; ++partition)
+      {
+         if (gathered[partition])
+         {
+            std::destroy(entries + offsets[partition], entries + offsets[partition + 1]);
+         }
+      }
+      alloc.deallocate(entries, count);
+   };
+
+   map_type result;
+   try
+   {
+      share(partitions, [&](std::size_t partition) {
+         auto& map = combined[partition];
+         std::uninitialized_move(map.begin(), map.end(), entries + offsets[partition]);
+         gathered[partition] = 1;
+         map.clear();
+      });
+      result.insert(policy, std::make_move_iterator(entries), std::make_move_iterator(entries + count));
+   }
+   catch (...)
+   {
+      release();
+      throw;
+   }
+   release();
+   return result;
+}
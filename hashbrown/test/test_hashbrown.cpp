@@ -3,6 +3,35 @@
 #include "catch2/catch.hpp"
 
 #include <hashbrown.hpp>
+#include <concurrent_hashbrown.hpp>
+#include <cuckoo_hashbrown.hpp>
+#include <dense_hashbrown.hpp>
+#include <frozen_hashbrown.hpp>
+#include <hashbrown_set.hpp>
+#include <hashbrown_view.hpp>
+#include <rcu_hashbrown.hpp>
+#include <robin_hood_hashbrown.hpp>
+#include <small_hashbrown.hpp>
+#include <thread_local_aggregator.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <vector>
 
 TEST_CASE("Hash map can insert", "[hashbrown]") {
   auto map = HashBrown<int, int>();
@@ -24,7 +53,6 @@ TEST_CASE("Hash map can insert", "[hashbrown]") {
   }
 }
 
-#ifdef REMOVE_ELEM_TEST
 TEST_CASE("Can remove element from hash map", "[hashbrown]") {
   auto map = HashBrown<int, int>();
   map.insert(1, 42);
@@ -32,7 +60,6 @@ TEST_CASE("Can remove element from hash map", "[hashbrown]") {
   const auto value = map.get(1);
   REQUIRE(value == nullptr);
 }
-#endif
 
 TEST_CASE("Hashmap is empty by default", "[hashbrown]") {
   auto map = HashBrown<int, int>();
@@ -41,3 +68,1556 @@ TEST_CASE("Hashmap is empty by default", "[hashbrown]") {
   REQUIRE(begin == end);
   REQUIRE(map.empty());
 }
+
+TEST_CASE("Hash map finds every inserted element after growing", "[hashbrown]") {
+  auto map = HashBrown<int, int>();
+  for (int i = 0; i < 10000; ++i) {
+    map.insert(i, i * 2);
+  }
+
+  REQUIRE(map.size() == 10000);
+  for (int i = 0; i < 10000; ++i) {
+    const auto value = map.get(int{i});
+    REQUIRE(value != nullptr);
+    REQUIRE(*value == i * 2);
+  }
+  REQUIRE(map.get(10000) == nullptr);
+  REQUIRE(map.get(-1) == nullptr);
+}
+
+TEST_CASE("Erasing keeps the remaining elements reachable", "[hashbrown]") {
+  auto map = HashBrown<int, std::string>();
+  for (int i = 0; i < 1000; ++i) {
+    map.insert(i, std::to_string(i));
+  }
+  for (int i = 0; i < 1000; i += 2) {
+    map.erase(i);
+  }
+
+  REQUIRE(map.size() == 500);
+  for (int i = 0; i < 1000; ++i) {
+    const auto value = map.get(int{i});
+    if (i % 2 == 0) {
+      REQUIRE(value == nullptr);
+    } else {
+      REQUIRE(value != nullptr);
+      REQUIRE(*value == std::to_string(i));
+    }
+  }
+
+  SECTION("Erasing a missing key does nothing") {
+    REQUIRE(map.erase(0) == map.end());
+    REQUIRE(map.size() == 500);
+  }
+}
+
+TEST_CASE("Iteration visits every element exactly once", "[hashbrown]") {
+  auto map = HashBrown<int, int>();
+  for (int i = 0; i < 100; ++i) {
+    map.insert(i, i);
+  }
+
+  std::size_t count = 0;
+  int sum = 0;
+  for (const auto& [key, value] : map) {
+    REQUIRE(key == value);
+    sum += key;
+    ++count;
+  }
+  REQUIRE(count == 100);
+  REQUIRE(sum == 4950);
+
+  const auto& const_map = map;
+  REQUIRE(std::distance(const_map.begin(), const_map.end()) == 100);
+}
+
+TEST_CASE("Copies and moves own their elements", "[hashbrown]") {
+  auto map = HashBrown<std::string, int>{{"one", 1}, {"two", 2}};
+  auto copy = map;
+  copy.insert("three", 3);
+
+  REQUIRE(map.size() == 2);
+  REQUIRE(copy.size() == 3);
+  REQUIRE(map.get("three") == nullptr);
+
+  auto moved = std::move(copy);
+  REQUIRE(moved.size() == 3);
+  REQUIRE(*moved.get("two") == 2);
+  REQUIRE(copy.empty());
+}
+
+namespace {
+  struct CountedKey {
+    static inline int constructions = 0;
+
+    explicit CountedKey(int v) : value(v) { ++constructions; }
+    CountedKey(const CountedKey& other) : value(other.value) { ++constructions; }
+    CountedKey(CountedKey&& other) noexcept : value(other.value) { ++constructions; }
+
+    int value;
+  };
+
+  struct CountedKeyHash {
+    using is_transparent = void;
+
+    std::size_t operator()(const CountedKey& key) const { return std::hash<int>{}(key.value); }
+    std::size_t operator()(int key) const { return std::hash<int>{}(key); }
+  };
+
+  struct CountedKeyEqual {
+    using is_transparent = void;
+
+    bool operator()(const CountedKey& a, const CountedKey& b) const { return a.value == b.value; }
+    bool operator()(const CountedKey& a, int b) const { return a.value == b; }
+  };
+}
+
+namespace {
+  struct Tracked {
+    static inline int copies = 0;
+    static inline int moves = 0;
+
+    Tracked(int a, int b) : payload(static_cast<std::size_t>(a), b) {}
+    Tracked(const Tracked& other) : payload(other.payload) { ++copies; }
+    Tracked(Tracked&& other) noexcept : payload(std::move(other.payload)) { ++moves; }
+    Tracked& operator=(const Tracked& other) { payload = other.payload; ++copies; return *this; }
+    Tracked& operator=(Tracked&& other) noexcept { payload = std::move(other.payload); ++moves; return *this; }
+
+    std::vector<int> payload;
+  };
+}
+
+TEST_CASE("In-place insertion makes no intermediate copies", "[hashbrown]") {
+  auto map = HashBrown<int, Tracked>();
+  map.reserve(16);
+  Tracked::copies = 0;
+  Tracked::moves = 0;
+
+  const auto [it, inserted] = map.try_emplace(1, 3, 7);
+  REQUIRE(inserted);
+  REQUIRE(it->second.payload == std::vector<int>{7, 7, 7});
+
+  const auto [again, second_insert] = map.try_emplace(1, 5, 5);
+  REQUIRE(!second_insert);
+  REQUIRE(again->second.payload.size() == 3);
+
+  map.emplace(std::piecewise_construct, std::forward_as_tuple(2), std::forward_as_tuple(2, 9));
+  REQUIRE(map.get(2)->payload == std::vector<int>{9, 9});
+  REQUIRE(Tracked::copies == 0);
+  REQUIRE(Tracked::moves == 0);
+
+  SECTION("insert_or_assign moves into an existing entry") {
+    const auto [assigned, was_inserted] = map.insert_or_assign(1, Tracked(1, 4));
+    REQUIRE(!was_inserted);
+    REQUIRE(assigned->second.payload == std::vector<int>{4});
+    REQUIRE(Tracked::copies == 0);
+    REQUIRE(Tracked::moves == 1);
+  }
+
+  SECTION("emplace still overwrites like insert") {
+    map.emplace(std::piecewise_construct, std::forward_as_tuple(1), std::forward_as_tuple(1, 0));
+    REQUIRE(map.get(1)->payload == std::vector<int>{0});
+    REQUIRE(Tracked::copies == 0);
+  }
+
+  SECTION("String keys are built once, in the slot") {
+    auto strings = HashBrown<std::string, Tracked>();
+    strings.try_emplace(std::string(40, 'k'), 1, 1);
+    strings.emplace(std::piecewise_construct, std::forward_as_tuple(40, 'j'), std::forward_as_tuple(1, 2));
+    REQUIRE(strings.size() == 2);
+    REQUIRE(strings.get(std::string(40, 'j'))->payload == std::vector<int>{2});
+    REQUIRE(Tracked::copies == 0);
+  }
+}
+
+TEST_CASE("Node handles move entries between maps without copies", "[hashbrown]") {
+  auto source = HashBrown<std::string, Tracked>();
+  auto target = HashBrown<std::string, Tracked>();
+  for (int i = 0; i < 100; ++i) {
+    source.try_emplace(std::to_string(i), 2, i);
+  }
+  target.reserve(200);
+  Tracked::copies = 0;
+
+  auto node = source.extract("42");
+  REQUIRE(!node.empty());
+  REQUIRE(node.key() == "42");
+  REQUIRE(node.mapped().payload == std::vector<int>{42, 42});
+  REQUIRE(source.size() == 99);
+  REQUIRE(!source.contains("42"));
+  REQUIRE(source.extract("42").empty());
+
+  auto result = target.insert(std::move(node));
+  REQUIRE(result.inserted);
+  REQUIRE(result.node.empty());
+  REQUIRE(result.position->first == "42");
+  REQUIRE(target.get("42")->payload == std::vector<int>{42, 42});
+
+  SECTION("A present key hands the node back") {
+    target.try_emplace("7", 1, -1);
+    auto first = source.begin();
+    if (first->first == "7") {
+      ++first;
+    }
+    auto returned = target.insert(source.extract(first));
+    REQUIRE(returned.inserted);
+    REQUIRE(source.size() == 98);
+
+    returned = target.insert(source.extract("7"));
+    REQUIRE(!returned.inserted);
+    REQUIRE(returned.position->first == "7");
+    REQUIRE(returned.node.mapped().payload == std::vector<int>{7, 7});
+    REQUIRE(target.get("7")->payload == std::vector<int>{-1});
+  }
+
+  SECTION("merge moves only keys that are missing") {
+    target.try_emplace("7", 1, -1);
+    target.merge(source);
+    REQUIRE(target.size() == 100);
+    REQUIRE(source.size() == 1);
+    REQUIRE(source.get("7")->payload == std::vector<int>{7, 7});
+    REQUIRE(target.get("7")->payload == std::vector<int>{-1});
+    for (int i = 0; i < 100; ++i) {
+      REQUIRE(target.contains(std::to_string(i)));
+    }
+  }
+
+  SECTION("Differently seeded maps rehash merged keys") {
+    auto seeded = HashBrown<std::string, Tracked>(HashFunction<std::string>{99});
+    seeded.merge(source);
+    REQUIRE(seeded.size() == 99);
+    for (int i = 0; i < 100; ++i) {
+      REQUIRE(seeded.contains(std::to_string(i)) == (i != 42));
+    }
+  }
+
+  REQUIRE(Tracked::copies == 0);
+}
+
+TEST_CASE("String keyed maps accept string views and literals", "[hashbrown]") {
+  auto map = HashBrown<std::string, int>{{"one", 1}, {"two", 2}};
+  const std::string_view two = "two";
+
+  REQUIRE(map.get(two) != nullptr);
+  REQUIRE(*map.get(two) == 2);
+  REQUIRE(*map.get("one") == 1);
+  REQUIRE(map.contains("one"));
+  REQUIRE_FALSE(map.contains(std::string_view{"three"}));
+
+  map.erase(two);
+  REQUIRE_FALSE(map.contains("two"));
+  REQUIRE(map.size() == 1);
+}
+
+TEST_CASE("Transparent lookups never construct a key", "[hashbrown]") {
+  auto map = HashBrown<CountedKey, int, CountedKeyHash, CountedKeyEqual>();
+  map.insert(CountedKey{1}, 10);
+  map.insert(CountedKey{2}, 20);
+
+  const auto before = CountedKey::constructions;
+  REQUIRE(*map.get(1) == 10);
+  REQUIRE(map.contains(2));
+  REQUIRE_FALSE(map.contains(3));
+  map.erase(1);
+  REQUIRE(CountedKey::constructions == before);
+  REQUIRE(map.size() == 1);
+}
+
+TEST_CASE("The default hash spreads structured keys", "[hash]") {
+  const HashFunction<std::uint64_t> hash;
+  std::vector<bool> seen_h2(128);
+  std::vector<int> per_group(1024);
+  for (std::uint64_t i = 0; i < 4096; ++i) {
+    const auto h = hash(i * 1024);
+    seen_h2[hashbrown::detail::h2(h)] = true;
+    ++per_group[hashbrown::detail::h1(h) % per_group.size()];
+  }
+  REQUIRE(std::count(seen_h2.begin(), seen_h2.end(), true) == 128);
+  // Four keys per group on average; an identity hash would put all 4096 in one.
+  REQUIRE(*std::max_element(per_group.begin(), per_group.end()) < 16);
+
+  SECTION("Strings hash the same through every view of them") {
+    const HashFunction<std::string> string_hash;
+    const std::string key = "a key long enough to take the bulk path of hash_bytes";
+    REQUIRE(string_hash(key) == string_hash(std::string_view{key}));
+    REQUIRE(string_hash(key) == HashFunction<std::string_view>{}(key));
+    REQUIRE(string_hash("") != string_hash(std::string_view{"\0", 1}));
+  }
+
+  SECTION("Seeds change every hash") {
+    const HashFunction<std::uint64_t> seeded{hashbrown::random_seed() | 1};
+    int same = 0;
+    for (std::uint64_t i = 0; i < 1000; ++i) {
+      same += hash(i) == seeded(i);
+    }
+    REQUIRE(same == 0);
+
+    // No seed can cancel out the multiplier and collapse every key.
+    const auto secret = hashbrown::detail::secret[1];
+    REQUIRE(hashbrown::hash_int(1, secret) != hashbrown::hash_int(2, secret));
+    REQUIRE(hashbrown::hash_int(1, secret) != 0);
+
+    auto map = HashBrown<std::string, int>(HashFunction<std::string>{42});
+    map.insert("one", 1);
+    REQUIRE(map.hash_function().seed() == 42);
+    REQUIRE(*map.get("one") == 1);
+  }
+}
+
+namespace {
+  template <bool Store>
+  struct CountingHash {
+    static constexpr bool store_hash = Store;
+    static inline int calls = 0;
+
+    std::size_t operator()(const std::string& key) const {
+      ++calls;
+      return HashFunction<std::string>{}(key);
+    }
+  };
+}
+
+TEST_CASE("Stored hashes spare the hasher on growth", "[hashbrown]") {
+  STATIC_REQUIRE(HashBrown<std::string, int>::stored_hash);
+  STATIC_REQUIRE(!HashBrown<int, int>::stored_hash);
+
+  CountingHash<true>::calls = 0;
+  auto stored = HashBrown<std::string, int, CountingHash<true>>();
+  for (int i = 0; i < 10000; ++i) {
+    stored.insert(std::to_string(i), i);
+  }
+  REQUIRE(CountingHash<true>::calls == 10000);
+
+  stored.rehash(stored.capacity() * 4);
+  for (int i = 0; i < 10000; i += 2) {
+    stored.erase(std::to_string(i));
+  }
+  REQUIRE(CountingHash<true>::calls == 15000);
+  REQUIRE(*stored.get(std::to_string(9999)) == 9999);
+
+  auto copy = stored;
+  copy.rehash(0);
+  REQUIRE(CountingHash<true>::calls == 15001);
+  REQUIRE(*copy.get(std::to_string(1)) == 1);
+
+  CountingHash<false>::calls = 0;
+  auto recomputed = HashBrown<std::string, int, CountingHash<false>>();
+  for (int i = 0; i < 10000; ++i) {
+    recomputed.insert(std::to_string(i), i);
+  }
+  REQUIRE(CountingHash<false>::calls > 10000);
+}
+
+TEST_CASE("Load factor stays below the maximum while growing", "[hashbrown]") {
+  auto map = HashBrown<int, int>();
+  REQUIRE(map.load_factor() == 0.0f);
+  REQUIRE(map.capacity() == 0);
+
+  for (int i = 0; i < 5000; ++i) {
+    map.insert(i, i);
+    REQUIRE(map.load_factor() <= map.max_load_factor());
+  }
+  REQUIRE(map.load_factor() > map.max_load_factor() / 2);
+
+  SECTION("Lowering the maximum grows the table") {
+    map.max_load_factor(0.5f);
+    REQUIRE(map.load_factor() <= 0.5f);
+    REQUIRE(*map.get(4999) == 4999);
+  }
+
+  SECTION("A maximum that would fill the table is rejected") {
+    REQUIRE_THROWS_AS(map.max_load_factor(1.0f), std::invalid_argument);
+    REQUIRE_THROWS_AS(map.max_load_factor(0.0f), std::invalid_argument);
+  }
+}
+
+TEST_CASE("Reserving up front avoids any rehash", "[hashbrown]") {
+  auto map = HashBrown<int, int>();
+  map.reserve(0);
+  REQUIRE(map.capacity() == 0);
+
+  map.reserve(10000);
+  const auto capacity = map.capacity();
+  REQUIRE(capacity >= 10000);
+
+  for (int i = 0; i < 10000; ++i) {
+    map.insert(i, i);
+  }
+  REQUIRE(map.capacity() == capacity);
+
+  SECTION("Rehash to zero shrinks to fit") {
+    for (int i = 0; i < 9900; ++i) {
+      map.erase(i);
+    }
+    map.rehash(0);
+    REQUIRE(map.capacity() < capacity);
+    REQUIRE(map.size() == 100);
+    REQUIRE(*map.get(9999) == 9999);
+  }
+}
+
+TEST_CASE("Incremental rehashing keeps every element reachable", "[hashbrown]") {
+  auto map = HashBrown<int, std::string>();
+  map.incremental_rehash(true);
+  REQUIRE(map.incremental_rehash());
+
+  bool saw_migration = false;
+  for (int i = 0; i < 5000; ++i) {
+    map.insert(i, std::to_string(i));
+    if (map.rehashing()) {
+      saw_migration = true;
+      REQUIRE(map.contains(0));
+      REQUIRE(*map.get(i) == std::to_string(i));
+    }
+  }
+  REQUIRE(saw_migration);
+  REQUIRE(map.size() == 5000);
+
+  while (!map.rehashing()) {
+    const int key = static_cast<int>(map.size());
+    map.insert(key, std::to_string(key));
+  }
+  const auto total = map.size();
+
+  SECTION("Lookups and iteration see both tables") {
+    REQUIRE(std::distance(map.begin(), map.end()) == static_cast<std::ptrdiff_t>(total));
+    for (int i = 0; i < static_cast<int>(total); ++i) {
+      REQUIRE(*map.get(i) == std::to_string(i));
+    }
+  }
+
+  SECTION("Erasing and overwriting work on entries not moved yet") {
+    map.insert(1, "uno");
+    REQUIRE(*map.get(1) == "uno");
+    map.erase(2);
+    REQUIRE_FALSE(map.contains(2));
+    REQUIRE(map.size() == total - 1);
+  }
+
+  SECTION("Copies taken mid-migration are complete") {
+    auto copy = map;
+    REQUIRE(copy.size() == total);
+    REQUIRE(*copy.get(0) == "0");
+    copy.insert(-1, "minus one");
+    copy.erase(0);
+    REQUIRE(copy.size() == total);
+    REQUIRE(map.size() == total);
+
+    // With an identity hash the keys below sit in the upper half of a
+    // 64-slot table and the lower half holds only tombstones, so erasing the
+    // key that started the migration leaves the new table allocated but
+    // empty while the old one still holds every entry.
+    struct IdentityHash {
+      std::size_t operator()(std::uint64_t key) const { return key; }
+    };
+    auto sparse = HashBrown<std::uint64_t, int, IdentityHash>();
+    sparse.reserve(40);
+    sparse.incremental_rehash(true);
+    REQUIRE(sparse.capacity() == 64);
+    for (std::uint64_t key = 256; key < 280; ++key) {
+      sparse.insert(key, 1);
+    }
+    for (const std::uint64_t first : {0, 128}) {
+      for (auto key = first; key < first + 16; ++key) {
+        sparse.insert(key, 1);
+      }
+      for (auto key = first; key < first + 16; ++key) {
+        sparse.erase(key);
+      }
+    }
+    REQUIRE_FALSE(sparse.rehashing());
+    sparse.insert(280, 1);
+    REQUIRE(sparse.rehashing());
+    sparse.erase(280);
+
+    auto sparse_copy = sparse;
+    REQUIRE(sparse_copy.rehashing());
+    REQUIRE(sparse_copy.size() == 24);
+    sparse_copy.insert(1000, 2);
+    sparse_copy.erase(256);
+    REQUIRE(sparse_copy.size() == 24);
+    REQUIRE(*sparse_copy.get(1000) == 2);
+    REQUIRE(*sparse_copy.get(279) == 1);
+  }
+
+  SECTION("Merging into a migrating map keeps migrating") {
+    auto source = HashBrown<int, std::string>();
+    for (int i = 0; i < 100000; ++i) {
+      source.insert(1000000 + i, std::to_string(i));
+    }
+    map.merge(source);
+    REQUIRE(source.empty());
+    REQUIRE(map.size() == total + 100000);
+    REQUIRE(*map.get(0) == "0");
+    REQUIRE(*map.get(1099999) == "99999");
+  }
+
+  SECTION("Disabling finishes the migration") {
+    map.incremental_rehash(false);
+    REQUIRE_FALSE(map.rehashing());
+    REQUIRE(map.size() == total);
+    REQUIRE(*map.get(0) == "0");
+  }
+}
+
+TEST_CASE("Parallel inserts build the same map as serial ones", "[hashbrown][parallel]") {
+  // Crowds the keys into a few thousand home groups, so many probe
+  // sequences run into the next partition's slice of the table.
+  struct ClusteredHash {
+    std::size_t operator()(const std::string& key) const {
+      return HashFunction<std::string>{}(key) & ((std::size_t{1} << 19) - 1);
+    }
+  };
+  using Map = HashBrown<std::string, int, ClusteredHash>;
+
+  std::vector<std::pair<std::string, int>> entries;
+  for (int i = 0; i < 300000; ++i) {
+    // Every key appears twice, so the later value has to win.
+    entries.emplace_back("key:" + std::to_string(i % 150000), i);
+  }
+
+  auto serial = Map();
+  serial.insert(entries.begin(), entries.end());
+
+  auto parallel = Map();
+  for (int i = 0; i < 1000; ++i) {
+    parallel.insert("old:" + std::to_string(i), i);
+  }
+  for (int i = 0; i < 1000; i += 2) {
+    parallel.erase("old:" + std::to_string(i));
+  }
+  parallel.insert(hashbrown::Parallel{8}, entries.begin(), entries.end());
+
+  REQUIRE(parallel.size() == serial.size() + 500);
+  for (const auto& [key, value] : serial) {
+    const auto found = parallel.get(key);
+    REQUIRE(found != nullptr);
+    REQUIRE(*found == value);
+  }
+  for (int i = 0; i < 1000; ++i) {
+    REQUIRE(parallel.contains("old:" + std::to_string(i)) == (i % 2 != 0));
+  }
+
+  std::size_t visited = 0;
+  for ([[maybe_unused]] const auto& entry : parallel) {
+    ++visited;
+  }
+  REQUIRE(visited == parallel.size());
+
+  SECTION("Small ranges are inserted serially") {
+    auto small = Map();
+    small.insert(hashbrown::Parallel{8}, entries.begin(), entries.begin() + 100);
+    REQUIRE(small.size() == 100);
+  }
+}
+
+TEST_CASE("Parallel inserts move from move iterators", "[hashbrown][parallel]") {
+  std::vector<std::pair<int, std::unique_ptr<int>>> entries;
+  for (int i = 0; i < 200000; ++i) {
+    // The last tenth repeats earlier keys, which have to take the later value.
+    const int key = i < 180000 ? i : i - 180000;
+    entries.emplace_back(key, std::make_unique<int>(i));
+  }
+
+  auto map = HashBrown<int, std::unique_ptr<int>>();
+  map.insert(hashbrown::Parallel{4}, std::make_move_iterator(entries.begin()), std::make_move_iterator(entries.end()));
+
+  REQUIRE(map.size() == 180000);
+  for (int key = 0; key < 180000; ++key) {
+    const auto found = map.get(key);
+    REQUIRE(found != nullptr);
+    REQUIRE(**found == (key < 20000 ? key + 180000 : key));
+  }
+  REQUIRE(std::all_of(entries.begin(), entries.end(), [](const auto& entry) { return entry.second == nullptr; }));
+}
+
+TEST_CASE("Parallel scans visit every entry once", "[hashbrown][parallel]") {
+  auto map = HashBrown<std::uint64_t, std::uint64_t>();
+  map.incremental_rehash(true);
+  std::uint64_t next = 0;
+  for (; next < 400000; ++next) {
+    map.insert(next, next);
+  }
+  for (std::uint64_t i = 0; i < next; i += 3) {
+    map.erase(i);
+  }
+  for (; !map.rehashing(); ++next) {
+    map.insert(next, next);
+  }
+
+  std::uint64_t expected = 0;
+  for (const auto& [key, value] : map) {
+    expected += value;
+  }
+
+  SECTION("for_each reaches entries in both tables") {
+    map.for_each(hashbrown::Parallel{8}, [](auto& entry) { entry.second *= 2; });
+    for (const auto& [key, value] : map) {
+      REQUIRE(value == 2 * key);
+    }
+
+    std::atomic<std::size_t> visited{0};
+    std::as_const(map).for_each(hashbrown::Parallel{8}, [&](const auto&) { ++visited; });
+    REQUIRE(visited == map.size());
+  }
+
+  SECTION("transform_reduce matches a serial fold") {
+    const auto sum = map.transform_reduce(hashbrown::Parallel{8}, std::uint64_t{0}, std::plus<>(),
+                                          [](const auto& entry) { return entry.second; });
+    REQUIRE(sum == expected);
+
+    const auto count = map.transform_reduce(hashbrown::Parallel{}, std::size_t{0}, std::plus<>(),
+                                            [](const auto&) { return std::size_t{1}; });
+    REQUIRE(count == map.size());
+  }
+
+  SECTION("Empty and small maps are scanned serially") {
+    auto empty = HashBrown<std::uint64_t, std::uint64_t>();
+    REQUIRE(empty.transform_reduce(hashbrown::Parallel{8}, 7, std::plus<>(), [](const auto&) { return 1; }) == 7);
+
+    auto small = HashBrown<std::uint64_t, std::uint64_t>{{1, 10}, {2, 20}};
+    REQUIRE(small.transform_reduce(hashbrown::Parallel{8}, std::uint64_t{1}, std::plus<>(),
+                                   [](const auto& entry) { return entry.second; }) == 31);
+  }
+}
+
+TEST_CASE("Batched lookups agree with single lookups", "[hashbrown]") {
+  auto map = HashBrown<int, int>();
+  map.incremental_rehash(true);
+  int next = 0;
+  for (; next < 5000 || !map.rehashing(); next += 2) {
+    map.insert(next, -next);
+  }
+
+  std::vector<int> keys;
+  for (int i = 0; i < 1000; ++i) {
+    keys.push_back((i * 7) % (next + 1000));
+  }
+  std::vector<const int*> out(keys.size());
+  map.get_many(keys, out);
+
+  for (std::size_t i = 0; i < keys.size(); ++i) {
+    REQUIRE(out[i] == map.get(keys[i]));
+  }
+
+  SECTION("Transparent keys can be batched too") {
+    auto strings = HashBrown<std::string, int>{{"one", 1}, {"two", 2}};
+    const std::vector<std::string_view> views = {"two", "three", "one"};
+    std::vector<const int*> found(views.size());
+    strings.get_many(views, found);
+    REQUIRE(*found[0] == 2);
+    REQUIRE(found[1] == nullptr);
+    REQUIRE(*found[2] == 1);
+  }
+
+  SECTION("Tables too big for the cache are prefetched") {
+    auto big = HashBrown<int, int>();
+    for (int i = 0; i < (1 << 20); ++i) {
+      big.insert(i, i);
+    }
+    std::vector<int> probes;
+    for (int i = 0; i < 4096; ++i) {
+      probes.push_back(i * 613 - 4096);
+    }
+    std::vector<const int*> found(probes.size());
+    big.get_many(probes, found);
+    for (std::size_t i = 0; i < probes.size(); ++i) {
+      REQUIRE(found[i] == big.get(probes[i]));
+    }
+  }
+
+  SECTION("The output has to fit every key") {
+    std::vector<const int*> small(10);
+    REQUIRE_THROWS_AS(map.get_many(keys, small), std::invalid_argument);
+  }
+}
+
+TEST_CASE("Snapshots are mapped back without rebuilding", "[snapshot]") {
+  const auto path = std::filesystem::temp_directory_path() / ("hashbrown_snapshot_" + std::to_string(::getpid()));
+
+  auto map = HashBrown<std::uint64_t, std::uint64_t>();
+  map.incremental_rehash(true);
+  for (std::uint64_t i = 0; i < 20000; ++i) {
+    map.insert(i * 1024, i);
+  }
+  for (std::uint64_t i = 0; i < 20000; i += 3) {
+    map.erase(i * 1024);
+  }
+  map.save(path);
+
+  std::uint64_t view_capacity = 0;
+  {
+    const auto view = HashBrownView<std::uint64_t, std::uint64_t>(path);
+    REQUIRE(view.size() == map.size());
+    REQUIRE(view.capacity() <= map.capacity());
+    for (std::uint64_t i = 0; i < 20000; ++i) {
+      const auto value = view.get(i * 1024);
+      if (i % 3 == 0) {
+        REQUIRE(value == nullptr);
+      } else {
+        REQUIRE(value != nullptr);
+        REQUIRE(*value == i);
+      }
+    }
+    REQUIRE(!view.contains(1));
+    view_capacity = view.capacity();
+  }
+
+  SECTION("Seeded hashers travel with the snapshot") {
+    using Seeded = HashBrown<std::uint64_t, std::uint64_t>;
+    auto seeded = Seeded(HashFunction<std::uint64_t>{1234});
+    seeded.insert(7, 49);
+    seeded.save(path);
+    const auto view = HashBrownView<std::uint64_t, std::uint64_t>(path);
+    REQUIRE(*view.get(7) == 49);
+  }
+
+  SECTION("Snapshots of another type or a damaged file are refused") {
+    REQUIRE_THROWS_AS((HashBrownView<std::uint32_t, std::uint64_t>(path)), std::runtime_error);
+
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) / 2);
+    REQUIRE_THROWS_AS((HashBrownView<std::uint64_t, std::uint64_t>(path)), std::runtime_error);
+    REQUIRE_THROWS_AS((HashBrownView<std::uint64_t, std::uint64_t>(path.string() + ".missing")), std::system_error);
+  }
+
+  SECTION("Control bytes placed outside the data are refused") {
+    using hashbrown::detail::SnapshotHeader;
+    const auto patch = [&](std::uint64_t ctrl_offset) {
+      std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+      file.seekp(offsetof(SnapshotHeader, ctrl_offset));
+      file.write(reinterpret_cast<const char*>(&ctrl_offset), sizeof(ctrl_offset));
+    };
+
+    // Wraps around so that ctrl_offset + capacity lands before the slots.
+    patch(std::numeric_limits<std::uint64_t>::max() - view_capacity + 1);
+    REQUIRE_THROWS_AS((HashBrownView<std::uint64_t, std::uint64_t>(path)), std::runtime_error);
+
+    // Would read the control bytes out of the header itself.
+    patch(0);
+    REQUIRE_THROWS_AS((HashBrownView<std::uint64_t, std::uint64_t>(path)), std::runtime_error);
+  }
+
+  std::filesystem::remove(path);
+}
+
+namespace {
+  enum class Opcode { Add, Sub, Mul, Div, Load, Store, Jump, Halt };
+
+  constexpr auto opcodes = make_frozen_hashbrown<std::string_view, Opcode>({
+    {"add", Opcode::Add}, {"sub", Opcode::Sub}, {"mul", Opcode::Mul}, {"div", Opcode::Div},
+    {"load", Opcode::Load}, {"store", Opcode::Store}, {"jump", Opcode::Jump}, {"halt", Opcode::Halt},
+  });
+
+  constexpr auto squares = [] {
+    std::pair<std::uint64_t, std::uint64_t> entries[100]{};
+    for (std::uint64_t i = 0; i < 100; ++i) {
+      entries[i] = {i * 1024, i * i};
+    }
+    return make_frozen_hashbrown(entries);
+  }();
+}
+
+TEST_CASE("Frozen maps are built during constant evaluation", "[frozen]") {
+  STATIC_REQUIRE(opcodes.size() == 8);
+  STATIC_REQUIRE(*opcodes.get("store") == Opcode::Store);
+  STATIC_REQUIRE(opcodes.get("nop") == nullptr);
+  STATIC_REQUIRE(!opcodes.contains(""));
+  STATIC_REQUIRE(*squares.get(99 * 1024) == 99 * 99);
+  STATIC_REQUIRE(!squares.contains(1));
+
+  const std::string name = "jump";
+  REQUIRE(*opcodes.get(name) == Opcode::Jump);
+
+  std::size_t visited = 0;
+  for (const auto& [key, square] : squares) {
+    REQUIRE(key % 1024 == 0);
+    REQUIRE(square == (key / 1024) * (key / 1024));
+    ++visited;
+  }
+  REQUIRE(visited == squares.size());
+
+  std::pair<int, int> duplicates[] = {{1, 1}, {2, 2}, {1, 3}};
+  REQUIRE_THROWS_AS(make_frozen_hashbrown(duplicates), std::invalid_argument);
+}
+
+TEST_CASE("Freezing a map keeps every entry and empties the source", "[frozen]") {
+  auto map = HashBrown<std::string, std::uint64_t>();
+  map.incremental_rehash(true);
+  for (std::uint64_t i = 0; i < 20000; ++i) {
+    map.insert("key:" + std::to_string(i), i);
+  }
+  for (std::uint64_t i = 0; i < 20000; i += 5) {
+    map.erase("key:" + std::to_string(i));
+  }
+  const auto expected = map.size();
+
+  const auto frozen = std::move(map).freeze();
+  REQUIRE(map.empty());
+  REQUIRE(frozen.size() == expected);
+  for (std::uint64_t i = 0; i < 20000; ++i) {
+    const auto value = frozen.get("key:" + std::to_string(i));
+    if (i % 5 == 0) {
+      REQUIRE(value == nullptr);
+    } else {
+      REQUIRE(value != nullptr);
+      REQUIRE(*value == i);
+    }
+  }
+  REQUIRE(frozen.contains(std::string_view{"key:19999"}));
+  REQUIRE(!frozen.contains("missing"));
+
+  std::size_t visited = 0;
+  for (const auto& [key, value] : frozen) {
+    REQUIRE(key == "key:" + std::to_string(value));
+    ++visited;
+  }
+  REQUIRE(visited == expected);
+
+  SECTION("Small and empty maps freeze too") {
+    auto small = HashBrown<std::uint64_t, std::uint64_t>{{1, 10}, {2, 20}};
+    const auto frozen_small = std::move(small).freeze();
+    REQUIRE(*frozen_small.get(2) == 20);
+    REQUIRE(!frozen_small.contains(3));
+
+    const auto frozen_empty = HashBrown<std::uint64_t, std::uint64_t>().freeze();
+    REQUIRE(frozen_empty.empty());
+    REQUIRE(frozen_empty.get(1) == nullptr);
+  }
+
+  SECTION("Keys with equal full hashes freeze too") {
+    // Only 64 distinct hashes for 1000 keys, so no seed separates them.
+    struct FewHashes {
+      constexpr std::size_t operator()(std::uint64_t key) const { return key % 64; }
+    };
+    auto crowded = HashBrown<std::uint64_t, std::uint64_t, FewHashes>();
+    for (std::uint64_t i = 0; i < 1000; ++i) {
+      crowded.insert(i, i * 3);
+    }
+    const auto frozen_crowded = std::move(crowded).freeze();
+    REQUIRE(frozen_crowded.size() == 1000);
+    for (std::uint64_t i = 0; i < 1000; ++i) {
+      REQUIRE(*frozen_crowded.get(i) == i * 3);
+    }
+    REQUIRE(!frozen_crowded.contains(1000));
+    REQUIRE(!frozen_crowded.contains(1063));
+
+    std::size_t crowded_visited = 0;
+    for (const auto& [key, value] : frozen_crowded) {
+      REQUIRE(value == key * 3);
+      ++crowded_visited;
+    }
+    REQUIRE(crowded_visited == 1000);
+
+    std::pair<std::uint64_t, int> colliding[] = {{1, 1}, {65, 2}};
+    REQUIRE_THROWS_AS((make_frozen_hashbrown<std::uint64_t, int, FewHashes>(colliding)), std::invalid_argument);
+  }
+}
+
+TEST_CASE("Small maps stay inline until they outgrow their capacity", "[small]") {
+  // Every allocation from this resource throws, so anything that reaches
+  // the heap fails the test.
+  using Small = hashbrown::pmr::SmallHashBrown<std::uint64_t, std::uint64_t, 8>;
+  auto map = Small(std::pmr::null_memory_resource());
+  for (std::uint64_t i = 0; i < 8; ++i) {
+    map.insert(i, i * i);
+  }
+  map.insert(3, 333);
+  map.emplace(4, 444);
+  REQUIRE(map.is_inline());
+  REQUIRE(map.size() == 8);
+  REQUIRE(*map.get(3) == 333);
+  REQUIRE(*map.get(4) == 444);
+  REQUIRE(!map.contains(8));
+
+  REQUIRE(map.erase(0) != map.end());
+  REQUIRE(map.erase(0) == map.end());
+  map.insert(100, 1);
+  REQUIRE(map.size() == 8);
+
+  std::size_t visited = 0;
+  for (const auto& [key, value] : map) {
+    REQUIRE(*map.get(key) == value);
+    ++visited;
+  }
+  REQUIRE(visited == 8);
+
+  const auto copy = map;
+  REQUIRE(copy.is_inline());
+  REQUIRE(*copy.get(100) == 1);
+
+  REQUIRE_THROWS_AS(map.insert(9, 81), std::bad_alloc);
+}
+
+TEST_CASE("Small maps move to a hashed table when they grow", "[small]") {
+  auto map = SmallHashBrown<std::string, int, 4>();
+  for (int i = 0; i < 4; ++i) {
+    map.insert("key:" + std::to_string(i), i);
+  }
+  REQUIRE(map.is_inline());
+  REQUIRE(*map.get(std::string_view{"key:2"}) == 2);
+
+  for (int i = 4; i < 100; ++i) {
+    map.insert("key:" + std::to_string(i), i);
+  }
+  REQUIRE(!map.is_inline());
+  REQUIRE(map.size() == 100);
+  for (int i = 0; i < 100; ++i) {
+    REQUIRE(*map.get("key:" + std::to_string(i)) == i);
+  }
+
+  SECTION("Erasing while iterating visits every entry once") {
+    auto small = SmallHashBrown<int, int, 8>{{1, 1}, {2, 2}, {3, 3}, {4, 4}, {5, 5}};
+    std::size_t visited = 0;
+    for (auto it = small.begin(); it != small.end();) {
+      ++visited;
+      it = it->first % 2 == 0 ? small.erase(it->first) : std::next(it);
+    }
+    REQUIRE(visited == 5);
+    REQUIRE(small.size() == 3);
+    REQUIRE(!small.contains(2));
+    REQUIRE(small.contains(5));
+  }
+
+  SECTION("Moves carry either representation") {
+    auto moved = std::move(map);
+    REQUIRE(moved.size() == 100);
+    REQUIRE(map.empty());
+
+    auto small = SmallHashBrown<std::string, int, 4>{{"a", 1}};
+    auto other = std::move(small);
+    REQUIRE(*other.get("a") == 1);
+    REQUIRE(small.empty());
+  }
+
+  SECTION("Clearing returns to inline storage") {
+    map.clear();
+    REQUIRE(map.empty());
+    REQUIRE(map.is_inline());
+    map.reserve(50);
+    REQUIRE(!map.is_inline());
+  }
+}
+
+TEST_CASE("Stats describe the table and count its events", "[stats]") {
+  auto map = HashBrown<std::uint64_t, std::uint64_t>();
+  auto empty = map.stats();
+  REQUIRE(empty.size == 0);
+  REQUIRE(empty.allocated_bytes == 0);
+  REQUIRE(empty.mean_probe_length() == 0.0);
+
+  for (std::uint64_t i = 0; i < 1000; ++i) {
+    map.insert(i, i);
+  }
+  for (std::uint64_t i = 0; i < 1000; i += 2) {
+    map.erase(i);
+  }
+  for (std::uint64_t i = 0; i < 100; ++i) {
+    map.get(i);
+  }
+
+  const auto stats = map.stats();
+  REQUIRE(stats.size == 500);
+  REQUIRE(stats.capacity == map.capacity());
+  REQUIRE(stats.mean_probe_length() >= 1.0);
+
+  std::size_t probed = 0;
+  for (const auto count : stats.probe_lengths) {
+    probed += count;
+  }
+  REQUIRE(probed == 500);
+
+  std::size_t groups = 0;
+  std::size_t full = 0;
+  for (std::size_t i = 0; i < stats.group_occupancy.size(); ++i) {
+    groups += stats.group_occupancy[i];
+    full += i * stats.group_occupancy[i];
+  }
+  REQUIRE(groups * 16 == stats.capacity);
+  REQUIRE(full == 500);
+  REQUIRE(stats.bytes_per_entry * 500 == Approx(stats.allocated_bytes));
+
+  if (stats.instrumented) {
+    REQUIRE(stats.hits == 50);
+    REQUIRE(stats.misses == 50);
+    REQUIRE(stats.resizes > 0);
+  } else {
+    REQUIRE(stats.hits == 0);
+    REQUIRE(stats.resizes == 0);
+  }
+
+  const auto json = stats.to_json();
+  REQUIRE(json.front() == '{');
+  REQUIRE(json.back() == '}');
+  REQUIRE(json.find("\"size\":500") != std::string::npos);
+  REQUIRE(json.find("\"probe_lengths\":[") != std::string::npos);
+}
+
+TEST_CASE("Cuckoo maps find every key in one of two buckets", "[cuckoo]") {
+  auto map = CuckooHashBrown<std::string, int>();
+  for (int i = 0; i < 100000; ++i) {
+    map.insert(std::to_string(i), i);
+  }
+  REQUIRE(map.size() == 100000);
+  REQUIRE(map.load_factor() <= map.max_load_factor());
+  for (int i = 0; i < 100000; ++i) {
+    REQUIRE(*map.get(std::to_string(i)) == i);
+  }
+  REQUIRE(map.get("absent") == nullptr);
+  REQUIRE(map.contains(std::string_view{"99999"}));
+
+  std::size_t visited = 0;
+  for (const auto& [key, value] : map) {
+    REQUIRE(key == std::to_string(value));
+    ++visited;
+  }
+  REQUIRE(visited == map.size());
+
+  SECTION("Erasing keeps the rest reachable") {
+    for (int i = 0; i < 100000; i += 2) {
+      map.erase(std::to_string(i));
+    }
+    REQUIRE(map.size() == 50000);
+    for (int i = 0; i < 100000; ++i) {
+      REQUIRE(map.contains(std::to_string(i)) == (i % 2 != 0));
+    }
+  }
+
+  SECTION("Copies keep every entry") {
+    const auto copy = map;
+    REQUIRE(copy.size() == map.size());
+    REQUIRE(copy.stash_size() == map.stash_size());
+    for (const auto& [key, value] : map) {
+      REQUIRE(*copy.get(key) == value);
+    }
+  }
+}
+
+TEST_CASE("Cuckoo maps stash what their buckets cannot hold", "[cuckoo]") {
+  // Every key shares one hash, so two buckets and the stash are all the
+  // room there is.
+  struct SameHash {
+    std::size_t operator()(int) const { return 42; }
+  };
+  auto map = CuckooHashBrown<int, int, SameHash>();
+  for (int i = 0; i < 16; ++i) {
+    map.insert(i, i);
+  }
+  REQUIRE(map.stash_size() == 8);
+  for (int i = 0; i < 16; ++i) {
+    REQUIRE(*map.get(i) == i);
+  }
+
+  REQUIRE_THROWS_AS(map.insert(16, 16), std::overflow_error);
+  REQUIRE(map.size() == 16);
+
+  map.erase(3);
+  map.insert(16, 16);
+  REQUIRE(*map.get(16) == 16);
+  REQUIRE(map.get(3) == nullptr);
+}
+
+TEST_CASE("Robin Hood maps churn without tombstones or rebuilds", "[robinhood]") {
+  auto map = RobinHoodHashBrown<std::string, int>();
+  map.reserve(4096);
+  const auto capacity = map.capacity();
+
+  // Far more erases than the table has slots, never holding more than the
+  // reserved count.
+  for (int i = 0; i < 200000; ++i) {
+    map.insert(std::to_string(i), i);
+    if (i >= 4096) {
+      map.erase(std::to_string(i - 4096));
+      REQUIRE(map.size() == 4096);
+    }
+  }
+  REQUIRE(map.capacity() == capacity);
+  REQUIRE(map.max_probe_length() < 64);
+  for (int i = 200000 - 4096; i < 200000; ++i) {
+    REQUIRE(*map.get(std::to_string(i)) == i);
+  }
+  REQUIRE(map.get("0") == nullptr);
+  REQUIRE(map.get(std::string_view{"199999"}) != nullptr);
+
+  SECTION("Erasing an absent key changes nothing") {
+    REQUIRE(map.erase("absent") == map.end());
+    REQUIRE(map.size() == 4096);
+  }
+
+  SECTION("Copies keep every entry") {
+    const auto copy = map;
+    REQUIRE(copy.size() == map.size());
+    for (const auto& [key, value] : map) {
+      REQUIRE(*copy.get(key) == value);
+    }
+  }
+}
+
+TEST_CASE("Robin Hood maps can erase while iterating", "[robinhood]") {
+  auto map = RobinHoodHashBrown<int, int>();
+  for (int i = 0; i < 5000; ++i) {
+    map.insert(i, i * 2);
+  }
+
+  std::vector<int> visited;
+  for (auto it = map.begin(); it != map.end();) {
+    visited.push_back(it->first);
+    if (it->first % 2 == 0) {
+      it = map.erase(it->first);
+    } else {
+      ++it;
+    }
+  }
+  std::sort(visited.begin(), visited.end());
+  REQUIRE(visited.size() == 5000);
+  REQUIRE(std::adjacent_find(visited.begin(), visited.end()) == visited.end());
+
+  REQUIRE(map.size() == 2500);
+  for (int i = 0; i < 5000; ++i) {
+    REQUIRE(map.contains(i) == (i % 2 != 0));
+  }
+
+  map.insert(1, 7);
+  REQUIRE(*map.get(1) == 7);
+  REQUIRE(map.size() == 2500);
+}
+
+TEST_CASE("Dense maps iterate in insertion order", "[dense]") {
+  auto map = DenseHashBrown<int, std::string>();
+  std::vector<int> expected;
+  for (int i = 0; i < 1000; ++i) {
+    const auto key = (i * 7919) % 1000;
+    map.insert(key, std::to_string(key));
+    expected.push_back(key);
+  }
+
+  std::vector<int> keys;
+  for (const auto& [key, value] : map) {
+    REQUIRE(value == std::to_string(key));
+    keys.push_back(key);
+  }
+  REQUIRE(keys == expected);
+
+  SECTION("Overwriting keeps the original position") {
+    map.insert(expected[3], "again");
+    REQUIRE(std::next(map.begin(), 3)->second == "again");
+    REQUIRE(map.size() == 1000);
+  }
+
+  SECTION("Erasing keeps the order of the rest") {
+    for (int i = 0; i < 1000; i += 3) {
+      map.erase(expected[i]);
+    }
+    std::vector<int> remaining;
+    for (int i = 0; i < 1000; ++i) {
+      if (i % 3 != 0) {
+        remaining.push_back(expected[i]);
+      }
+    }
+
+    keys.clear();
+    for (const auto& entry : map) {
+      keys.push_back(entry.first);
+    }
+    REQUIRE(keys == remaining);
+    REQUIRE(map.size() == remaining.size());
+  }
+}
+
+TEST_CASE("Dense maps reuse erased space without losing elements", "[dense]") {
+  auto map = DenseHashBrown<int, int>();
+  map.reserve(64);
+  const auto capacity = map.capacity();
+
+  // Churn through many more keys than fit, never holding more than 32.
+  for (int i = 0; i < 10000; ++i) {
+    map.insert(i, i);
+    if (i >= 32) {
+      REQUIRE(map.erase(i - 32) != map.end());
+    }
+  }
+  REQUIRE(map.size() == 32);
+  REQUIRE(map.capacity() == capacity);
+  for (int i = 9968; i < 10000; ++i) {
+    REQUIRE(*map.get(int{i}) == i);
+  }
+  REQUIRE(map.get(9967) == nullptr);
+  REQUIRE(map.begin()->first == 9968);
+
+  auto copy = map;
+  map.clear();
+  REQUIRE(map.empty());
+  REQUIRE(copy.size() == 32);
+  REQUIRE(std::next(copy.begin(), 31)->first == 9999);
+}
+
+TEST_CASE("Dense maps support transparent lookups and allocators", "[dense]") {
+  auto map = DenseHashBrown<std::string, int>{{"one", 1}, {"two", 2}};
+  REQUIRE(*map.get(std::string_view{"two"}) == 2);
+  REQUIRE(map.contains("one"));
+  REQUIRE(map.erase("one") != map.end());
+  REQUIRE(map.begin()->first == "two");
+
+  std::pmr::monotonic_buffer_resource arena;
+  auto pmr_map = DenseHashBrown<int, int, HashFunction<int>, std::equal_to<>, std::pmr::polymorphic_allocator<std::pair<int, int>>>(&arena);
+  for (int i = 0; i < 100; ++i) {
+    pmr_map.insert(i, -i);
+  }
+  REQUIRE(*pmr_map.get(42) == -42);
+}
+
+TEST_CASE("Concurrent map keeps writes from every thread", "[concurrent]") {
+  auto map = ConcurrentHashBrown<int, int>(16);
+  REQUIRE(map.shard_count() == 16);
+
+  constexpr int threads = 4;
+  constexpr int per_thread = 2000;
+  std::vector<std::thread> workers;
+  for (int t = 0; t < threads; ++t) {
+    workers.emplace_back([&map, t] {
+      for (int i = 0; i < per_thread; ++i) {
+        const int key = t * per_thread + i;
+        map.insert(key, key);
+        REQUIRE(map.get(key) == key);
+      }
+    });
+  }
+  for (auto& worker : workers) {
+    worker.join();
+  }
+
+  REQUIRE(map.size() == threads * per_thread);
+  REQUIRE(map.contains(0));
+  REQUIRE_FALSE(map.get(threads * per_thread).has_value());
+
+  SECTION("Visit updates in place") {
+    REQUIRE(map.visit(5, [](int& value) { value = -5; }));
+    REQUIRE(map.get(5) == -5);
+    REQUIRE_FALSE(map.visit(-1, [](int&) {}));
+  }
+
+  SECTION("Erase reports whether the key was there") {
+    REQUIRE(map.erase(7));
+    REQUIRE_FALSE(map.erase(7));
+    REQUIRE(map.size() == threads * per_thread - 1);
+  }
+
+  SECTION("For each sees every entry") {
+    long long sum = 0;
+    map.for_each([&sum](const auto& entry) { sum += entry.second; });
+    REQUIRE(sum == static_cast<long long>(threads * per_thread) * (threads * per_thread - 1) / 2);
+  }
+}
+
+TEST_CASE("Read-mostly map publishes writes to lock-free readers", "[concurrent]") {
+  auto map = RcuHashBrown<int, int>();
+  map.insert(0, 0);
+
+  std::atomic<bool> done = false;
+  std::atomic<bool> consistent = true;
+  std::vector<std::thread> readers;
+  for (int t = 0; t < 3; ++t) {
+    readers.emplace_back([&] {
+      while (!done.load()) {
+        // Writers only ever add keys 0..n, so a snapshot must hold all of them.
+        map.read([&](const auto& snapshot) {
+          const auto n = static_cast<int>(snapshot.size());
+          if (!snapshot.contains(n - 1) || snapshot.contains(n)) {
+            consistent = false;
+          }
+        });
+      }
+    });
+  }
+
+  for (int i = 1; i < 200; ++i) {
+    map.insert(i, i * i);
+  }
+  done = true;
+  for (auto& reader : readers) {
+    reader.join();
+  }
+
+  REQUIRE(consistent);
+  REQUIRE(map.size() == 200);
+  REQUIRE(map.get(12) == 144);
+  REQUIRE_FALSE(map.get(200).has_value());
+
+  SECTION("Batched updates and erase publish new snapshots") {
+    map.update([](auto& m) {
+      m.insert(500, 1);
+      m.erase(0);
+    });
+    REQUIRE(map.contains(500));
+    REQUIRE_FALSE(map.erase(0));
+    REQUIRE(map.erase(1));
+    REQUIRE(map.size() == 199);
+  }
+
+  SECTION("Retired snapshots are freed once readers have moved on") {
+    map.insert(1000, 1);
+    hashbrown::EpochDomain::instance().collect();
+    REQUIRE(hashbrown::EpochDomain::instance().pending() == 0);
+  }
+}
+
+namespace {
+  // Built before anything else uses the epoch domain, and destroyed at exit.
+  RcuHashBrown<int, int> routes;
+}
+
+TEST_CASE("Read-mostly maps may have static storage duration", "[concurrent]") {
+  routes.insert(1, 10);
+  routes.insert(2, 20);
+  routes.erase(1);
+  REQUIRE(routes.get(2) == 20);
+  REQUIRE_FALSE(routes.contains(1));
+}
+
+namespace {
+  class CountingResource : public std::pmr::memory_resource {
+    public:
+      std::size_t allocations = 0;
+      std::size_t outstanding = 0;
+
+    private:
+      void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+        ++allocations;
+        outstanding += bytes;
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+      }
+
+      void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override {
+        outstanding -= bytes;
+        std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+      }
+
+      bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+      }
+  };
+}
+
+TEST_CASE("Dense maps free storage with the size they allocated", "[dense]") {
+  CountingResource resource;
+  {
+    using Alloc = std::pmr::polymorphic_allocator<std::pair<int, int>>;
+    auto map = DenseHashBrown<int, int, HashFunction<int>, std::equal_to<>, Alloc>(Alloc(&resource));
+    for (int i = 0; i < 100; ++i) {
+      map.insert(i, i);
+    }
+    map.max_load_factor(0.5f);
+    map.max_load_factor(0.8f);
+    REQUIRE(map.size() == 100);
+    REQUIRE(*map.get(99) == 99);
+  }
+  REQUIRE(resource.outstanding == 0);
+}
+
+TEST_CASE("Allocator-aware maps take all storage from their resource", "[hashbrown]") {
+  CountingResource resource;
+  {
+    auto map = hashbrown::pmr::HashBrown<int, std::pmr::string>(&resource);
+    for (int i = 0; i < 1000; ++i) {
+      map.insert(i, std::pmr::string(64, 'x'));
+    }
+    REQUIRE(map.get_allocator().resource() == &resource);
+    REQUIRE(resource.allocations > 0);
+    // The strings were rebuilt with the map's allocator, so their buffers count too.
+    REQUIRE(resource.outstanding >= 1000 * 64);
+    REQUIRE(map.get(999)->get_allocator().resource() == &resource);
+
+    SECTION("Moving into another resource moves element by element") {
+      CountingResource other;
+      auto moved = hashbrown::pmr::HashBrown<int, std::pmr::string>(std::move(map), &other);
+      REQUIRE(moved.size() == 1000);
+      REQUIRE(moved.get(5)->size() == 64);
+      REQUIRE(moved.get(5)->get_allocator().resource() == &other);
+      REQUIRE(map.empty());
+    }
+
+    SECTION("Copy assignment keeps the destination resource") {
+      CountingResource other;
+      auto copy = hashbrown::pmr::HashBrown<int, std::pmr::string>(&other);
+      copy = map;
+      REQUIRE(copy.get_allocator().resource() == &other);
+      REQUIRE(copy.size() == 1000);
+      REQUIRE(other.outstanding >= 1000 * 64);
+    }
+  }
+  REQUIRE(resource.outstanding == 0);
+}
+
+TEST_CASE("Maps can live on a monotonic arena", "[hashbrown]") {
+  std::pmr::monotonic_buffer_resource arena;
+  auto map = hashbrown::pmr::HashBrown<int, int>(&arena);
+  map.reserve(100);
+  for (int i = 0; i < 100; ++i) {
+    map.insert(i, -i);
+  }
+  REQUIRE(*map.get(42) == -42);
+}
+
+TEST_CASE("Sets store keys alone and combine without rehashing", "[set]") {
+  auto evens = HashBrownSet<std::string>();
+  auto threes = HashBrownSet<std::string>();
+  for (int i = 0; i < 3000; ++i) {
+    if (i % 2 == 0) {
+      REQUIRE(evens.insert(std::to_string(i)).second);
+    }
+    if (i % 3 == 0) {
+      threes.insert(std::to_string(i));
+    }
+  }
+  REQUIRE_FALSE(evens.insert("0").second);
+  REQUIRE(evens.size() == 1500);
+  REQUIRE(evens.contains(std::string_view{"42"}));
+  REQUIRE_FALSE(evens.contains("43"));
+  REQUIRE(*evens.get("42") == "42");
+
+  const auto both = evens & threes;
+  const auto either = evens | threes;
+  const auto only_evens = evens - threes;
+  for (int i = 0; i < 3000; ++i) {
+    const auto key = std::to_string(i);
+    REQUIRE(both.contains(key) == (i % 6 == 0));
+    REQUIRE(either.contains(key) == (i % 2 == 0 || i % 3 == 0));
+    REQUIRE(only_evens.contains(key) == (i % 2 == 0 && i % 3 != 0));
+  }
+  REQUIRE(both.size() == 500);
+  REQUIRE(either.size() == 2000);
+  REQUIRE(only_evens.size() == 1000);
+
+  auto in_place = evens;
+  in_place &= threes;
+  REQUIRE(in_place == both);
+  in_place |= only_evens;
+  REQUIRE(in_place == evens);
+  in_place -= threes;
+  REQUIRE(in_place == only_evens);
+  in_place -= in_place;
+  REQUIRE(in_place.empty());
+
+  std::size_t visited = 0;
+  for (const auto& key : either) {
+    REQUIRE(evens.contains(key) != (std::stoi(key) % 2 != 0));
+    ++visited;
+  }
+  REQUIRE(visited == 2000);
+}
+
+TEST_CASE("Sets take less memory than maps with dummy values", "[set]") {
+  CountingResource set_resource;
+  CountingResource map_resource;
+  auto set = hashbrown::pmr::HashBrownSet<std::uint64_t>(&set_resource);
+  auto map = hashbrown::pmr::HashBrown<std::uint64_t, bool>(&map_resource);
+  for (std::uint64_t i = 0; i < 100000; ++i) {
+    set.insert(i);
+    map.insert(i, true);
+  }
+  REQUIRE(set.capacity() == map.capacity());
+  REQUIRE(map_resource.outstanding - set_resource.outstanding
+          >= set.capacity() * (sizeof(std::pair<std::uint64_t, bool>) - sizeof(std::uint64_t)));
+
+  for (std::uint64_t i = 0; i < 100000; i += 2) {
+    set.erase(i);
+  }
+  REQUIRE(set.size() == 50000);
+  REQUIRE(set.contains(std::uint64_t{99999}));
+  REQUIRE_FALSE(set.contains(std::uint64_t{99998}));
+}
+
+TEST_CASE("Thread-local aggregation merges every thread's counts", "[aggregator]") {
+  constexpr std::size_t threads = 6;
+  auto counts = ThreadLocalAggregator<std::string, std::uint64_t>(threads);
+  REQUIRE(counts.threads() == threads);
+
+  // Thread t adds word w (w below 20000 + 1000 * t) w % 7 + 1 times, so
+  // the words overlap across threads by differing amounts.
+  const auto expected = [&](std::size_t word) {
+    std::uint64_t total = 0;
+    for (std::size_t t = 0; t < threads; ++t) {
+      total += word < 20000 + 1000 * t ? word % 7 + 1 : 0;
+    }
+    return total;
+  };
+
+  {
+    std::vector<std::jthread> workers;
+    for (std::size_t t = 0; t < threads; ++t) {
+      workers.emplace_back([&counts, t] {
+        auto& local = counts.local(t);
+        for (std::size_t w = 0; w < 20000 + 1000 * t; ++w) {
+          const auto word = "word:" + std::to_string(w);
+          for (std::size_t i = 0; i <= w % 7; ++i) {
+            local.add(std::string_view(word), 1);
+          }
+        }
+      });
+    }
+  }
+  REQUIRE(counts.local(2).map().size() == 22000);
+
+  SECTION("A parallel merge sums the counts") {
+    const auto merged = counts.merge(hashbrown::Parallel{4});
+    REQUIRE(merged.size() == 20000 + 1000 * (threads - 1));
+    for (std::size_t w = 0; w < merged.size(); ++w) {
+      const auto found = merged.get("word:" + std::to_string(w));
+      REQUIRE(found != nullptr);
+      REQUIRE(*found == expected(w));
+    }
+    for (std::size_t t = 0; t < threads; ++t) {
+      REQUIRE(counts.local(t).map().empty());
+    }
+
+    counts.local(0).add("again", 2);
+    counts.local(5).add("again", 3);
+    const auto next = counts.merge(hashbrown::Parallel{4});
+    REQUIRE(next.size() == 1);
+    REQUIRE(*next.get("again") == 5);
+  }
+
+  SECTION("A serial merge agrees") {
+    const auto merged = counts.merge(hashbrown::Parallel{1});
+    REQUIRE(merged.size() == 20000 + 1000 * (threads - 1));
+    REQUIRE(*merged.get("word:0") == threads);
+    REQUIRE(*merged.get("word:24999") == expected(24999));
+  }
+}
+
+TEST_CASE("Thread-local aggregation folds with a custom combine", "[aggregator]") {
+  struct Max {
+    int operator()(int a, int b) const {
+      return std::max(a, b);
+    }
+  };
+  auto highest = ThreadLocalAggregator<int, int, Max>(3);
+  for (int i = 0; i < 30000; ++i) {
+    highest.local(static_cast<std::size_t>(i % 3)).add(i % 10000, i);
+  }
+  const auto merged = highest.merge(hashbrown::Parallel{3});
+  REQUIRE(merged.size() == 10000);
+  for (int key = 0; key < 10000; ++key) {
+    REQUIRE(*merged.get(key) == key + 20000);
+  }
+}
+
+TEST_CASE("Thread-local aggregation moves entries through the merge", "[aggregator]") {
+  struct Append {
+    Tracked operator()(Tracked&& stored, const Tracked& value) const {
+      stored.payload.insert(stored.payload.end(), value.payload.begin(), value.payload.end());
+      return std::move(stored);
+    }
+  };
+  auto lists = ThreadLocalAggregator<int, Tracked, Append>(4);
+  for (int i = 0; i < 40000; ++i) {
+    lists.local(static_cast<std::size_t>(i % 4)).add(i % 20000, Tracked(1, i));
+  }
+
+  Tracked::copies = 0;
+  const auto merged = lists.merge(hashbrown::Parallel{4});
+  REQUIRE(Tracked::copies == 0);
+  REQUIRE(merged.size() == 20000);
+  for (int key = 0; key < 20000; ++key) {
+    REQUIRE(merged.get(key)->payload == std::vector<int>{key, key + 20000});
+  }
+}